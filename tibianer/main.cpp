@@ -1,5 +1,8 @@
 #include <cstdlib>
+#include <cstdio>
+#include <cstddef>
 #include <ctime>
+#include <new>
 #include <cmath>
 #include <iostream>
 #include <string>
@@ -30,12 +33,95 @@
 #include "tibia/Creature.hpp"
 #include "tibia/Animation.hpp"
 #include "tibia/Projectile.hpp"
+#include "tibia/CombatLog.hpp"
+#include "tibia/Profiler.hpp"
+#include "tibia/Command.hpp"
+#include "tibia/AssetLoader.hpp"
+#include "tibia/TextCache.hpp"
+#include "tibia/Transport.hpp"
+#include "tibia/Server.hpp"
+#include "tibia/MemoryTracker.hpp"
+#include "tibia/Benchmark.hpp"
+
+#ifdef TIBIA_MEMORY_TRACKING
+
+// stored in front of every allocation so delete knows what to credit back, padded to keep the alignment of malloc
+struct AllocationHeader
+{
+    std::size_t size;
+
+    int tag;
+};
+
+const std::size_t ALLOCATION_HEADER_SIZE = ((sizeof(AllocationHeader) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t)) * alignof(std::max_align_t);
+
+#endif
+
+// every heap allocation is counted so the frame loop can show how many a frame makes
+void* operator new(std::size_t size)
+{
+    tibia::MemoryTracker::add();
+
+#ifdef TIBIA_MEMORY_TRACKING
+    char* p = static_cast<char*>(std::malloc(size + ALLOCATION_HEADER_SIZE));
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(p);
+    header->size = size;
+    header->tag  = tibia::MemoryTracker::getCurrentTag();
+
+    tibia::MemoryTracker::addAllocation(header->size, header->tag);
+
+    return p + ALLOCATION_HEADER_SIZE;
+#else
+    void* p = std::malloc(size == 0 ? 1 : size);
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+#endif
+}
+
+void operator delete(void* p) noexcept
+{
+#ifdef TIBIA_MEMORY_TRACKING
+    if (p == nullptr)
+    {
+        return;
+    }
+
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(static_cast<char*>(p) - ALLOCATION_HEADER_SIZE);
+
+    tibia::MemoryTracker::removeAllocation(header->size, header->tag);
+
+    std::free(header);
+#else
+    std::free(p);
+#endif
+}
+
+// the size is in the allocation header when tracking, so the sized delete is the same as the unsized one
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
 
 std::string gameTitle = "Tibianer";
 
 std::string fileOptions = "data/options.ini";
 std::string fileSprites = "data/sprites.ini";
 
+std::string fileProfilerTrace = "trace.json";
+
+std::string fileSnapshot = "snapshot.bin";
+
 sf::Uint32 windowStyle = sf::Style::Titlebar | sf::Style::Close;
 
 int windowWidth  = 640;
@@ -45,6 +131,36 @@ bool windowIsFullscreen = false;
 
 unsigned int windowFrameRateLimit = 60;
 
+unsigned int randomSeed = 0;
+
+std::string combatLogFilename = "combat.log";
+
+bool combatLogIsBinary = false;
+
+std::string fileReplayRecord = "";
+std::string fileReplayPlay   = "";
+
+std::string fileSnapshotLoad = "";
+std::string fileSnapshotSave = "";
+
+std::string fileStatePublish  = "";
+std::string fileStateSpectate = "";
+
+int serverNumClients = 0;
+
+bool serverIsTcp = false;
+
+std::string fileBenchmark    = "";
+std::string fileBenchmarkMap = "maps/benchmark.xml";
+
+int benchmarkScale = 1;
+
+bool isHeadless = false;
+
+unsigned int headlessNumTicks = 0;
+
+unsigned int seekTick = 0;
+
 float zoomLevel  = 1;
 float zoomFactor = 0.4;
 
@@ -77,34 +193,579 @@ void loadOptions()
     windowIsFullscreen = pt.get<bool>("Window.Fullscreen", windowIsFullscreen);
 
     windowFrameRateLimit = pt.get<unsigned int>("Window.FrameRateLimit", windowFrameRateLimit);
+
+    randomSeed = pt.get<unsigned int>("Game.RandomSeed", randomSeed);
+
+    combatLogFilename = pt.get<std::string>("CombatLog.File",   combatLogFilename);
+    combatLogIsBinary = pt.get<bool>       ("CombatLog.Binary", combatLogIsBinary);
 }
 
-int main()
+// --record file      record every command to a replay file
+// --replay file      play back a replay file, live input is ignored until it ends
+// --headless         run the simulation without windows as fast as possible
+// --ticks n          number of ticks to simulate when headless
+// --seek n           fast-forward to tick n before opening the window
+// --load-state file  start from a snapshot instead of the map's initial state
+// --save-state file  write a snapshot when the headless run ends
+// --publish file     write a state stream that a spectator can follow while it is written
+// --spectate file    draw the world from a state stream instead of simulating it
+// --clients n        run the game as a server with n scripted clients
+// --tcp              connect the scripted clients over localhost tcp instead of in memory
+// --benchmark file   run the benchmarks on a synthetic map without a window and write the results to a json file
+// --benchmark-scale n  multiply the size of the benchmark map and the number of creatures by n
+void parseArguments(int argc, char* argv[])
 {
-    std::cout << "Loading options" << std::endl;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
 
-    loadOptions();
+        bool hasValue = (i + 1 < argc);
 
-    std::cout << "Initializing random number seed" << std::endl;
-    std::srand(std::time(0));
+        if (argument == "--record" && hasValue == true)
+        {
+            fileReplayRecord = argv[++i];
+        }
+        else if (argument == "--replay" && hasValue == true)
+        {
+            fileReplayPlay = argv[++i];
+        }
+        else if (argument == "--headless")
+        {
+            isHeadless = true;
+        }
+        else if (argument == "--ticks" && hasValue == true)
+        {
+            headlessNumTicks = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--seek" && hasValue == true)
+        {
+            seekTick = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--load-state" && hasValue == true)
+        {
+            fileSnapshotLoad = argv[++i];
+        }
+        else if (argument == "--save-state" && hasValue == true)
+        {
+            fileSnapshotSave = argv[++i];
+        }
+        else if (argument == "--publish" && hasValue == true)
+        {
+            fileStatePublish = argv[++i];
+        }
+        else if (argument == "--spectate" && hasValue == true)
+        {
+            fileStateSpectate = argv[++i];
+        }
+        else if (argument == "--clients" && hasValue == true)
+        {
+            serverNumClients = std::atoi(argv[++i]);
+        }
+        else if (argument == "--tcp")
+        {
+            serverIsTcp = true;
+        }
+        else if (argument == "--benchmark" && hasValue == true)
+        {
+            fileBenchmark = argv[++i];
+
+            isHeadless = true;
+        }
+        else if (argument == "--benchmark-scale" && hasValue == true)
+        {
+            benchmarkScale = std::max(std::atoi(argv[++i]), 1);
+        }
+        else
+        {
+            std::cout << "Warning: Unknown argument: " << argument << std::endl;
+        }
+    }
+}
+
+// with a server running, the scripted clients send their commands before the server runs the tick
+void doTick(tibia::Game& game, tibia::Server& server, std::vector<std::shared_ptr<tibia::ScriptedClient>>& scriptedClientsList)
+{
+    if (serverNumClients == 0)
+    {
+        game.doTick();
+        return;
+    }
+
+    for (auto& scriptedClient : scriptedClientsList)
+    {
+        scriptedClient->doTick();
+    }
 
-    std::cout << "Creating main window" << std::endl;
+    server.doTick();
+}
 
-    if (windowIsFullscreen == true)
+bool startServer(tibia::Game& game, tibia::Server& server, std::vector<std::shared_ptr<tibia::ScriptedClient>>& scriptedClientsList, tibia::TcpTransportListener& tcpTransportListener)
+{
+    if (serverIsTcp == true)
     {
-        windowStyle |= sf::Style::Fullscreen;
+        if (tcpTransportListener.listen(sf::Socket::AnyPort) == false)
+        {
+            std::cout << "Error: Failed to listen for clients" << std::endl;
+            return false;
+        }
+
+        std::cout << "Listening for clients on port " << tcpTransportListener.getLocalPort() << std::endl;
     }
 
+    tibia::Creature* player = game.getPlayer();
+
+    tibia::Random clientsRandom(game.getRandomSeed());
+
+    for (int i = 0; i < serverNumClients; i++)
+    {
+        std::shared_ptr<tibia::Transport> serverTransport;
+        std::shared_ptr<tibia::Transport> clientTransport;
+
+        if (serverIsTcp == true)
+        {
+            std::shared_ptr<tibia::TcpTransport> tcpTransport = std::make_shared<tibia::TcpTransport>();
+
+            if (tcpTransport->connect(sf::IpAddress::LocalHost, tcpTransportListener.getLocalPort()) == false)
+            {
+                std::cout << "Error: Failed to connect client " << i + 1 << std::endl;
+                return false;
+            }
+
+            clientTransport = tcpTransport;
+
+            serverTransport = tcpTransportListener.accept();
+
+            if (serverTransport == nullptr)
+            {
+                std::cout << "Error: Failed to accept client " << i + 1 << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            std::shared_ptr<tibia::LoopbackTransport> loopbackServer;
+            std::shared_ptr<tibia::LoopbackTransport> loopbackClient;
+
+            tibia::LoopbackTransport::createPair(loopbackServer, loopbackClient);
+
+            serverTransport = loopbackServer;
+            clientTransport = loopbackClient;
+        }
+
+        int tileX = player->getX() + clientsRandom.getNumber(-8, 8);
+        int tileY = player->getY() + clientsRandom.getNumber(-8, 8);
+
+        server.addClient(serverTransport, tileX, tileY, player->getZ(), "Client " + std::to_string(i + 1));
+
+        scriptedClientsList.push_back(std::make_shared<tibia::ScriptedClient>(clientTransport, game.getRandomSeed() + i + 1));
+    }
+
+    return true;
+}
+
+// a game on the benchmark map with the player in the middle and the creatures spread around the player,
+// the area they are spread over grows with their number so the density near the player stays the same
+std::unique_ptr<tibia::Game> createBenchmarkGame(int numCreatures)
+{
+    std::unique_ptr<tibia::Game> game(new tibia::Game());
+
+    game->setRandomSeed(tibia::BENCHMARK_RANDOM_SEED);
+
+    if (game->createWindows() == false || game->loadFonts() == false || game->loadMap(fileBenchmarkMap) == false)
+    {
+        return nullptr;
+    }
+
+    game->loadObjects();
+
+    int mapSize = tibia::BENCHMARK_MAP_SIZE * benchmarkScale;
+
+    tibia::Creature* player = game->getPlayer();
+    player->setCoords(mapSize / 2, mapSize / 2);
+
+    int spread = std::min(static_cast<int>(std::sqrt(static_cast<float>(numCreatures))) * 2, mapSize);
+
+    tibia::Random random(tibia::BENCHMARK_RANDOM_SEED);
+
+    for (int i = 0; i < numCreatures; i++)
+    {
+        tibia::Game::CreaturePtr creature = std::make_shared<tibia::Creature>(0, 0, tibia::ZAxis::ground);
+        creature->setName("Creature #" + std::to_string(i + 1));
+        creature->setTeam((i % 2 == 0) ? tibia::Teams::good : tibia::Teams::evil);
+        creature->setHasOutfit(true);
+        creature->setOutfitRandom();
+        creature->setCoords
+        (
+            (mapSize / 2) + random.getNumber(-spread / 2, spread / 2),
+            (mapSize / 2) + random.getNumber(-spread / 2, spread / 2)
+        );
+
+        game->spawnCreature(creature);
+    }
+
+    // moves the spawned creatures into the lists and grids
+    game->doTick();
+
+    return game;
+}
+
+// every benchmark that changes the world gets a game of its own
+bool runBenchmarks()
+{
+    int mapSize = tibia::BENCHMARK_MAP_SIZE * benchmarkScale;
+
+    int numCreatures = tibia::BENCHMARK_NUM_CREATURES * benchmarkScale;
+
+    std::cout << "Creating benchmark map: " << fileBenchmarkMap << std::endl;
+
+    if (tibia::Benchmark::createMap(fileBenchmarkMap, mapSize, mapSize, tibia::BENCHMARK_RANDOM_SEED) == false)
+    {
+        std::cout << "Error: Failed to create benchmark map: " << fileBenchmarkMap << std::endl;
+        return false;
+    }
+
+    tibia::Benchmark benchmark;
+    benchmark.addContextValue("map_size",      std::to_string(mapSize));
+    benchmark.addContextValue("num_creatures", std::to_string(numCreatures));
+    benchmark.addContextValue("scale",         std::to_string(benchmarkScale));
+    benchmark.addContextValue("random_seed",   std::to_string(tibia::BENCHMARK_RANDOM_SEED));
+
+    std::string suffix = "/" + std::to_string(numCreatures);
+
+    {
+        benchmark.run
+        (
+            "Map::load",
+            1,
+            []()
+            {
+                tibia::Map map;
+                map.load(fileBenchmarkMap);
+            }
+        );
+
+        tibia::Map map;
+
+        if (map.load(fileBenchmarkMap) == false)
+        {
+            std::cout << "Error: Failed to load benchmark map: " << fileBenchmarkMap << std::endl;
+            return false;
+        }
+
+        benchmark.run
+        (
+            "TileMap::load",
+            mapSize * mapSize,
+            [&map, mapSize]()
+            {
+                tibia::TileMap tileMap;
+                tileMap.load(map.getChunkFile(), 0, "ground tiles", tibia::TileMapTypes::tiles, tibia::ZAxis::ground);
+
+                for (int i = 0; i < mapSize * mapSize; i++)
+                {
+                    tileMap.getTileId(i);
+                }
+            }
+        );
+    }
+
+    std::unique_ptr<tibia::Game> game = createBenchmarkGame(numCreatures);
+
+    if (game == nullptr)
+    {
+        std::cout << "Error: Failed to create benchmark game" << std::endl;
+        return false;
+    }
+
+    std::vector<sf::Vector2u> tilePositionsList;
+
+    tibia::Random random(tibia::BENCHMARK_RANDOM_SEED);
+
+    int spread = std::min(static_cast<int>(std::sqrt(static_cast<float>(numCreatures))) * 2, mapSize);
+
+    for (int i = 0; i < tibia::BENCHMARK_NUM_QUERIES; i++)
+    {
+        tilePositionsList.push_back
+        (
+            sf::Vector2u
+            (
+                ((mapSize / 2) + random.getNumber(-spread / 2, spread / 2)) * tibia::TILE_SIZE,
+                ((mapSize / 2) + random.getNumber(-spread / 2, spread / 2)) * tibia::TILE_SIZE
+            )
+        );
+    }
+
+    int numFound = 0;
+
+    benchmark.run
+    (
+        "getTileFlags",
+        tibia::BENCHMARK_NUM_QUERIES,
+        [&game, &tilePositionsList, &numFound]()
+        {
+            for (auto& tilePosition : tilePositionsList)
+            {
+                numFound += game->getTileFlags(tilePosition, tibia::ZAxis::ground) & tibia::TileFlags::solid;
+            }
+        }
+    );
+
+    benchmark.run
+    (
+        "checkTileHasCreature" + suffix,
+        tibia::BENCHMARK_NUM_QUERIES,
+        [&game, &tilePositionsList, &numFound]()
+        {
+            for (auto& tilePosition : tilePositionsList)
+            {
+                numFound += game->checkTileHasCreature(tilePosition, tibia::ZAxis::ground) != nullptr;
+            }
+        }
+    );
+
+    sf::VertexArray tileVertices(sf::Quads);
+
+    // only the vertices, into an array that is reused so it stops allocating after the warm up
+    benchmark.run
+    (
+        "addTileMapVertices",
+        tibia::TileMapTypes::numTypes,
+        [&game, &tileVertices]()
+        {
+            tibia::Map::Floor* floor = game->getMap()->getFloor(tibia::ZAxis::ground);
+
+            for (int i = 0; i < tibia::TileMapTypes::numTypes; i++)
+            {
+                if (floor->tileMaps[i].isEmpty() == true)
+                {
+                    continue;
+                }
+
+                tileVertices.clear();
+
+                game->addTileMapVertices(&floor->tileMaps[i], game->getWindowViewTileRect(), tileVertices);
+            }
+        },
+        [&game]()
+        {
+            game->updateWindowView();
+        }
+    );
+
+    // the vertices and their draw call
+    benchmark.run
+    (
+        "drawTileMap",
+        tibia::TileMapTypes::numTypes,
+        [&game]()
+        {
+            tibia::Map::Floor* floor = game->getMap()->getFloor(tibia::ZAxis::ground);
+
+            for (int i = 0; i < tibia::TileMapTypes::numTypes; i++)
+            {
+                game->drawTileMap(&floor->tileMaps[i]);
+            }
+        },
+        [&game]()
+        {
+            game->updateWindowView();
+        }
+    );
+
+    benchmark.run
+    (
+        "drawThings" + suffix,
+        1,
+        [&game]()
+        {
+            game->drawThings();
+        },
+        [&game]()
+        {
+            game->updateWindowView();
+
+            game->drawCreatures(false);
+
+            game->drawObjects();
+        }
+    );
+
+    benchmark.run
+    (
+        "updateMiniMapWindow" + suffix,
+        1,
+        [&game]()
+        {
+            game->updateMiniMapWindow();
+        },
+        [&game]()
+        {
+            game->endFrame();
+        }
+    );
+
+    // a whole frame drawn the way the main loop does, the benchmark warms every cache and buffer up
+    // so the frames drawn after it are steady-state frames, which must not touch the heap
+    sf::RenderTexture frameTarget;
+
+    if (frameTarget.create(windowWidth, windowHeight) == false)
+    {
+        std::cout << "Error: Failed to create benchmark frame target" << std::endl;
+        return false;
+    }
+
+    auto drawFrame = [&game, &frameTarget]()
+    {
+        game->drawGameWindow(&frameTarget);
+
+        game->updateMiniMapWindow();
+
+        game->drawMiniMapWindow(&frameTarget);
+
+        frameTarget.display();
+
+        game->endFrame();
+    };
+
+    benchmark.run("frame" + suffix, 1, drawFrame);
+
+    std::uint64_t numAllocationsStart = tibia::MemoryTracker::getNumAllocations();
+
+    for (int i = 0; i < tibia::BENCHMARK_NUM_FRAMES; i++)
+    {
+        drawFrame();
+    }
+
+    std::uint64_t numAllocationsFrames = tibia::MemoryTracker::getNumAllocations() - numAllocationsStart;
+
+    std::cout << "Heap allocations in " << tibia::BENCHMARK_NUM_FRAMES << " steady-state frames: " << numAllocationsFrames << std::endl;
+
+    benchmark.addContextValue("steady_state_frame_allocs", std::to_string(numAllocationsFrames));
+
+    game.reset();
+
+    game = createBenchmarkGame(numCreatures);
+
+    benchmark.run("doCreatureLogic" + suffix, numCreatures, [&game]() { game->doCreatureLogic(); });
+
+    game.reset();
+
+    game = createBenchmarkGame(numCreatures);
+
+    // the projectiles are spawned a second in the past so every tile crossing of their flight is resolved at once
+    benchmark.run
+    (
+        "updateProjectiles" + suffix,
+        tibia::BENCHMARK_NUM_PROJECTILES,
+        [&game]()
+        {
+            game->updateProjectiles();
+        },
+        [&game, &random]()
+        {
+            game->getProjectilesList()->clear();
+
+            std::vector<tibia::Game::CreaturePtr>* creaturesList = game->getCreaturesList();
+
+            for (int i = 0; i < tibia::BENCHMARK_NUM_PROJECTILES; i++)
+            {
+                tibia::Creature* creature = creaturesList->at(random.getNumber(0, creaturesList->size() - 1)).get();
+
+                int direction = random.getNumber(tibia::Directions::begin, tibia::Directions::end);
+
+                sf::Vector2f origin(creature->getTileX(), creature->getTileY());
+
+                sf::Vector2f destination
+                (
+                    origin.x + (tibia::getVectorByDirection(direction).x * tibia::TILE_SIZE),
+                    origin.y + (tibia::getVectorByDirection(direction).y * tibia::TILE_SIZE)
+                );
+
+                tibia::Game::ProjectilePtr projectile = std::make_shared<tibia::Projectile>(tibia::ProjectileTypes::arrow, direction, origin, destination);
+                projectile->setSpawnTime(game->getTime() - 1.0f);
+                projectile->setTileCoords(origin.x, origin.y);
+                projectile->setZ(creature->getZ());
+                projectile->setCreatureOwner(creature);
+
+                game->getProjectilesList()->push_back(projectile);
+            }
+        }
+    );
+
+    game.reset();
+
+    std::cout << "Found " << numFound << " solid tiles and creatures" << std::endl;
+
+    if (benchmark.saveJsonFile(fileBenchmark) == false)
+    {
+        std::cout << "Error: Failed to save benchmark results: " << fileBenchmark << std::endl;
+        return false;
+    }
+
+    std::cout << "Benchmark results saved to " << fileBenchmark << std::endl;
+
+    if (numAllocationsFrames != 0)
+    {
+        std::cout << "Error: Steady-state frames made " << numAllocationsFrames << " heap allocations" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    sf::Clock clockStartup;
+
+    std::cout << "Loading options" << std::endl;
+
+    loadOptions();
+
+    parseArguments(argc, argv);
+
     sf::RenderWindow mainWindow;
-    mainWindow.create(sf::VideoMode(windowWidth, windowHeight), gameTitle, windowStyle);
 
-    if (windowFrameRateLimit != 0)
+    if (isHeadless == false)
     {
-        mainWindow.setFramerateLimit(windowFrameRateLimit);
+        std::cout << "Creating main window" << std::endl;
+
+        if (windowIsFullscreen == true)
+        {
+            windowStyle |= sf::Style::Fullscreen;
+        }
+
+        mainWindow.create(sf::VideoMode(windowWidth, windowHeight), gameTitle, windowStyle);
+
+        if (windowFrameRateLimit != 0)
+        {
+            mainWindow.setFramerateLimit(windowFrameRateLimit);
+        }
     }
 
     tibia::Game game;
 
+    tibia::CommandStream* commandStream = game.getCommandStream();
+
+    if (fileReplayPlay.empty() == false)
+    {
+        std::cout << "Loading replay: " << fileReplayPlay << std::endl;
+        if (commandStream->loadReplay(fileReplayPlay) == false)
+        {
+            std::cout << "Error: Failed to load replay: " << fileReplayPlay << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        randomSeed = static_cast<unsigned int>(commandStream->getReplaySeed());
+    }
+
+    if (randomSeed == 0)
+    {
+        randomSeed = static_cast<unsigned int>(std::time(0));
+    }
+
+    std::cout << "Initializing random number seed: " << randomSeed << std::endl;
+    game.setRandomSeed(randomSeed);
+
     std::cout << "Loading fonts" << std::endl;
     if (game.loadFonts() == false)
     {
@@ -128,42 +789,124 @@ int main()
         (windowHeight - (windowHeight / 4)) - (loadingText.getLocalBounds().height / 2)
     );
 
-    mainWindow.clear(tibia::Colors::black);
-    mainWindow.draw(titleText);
-    mainWindow.draw(loadingText);
-    mainWindow.display();
+    if (isHeadless == false)
+    {
+        std::cout << "Creating game windows" << std::endl;
+        if (game.createWindows() == false)
+        {
+            std::cout << "Error: Failed to create game windows" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "Loading textures, sprite flags, sounds and map" << std::endl;
+
+    tibia::AssetLoader assetLoader;
+
+    game.loadAssets(&assetLoader, "maps/test.xml");
 
-    std::cout << "Creating game windows" << std::endl;
-    if (game.createWindows() == false)
+    assetLoader.start();
+
+    if (isHeadless == true)
     {
-        std::cout << "Error: Failed to create game windows" << std::endl;
-        return EXIT_FAILURE;
+        assetLoader.wait();
+    }
+    else
+    {
+        sf::RectangleShape loadingBarBackground(sf::Vector2f(windowWidth / 2, tibia::GuiData::creatureBarHeight * 4));
+        loadingBarBackground.setFillColor(tibia::Colors::black);
+        loadingBarBackground.setOutlineColor(tibia::Colors::windowBorderColor);
+        loadingBarBackground.setOutlineThickness(1);
+        loadingBarBackground.setPosition
+        (
+            (windowWidth  / 2) - (loadingBarBackground.getSize().x / 2),
+            (windowHeight / 2) - (loadingBarBackground.getSize().y / 2)
+        );
+
+        sf::RectangleShape loadingBar(loadingBarBackground.getSize());
+        loadingBar.setFillColor(tibia::Colors::yellow);
+        loadingBar.setPosition(loadingBarBackground.getPosition());
+
+        while (assetLoader.isFinished() == false)
+        {
+            assetLoader.update();
+
+            sf::Event event;
+            while (mainWindow.pollEvent(event))
+            {
+                if (event.type == sf::Event::Closed)
+                {
+                    assetLoader.wait();
+
+                    mainWindow.close();
+                    return EXIT_SUCCESS;
+                }
+            }
+
+            loadingBar.setSize
+            (
+                sf::Vector2f(loadingBarBackground.getSize().x * assetLoader.getProgress(), loadingBarBackground.getSize().y)
+            );
+
+            mainWindow.clear(tibia::Colors::black);
+            mainWindow.draw(titleText);
+            mainWindow.draw(loadingText);
+            mainWindow.draw(loadingBarBackground);
+            mainWindow.draw(loadingBar);
+            mainWindow.display();
+        }
     }
 
-    std::cout << "Loading textures" << std::endl;
-    if (game.loadTextures() == false)
+    if (assetLoader.hasFailed() == true)
     {
-        std::cout << "Error: Failed to load textures" << std::endl;
+        std::cout << "Error: Failed to load: " << assetLoader.getFailedName() << std::endl;
         return EXIT_FAILURE;
     }
 
-    std::cout << "Loading sprite flags" << std::endl;
-    game.loadSpriteFlags();
+    game.applySpriteFlags();
 
-    std::cout << "Loading sounds" << std::endl;
-    if (game.loadSounds() == false)
+    std::cout << "Building texture atlas" << std::endl;
+    if (game.loadTextureAtlas() == false)
     {
-        std::cout << "Error: Failed to load sounds" << std::endl;
+        std::cout << "Error: Failed to build texture atlas" << std::endl;
         return EXIT_FAILURE;
     }
 
-    std::cout << "Loading map" << std::endl;
-    if (game.loadMap("maps/test.xml") == false)
+    std::cout << "Loaded " << assetLoader.getNumTasks() << " assets in " << clockStartup.getElapsedTime().asSeconds() << " seconds" << std::endl;
+
+    if (fileBenchmark.empty() == false)
+    {
+        return runBenchmarks() == true ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::cout << "Opening combat log" << std::endl;
+
+    int numCombatHits  = 0;
+    int numCombatKills = 0;
+
+    if (combatLogFilename.empty() == false)
     {
-        std::cout << "Error: Failed to load map" << std::endl;
-        return EXIT_FAILURE;
+        if (game.getCombatLog()->open(combatLogFilename, combatLogIsBinary) == false)
+        {
+            std::cout << "Error: Failed to open combat log: " << combatLogFilename << std::endl;
+        }
     }
 
+    game.getCombatLog()->addSubscriber
+    (
+        [&numCombatHits, &numCombatKills](const tibia::CombatEvent& combatEvent)
+        {
+            if (combatEvent.type == tibia::CombatEventTypes::hit)
+            {
+                numCombatHits++;
+            }
+            else if (combatEvent.type == tibia::CombatEventTypes::kill)
+            {
+                numCombatKills++;
+            }
+        }
+    );
+
     std::cout << "Loading player" << std::endl;
 
     tibia::Creature* player = game.getPlayer();
@@ -284,6 +1027,159 @@ int main()
     std::cout << "Loading objects" << std::endl;
     game.loadObjects();
 
+    if (fileSnapshotLoad.empty() == false)
+    {
+        std::cout << "Loading snapshot: " << fileSnapshotLoad << std::endl;
+        if (game.loadSnapshotFile(fileSnapshotLoad) == false)
+        {
+            std::cout << "Error: Failed to load snapshot: " << fileSnapshotLoad << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        player = game.getPlayer();
+    }
+
+    tibia::StatePublisher statePublisher;
+
+    if (fileStatePublish.empty() == false)
+    {
+        std::cout << "Publishing state stream: " << fileStatePublish << std::endl;
+        if (statePublisher.open(fileStatePublish) == false)
+        {
+            std::cout << "Error: Failed to publish state stream: " << fileStatePublish << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        game.setStatePublisher(&statePublisher);
+    }
+
+    tibia::StateReader stateReader;
+
+    tibia::StateFrame stateFrame;
+
+    if (fileStateSpectate.empty() == false)
+    {
+        std::cout << "Spectating state stream: " << fileStateSpectate << std::endl;
+        if (stateReader.open(fileStateSpectate) == false)
+        {
+            std::cout << "Error: Failed to open state stream: " << fileStateSpectate << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    tibia::Server server(&game);
+
+    std::vector<std::shared_ptr<tibia::ScriptedClient>> scriptedClientsList;
+
+    tibia::TcpTransportListener tcpTransportListener;
+
+    if (serverNumClients != 0)
+    {
+        std::cout << "Starting server with " << serverNumClients << " scripted clients" << std::endl;
+        if (startServer(game, server, scriptedClientsList, tcpTransportListener) == false)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (fileReplayRecord.empty() == false)
+    {
+        std::cout << "Recording replay: " << fileReplayRecord << std::endl;
+        if (commandStream->startRecording(fileReplayRecord, game.getRandomSeed()) == false)
+        {
+            std::cout << "Error: Failed to record replay: " << fileReplayRecord << std::endl;
+        }
+    }
+
+    if (seekTick != 0)
+    {
+        std::cout << "Seeking to tick: " << seekTick << std::endl;
+
+        while (game.getTick() < seekTick)
+        {
+            doTick(game, server, scriptedClientsList);
+        }
+    }
+
+    if (isHeadless == true)
+    {
+        if (headlessNumTicks == 0)
+        {
+            headlessNumTicks = commandStream->getReplayLastTick() + 1;
+
+            if (fileReplayPlay.empty() == true)
+            {
+                headlessNumTicks = tibia::TICKS_PER_SECOND * 60;
+            }
+        }
+
+        std::cout << "Running headless for " << headlessNumTicks << " ticks" << std::endl;
+
+        sf::Clock clockHeadless;
+
+        unsigned int headlessTickStart = game.getTick();
+
+        std::uint64_t headlessNumAllocationsStart = tibia::MemoryTracker::getNumAllocations();
+
+        while (game.getTick() < headlessNumTicks)
+        {
+            doTick(game, server, scriptedClientsList);
+        }
+
+        float headlessSeconds = clockHeadless.getElapsedTime().asSeconds();
+
+        std::cout << "ticks:               " << game.getTick()                      << std::endl;
+        std::cout << "simulated time:      " << game.getTime()                      << std::endl;
+        std::cout << "real time:           " << headlessSeconds                     << std::endl;
+        std::cout << "ticks per second:    " << game.getTick() / headlessSeconds    << std::endl;
+        std::cout << "num creatures:       " << game.getCreaturesList()->size()     << std::endl;
+        std::cout << "num combat hits:     " << numCombatHits                       << std::endl;
+        std::cout << "num combat kills:    " << numCombatKills                      << std::endl;
+        std::cout << "state checksum:      " << std::hex << game.getStateChecksum() << std::dec << std::endl;
+        std::cout << "allocs per tick:     " << (tibia::MemoryTracker::getNumAllocations() - headlessNumAllocationsStart) / std::max(game.getTick() - headlessTickStart, 1u) << std::endl;
+
+        tibia::MemoryTracker::writeReport(std::cout);
+
+        if (serverNumClients != 0)
+        {
+            unsigned int numStatesReceived = 0;
+
+            int numCreaturesVisible = 0;
+
+            for (auto& scriptedClient : scriptedClientsList)
+            {
+                numStatesReceived   += scriptedClient->getNumStatesReceived();
+                numCreaturesVisible += scriptedClient->getNumCreaturesVisible();
+            }
+
+            std::cout << "server clients:      " << server.getNumClients()                                   << std::endl;
+            std::cout << "server commands:     " << server.getNumCommands()                                  << std::endl;
+            std::cout << "server dropped:      " << server.getNumCommandsDropped()                           << std::endl;
+            std::cout << "server bytes sent:   " << server.getNumBytesSent()                                 << std::endl;
+            std::cout << "client states:       " << numStatesReceived                                        << std::endl;
+            std::cout << "client interest:     " << numCreaturesVisible / std::max(serverNumClients, 1)      << std::endl;
+        }
+
+        if (statePublisher.isOpen() == true)
+        {
+            std::cout << "state stream frames: " << statePublisher.getNumFrames()       << std::endl;
+            std::cout << "state stream bytes:  " << statePublisher.getNumBytesWritten() << std::endl;
+        }
+
+        if (fileSnapshotSave.empty() == false)
+        {
+            if (game.saveSnapshotFile(fileSnapshotSave) == false)
+            {
+                std::cout << "Error: Failed to save snapshot: " << fileSnapshotSave << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            std::cout << "Snapshot saved to " << fileSnapshotSave << std::endl;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
     std::cout << "Loading game window and view" << std::endl;
 
     sf::RenderTexture* gameWindow = game.getWindow();
@@ -292,10 +1188,13 @@ int main()
 
     std::cout << "Starting main loop" << std::endl;
 
-    sf::Clock* clockGame                    = game.getClock();
-    sf::Clock* clockAnimatedWaterAndObjects = game.getClockAnimatedWaterAndObjects();
-    sf::Clock* clockCreatureLogic           = game.getClockCreatureLogic();
-    sf::Clock* clockMiniMap                 = game.getClockMiniMap();
+    sf::Clock* clockGame    = game.getClock();
+    sf::Clock* clockMiniMap = game.getClockMiniMap();
+
+    sf::Clock clockTick;
+    float tickAccumulator = 0;
+
+    tibia::Profiler* profiler = game.getProfiler();
 
     sf::Clock clockDebugInfo;
 
@@ -303,12 +1202,25 @@ int main()
     int numFrames = 0;
     int framesPerSecond = 0;
 
+    std::string textFramesPerSecond = "FPS: 0 allocs: 0";
+
+    // the most heap allocations made by a single frame during the last second
+    std::uint64_t numAllocationsFrameStart = tibia::MemoryTracker::getNumAllocations();
+    std::uint64_t numAllocationsFrameMax   = 0;
+    std::uint64_t numAllocationsFrameLast  = 0;
+
+    tibia::TextCache* textCache = game.getTextCache();
+
     bool doEnterGameAnimation = true;
 
     bool doUpdateMiniMap = true;
 
+    bool isFirstFrame = true;
+
     while (mainWindow.isOpen())
     {
+        tibia::Profiler::ScopedTimer profilerTimerFrame(profiler, tibia::ProfilerZones::frame);
+
         sf::Time elapsedTime = clockGame->getElapsedTime();
 
         sf::Time timeDebugInfo = clockDebugInfo.getElapsedTime();
@@ -316,6 +1228,7 @@ int main()
         if (timeDebugInfo.asSeconds() >= 1.0)
         {
             std::cout << "elapsed time:        " << elapsedTime.asSeconds() << std::endl;
+            std::cout << "simulated time:      " << game.getTime() << " (tick " << game.getTick() << ")" << std::endl;
 
             std::cout << "player x,y,z:        " << player->getX()     << "," << player->getY()     << "," << player->getZ() << std::endl;
             std::cout << "player tile x,y:     " << player->getTileX() << "," << player->getTileY()                          << std::endl;
@@ -329,62 +1242,73 @@ int main()
             std::cout << "num creatures:       " << game.getCreaturesList()->size()      << std::endl;
             std::cout << "num animated decals: " << game.getAnimatedDecalsList()->size() << std::endl;
 
+            std::cout << "num combat hits:     " << numCombatHits  << std::endl;
+            std::cout << "num combat kills:    " << numCombatKills << std::endl;
+
             clockDebugInfo.restart();
         }
 
         mainWindow.clear(tibia::Colors::mainWindowColor);
 
-        sf::Time timeAnimatedWaterAndObjects = clockAnimatedWaterAndObjects->getElapsedTime();
+        tickAccumulator += clockTick.restart().asSeconds();
 
-        if (timeAnimatedWaterAndObjects.asSeconds() >= 1.0)
+        if (tickAccumulator > tibia::TICK_TIME * tibia::TICKS_PER_FRAME_MAX)
         {
-            game.doAnimatedWater();
-            game.doAnimatedObjects();
-
-            clockAnimatedWaterAndObjects->restart();
+            tickAccumulator = tibia::TICK_TIME * tibia::TICKS_PER_FRAME_MAX;
         }
 
-        sf::Time timeCreatureLogic = clockCreatureLogic->getElapsedTime();
-
-        if (timeCreatureLogic.asSeconds() >= 1.0)
+        while (tickAccumulator >= tibia::TICK_TIME)
         {
-            game.doCreatureLogic();
-
-            clockCreatureLogic->restart();
-        }
-
-        game.updateAnimatedDecals();
-
-        game.updatePlayer();
-        game.updateCreatures();
-
-        game.updateObjects();
+            if (fileStateSpectate.empty() == false)
+            {
+                if (stateReader.readFrame(stateFrame) == true)
+                {
+                    game.applyStateFrame(stateFrame);
 
-        game.updateProjectiles();
+                    player = game.getPlayer();
+                }
+            }
+            else
+            {
+                doTick(game, server, scriptedClientsList);
+            }
 
-        game.updateAnimations();
+            tickAccumulator -= tibia::TICK_TIME;
+        }
 
         game.drawGameWindow(&mainWindow);
 
         if (doUpdateMiniMap == true)
         {
+            tibia::Profiler::ScopedTimer profilerTimer(profiler, tibia::ProfilerZones::updateMiniMapWindow);
+
             game.updateMiniMapWindow();
 
             doUpdateMiniMap = false;
         }
 
-        game.drawMiniMapWindow(&mainWindow);
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(profiler, tibia::ProfilerZones::drawMiniMapWindow);
+
+            game.drawMiniMapWindow(&mainWindow);
+        }
 
         sf::Time timeMiniMap = clockMiniMap->getElapsedTime();
 
         if (timeMiniMap.asSeconds() >= 0.1)
         {
+            tibia::Profiler::ScopedTimer profilerTimer(profiler, tibia::ProfilerZones::updateMiniMapWindow);
+
             game.updateMiniMapWindow();
 
             clockMiniMap->restart();
         }
 
-        game.updateSounds();
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(profiler, tibia::ProfilerZones::updateSounds);
+
+            game.updateSounds();
+        }
 
         if (doEnterGameAnimation == true)
         {
@@ -403,23 +1327,44 @@ int main()
 
             numFrames = 0;
 
+            char bufferFramesPerSecond[64];
+            std::snprintf(bufferFramesPerSecond, sizeof(bufferFramesPerSecond), "FPS: %d allocs: %llu", framesPerSecond, static_cast<unsigned long long>(numAllocationsFrameMax));
+
+            textFramesPerSecond = bufferFramesPerSecond;
+
+            numAllocationsFrameMax = 0;
+
             clockFramesPerSecond.restart();
         }
 
-        std::stringstream ssFramesPerSecond;
-        ssFramesPerSecond << "FPS: " << framesPerSecond;
+        textCache->draw(mainWindow, *game.getFontSmall(), textFramesPerSecond, tibia::FontSizes::small, tibia::Colors::pink, sf::Color::Transparent, sf::Vector2f(8, 0));
 
-        sf::Text textFramesPerSecond;
-        textFramesPerSecond.setString(ssFramesPerSecond.str());
-        textFramesPerSecond.setFont(*game.getFontSmall());
-        textFramesPerSecond.setCharacterSize(tibia::FontSizes::small);
-        textFramesPerSecond.setColor(tibia::Colors::pink);
-        textFramesPerSecond.setPosition(8, 0);
+        profiler->drawOverlay(&mainWindow, game.getFontSmall(), sf::Vector2f(8, tibia::FontSizes::small + 4));
 
-        mainWindow.draw(textFramesPerSecond);
+        if (profiler->isOverlayVisible() == true)
+        {
+            tibia::MemoryTracker::drawOverlay(&mainWindow, game.getFontSmall(), sf::Vector2f(8, tibia::FontSizes::small + 4 + ((tibia::ProfilerZones::numZones + 1) * 12) + 16), numAllocationsFrameLast);
+        }
 
         mainWindow.display();
 
+        game.endFrame();
+
+        std::uint64_t numAllocations = tibia::MemoryTracker::getNumAllocations();
+
+        numAllocationsFrameLast = numAllocations - numAllocationsFrameStart;
+
+        numAllocationsFrameMax = std::max(numAllocationsFrameMax, numAllocationsFrameLast);
+
+        numAllocationsFrameStart = numAllocations;
+
+        if (isFirstFrame == true)
+        {
+            std::cout << "Time to first frame: " << clockStartup.getElapsedTime().asSeconds() << " seconds" << std::endl;
+
+            isFirstFrame = false;
+        }
+
         sf::Event event;
         while (mainWindow.pollEvent(event))
         {
@@ -437,6 +1382,8 @@ int main()
                 {
                     zoomLevel += zoomFactor;
 
+                    if (zoomLevel > tibia::ZOOM_LEVEL_MAX) zoomLevel = tibia::ZOOM_LEVEL_MAX;
+
                     gameView->setSize(sf::Vector2f(tibia::TILES_WIDTH * zoomLevel, tibia::TILES_HEIGHT * zoomLevel));
                 }
             }
@@ -455,23 +1402,22 @@ int main()
                         case sf::Keyboard::Right:
                         case sf::Keyboard::Down:
                         case sf::Keyboard::Left:
-                            game.updatePlayer();
-                            game.handleCreatureMovement(player, tibia::getDirectionByKey(event.key.code), event.key.control);
+                            if (event.key.control == true)
+                            {
+                                game.queueCommand(tibia::makeCommand(tibia::CommandTypes::turn, tibia::getDirectionByKey(event.key.code)));
+                            }
+                            else
+                            {
+                                game.queueCommand(tibia::makeCommand(tibia::CommandTypes::move, tibia::getDirectionByKey(event.key.code)));
+                            }
                             break;
 
                         case sf::Keyboard::O:
-                            player->setOutfitRandom();
-
-                            std::cout << "player head: " << player->getOutfitHead() << std::endl;
-                            std::cout << "player body: " << player->getOutfitBody() << std::endl;
-                            std::cout << "player legs: " << player->getOutfitLegs() << std::endl;
-                            std::cout << "player feet: " << player->getOutfitFeet() << std::endl;
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::setOutfitRandom));
                             break;
 
                         case sf::Keyboard::Z:
-                            player->setZ(tibia::getRandomNumber(tibia::ZAxis::underGround, tibia::ZAxis::aboveGround));
-
-                            std::cout << "player z: " << player->getZ() << std::endl;
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::setZRandom));
                             break;
 
                         case sf::Keyboard::H:
@@ -479,89 +1425,95 @@ int main()
                             break;
 
                         case sf::Keyboard::A:
-                            game.spawnAnimation(player->getTileX(), player->getTileY(), player->getZ(), tibia::Animations::spellBlue, 1.0);
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::spawnAnimation));
                             break;
 
                         case sf::Keyboard::D:
-                            game.spawnAnimatedDecal(player->getTileX(), player->getTileY(), player->getZ(), tibia::AnimatedDecals::poolRed, 30.0);
-                            game.spawnAnimatedDecal(player->getTileX(), player->getTileY(), player->getZ(), tibia::AnimatedDecals::corpse,  30.0);
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::spawnAnimatedDecal));
                             break;
 
                         case sf::Keyboard::B:
-                            game.spawnProjectile
-                            (
-                                player,
-                                tibia::ProjectileTypes::spellBlue,
-                                player->getDirection(),
-                                sf::Vector2f(player->getTileX(), player->getTileY()),
-                                sf::Vector2f
-                                (
-                                    player->getTileX() + (tibia::getVectorByDirection(player->getDirection()).x * tibia::TILE_SIZE),
-                                    player->getTileY() + (tibia::getVectorByDirection(player->getDirection()).y * tibia::TILE_SIZE)
-                                )
-                            );
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::spawnProjectile, player->getDirection(), tibia::ProjectileTypes::spellBlue));
                             break;
 
                         case sf::Keyboard::F:
-                            game.spawnProjectile
-                            (
-                                player,
-                                tibia::ProjectileTypes::spellFire,
-                                player->getDirection(),
-                                sf::Vector2f(player->getTileX(), player->getTileY()),
-                                sf::Vector2f
-                                (
-                                    player->getTileX() + (tibia::getVectorByDirection(player->getDirection()).x * tibia::TILE_SIZE),
-                                    player->getTileY() + (tibia::getVectorByDirection(player->getDirection()).y * tibia::TILE_SIZE)
-                                )
-                            );
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::spawnProjectile, player->getDirection(), tibia::ProjectileTypes::spellFire));
                             break;
 
                         case sf::Keyboard::P:
-                            game.spawnProjectile
-                            (
-                                player,
-                                tibia::ProjectileTypes::arrowPoison,
-                                player->getDirection(),
-                                sf::Vector2f(player->getTileX(), player->getTileY()),
-                                sf::Vector2f
-                                (
-                                    player->getTileX() + (tibia::getVectorByDirection(player->getDirection()).x * tibia::TILE_SIZE),
-                                    player->getTileY() + (tibia::getVectorByDirection(player->getDirection()).y * tibia::TILE_SIZE)
-                                )
-                            );
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::spawnProjectile, player->getDirection(), tibia::ProjectileTypes::arrowPoison));
                             break;
 
                         case sf::Keyboard::S:
-                            for (int i = tibia::Directions::begin; i < tibia::Directions::end + 1; i++)
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::spawnProjectilesAllDirections, 0, tibia::ProjectileTypes::spear));
+                            break;
+
+                        case sf::Keyboard::N:
+                            game.setShowCreatureNames(!game.getShowCreatureNames());
+                            break;
+
+                        case sf::Keyboard::F3:
+                            profiler->toggleOverlay();
+                            break;
+
+                        case sf::Keyboard::F4:
+                            if (profiler->isTracing() == false)
                             {
-                                game.spawnProjectile
-                                (
-                                    player,
-                                    tibia::ProjectileTypes::spear,
-                                    i,
-                                    sf::Vector2f(player->getTileX(), player->getTileY()),
-                                    sf::Vector2f
-                                    (
-                                        player->getTileX() + (tibia::getVectorByDirection(i).x * tibia::TILE_SIZE),
-                                        player->getTileY() + (tibia::getVectorByDirection(i).y * tibia::TILE_SIZE)
-                                    )
-                                );
+                                profiler->startTrace();
+
+                                std::cout << "Profiler trace started" << std::endl;
+                            }
+                            else
+                            {
+                                profiler->stopTrace();
+
+                                if (profiler->exportChromeTrace(fileProfilerTrace) == true)
+                                {
+                                    std::cout << "Profiler trace saved to " << fileProfilerTrace << std::endl;
+                                }
+                                else
+                                {
+                                    std::cout << "Error: Failed to save profiler trace to " << fileProfilerTrace << std::endl;
+                                }
+                            }
+                            break;
+
+                        case sf::Keyboard::F5:
+                            if (game.saveSnapshotFile(fileSnapshot) == true)
+                            {
+                                std::cout << "Snapshot saved to " << fileSnapshot << " at tick " << game.getTick() << std::endl;
+                            }
+                            else
+                            {
+                                std::cout << "Error: Failed to save snapshot to " << fileSnapshot << std::endl;
+                            }
+                            break;
+
+                        case sf::Keyboard::F9:
+                            if (game.loadSnapshotFile(fileSnapshot) == true)
+                            {
+                                player = game.getPlayer();
+
+                                std::cout << "Snapshot loaded from " << fileSnapshot << " at tick " << game.getTick() << std::endl;
+                            }
+                            else
+                            {
+                                std::cout << "Error: Failed to load snapshot from " << fileSnapshot << std::endl;
                             }
                             break;
 
                         case sf::Keyboard::C:
+                            game.queueCommand(tibia::makeCommand(tibia::CommandTypes::setOutfitRandomAll));
+
                             for (auto creature : *game.getCreaturesList())
                             {
                                 std::cout  << "name: " << creature->getName() << std::endl;
 
-                                creature->setOutfitRandom();
-
                                 float distance = creature->getDistanceFromPlayer();
 
                                 std::cout << "distance: " << distance << std::endl;
 
-                                float volume = tibia::calculateVolumeByDistance(distance);
+                                float volume = game.calculateVolumeForCreature(creature.get());
 
                                 std::cout << "volume: " << volume << std::endl;
                             }
@@ -588,8 +1540,8 @@ int main()
                     (
                         mouseTilePositionFloat.x < 0 ||
                         mouseTilePositionFloat.y < 0 ||
-                        mouseTilePositionFloat.x > tibia::MAP_TILE_XY_MAX ||
-                        mouseTilePositionFloat.y > tibia::MAP_TILE_XY_MAX
+                        mouseTilePositionFloat.x > tibia::getMapTileWidth() ||
+                        mouseTilePositionFloat.y > tibia::getMapTileHeight()
                     )
                     {
                         break;
@@ -634,7 +1586,7 @@ int main()
 
                                 int playerMovementDirection = tibia::getDirectionByVector(playerMovementNormal);
 
-                                game.handleCreatureMovement(player, playerMovementDirection);
+                                game.queueCommand(tibia::makeCommand(tibia::CommandTypes::move, playerMovementDirection));
                             }
 
                             break;
@@ -644,34 +1596,7 @@ int main()
                         {
                             if (tibia::GuiData::gameWindowRect.contains(mouseWindowPosition))
                             {
-                                if (game.doCreatureUseLadder(player, mouseTilePosition) == true)
-                                {
-                                    break;
-                                }
-
-                                if (game.doCreatureUseLever(player, mouseTilePosition) == true)
-                                {
-                                    break;
-                                }
-
-                                if (player->getTileNumber() == mouseTileNumber)
-                                {
-                                    break;
-                                }
-
-                                game.spawnProjectile
-                                (
-                                    player,
-                                    tibia::ProjectileTypes::arrow,
-                                    player->getDirection(),
-                                    sf::Vector2f(player->getTileX(), player->getTileY()),
-                                    sf::Vector2f
-                                    (
-                                        mouseTilePosition.x,
-                                        mouseTilePosition.y
-                                    ),
-                                    true
-                                );
+                                game.queueCommand(tibia::makeCommand(tibia::CommandTypes::use, 0, 0, mouseTilePosition.x, mouseTilePosition.y));
                             }
 
                             break;
@@ -29,8 +29,6 @@ public:
         setFrameTime(tibia::AnimationTimes::default);
 
         m_numRepeat = 0;
-
-        m_clock.restart();
     }
 
     void setId(int id)
@@ -57,30 +55,29 @@ public:
         return m_numFrames;
     }
 
-    void advanceFrame()
+    // returns false once the last frame has finished
+    bool advanceFrame()
     {
-        sf::Time timeElapsed = m_clock.getElapsedTime();
+        m_currentFrame++;
 
-        if (timeElapsed.asSeconds() >= m_frameTime)
+        if (m_currentFrame > m_numFrames - 1)
         {
-            m_currentFrame++;
-
-            if (m_currentFrame > m_numFrames - 1)
+            if (m_numRepeat > 0)
             {
-                if (m_numRepeat > 0)
-                {
-                    m_currentFrame = 0;
+                m_currentFrame = 0;
 
-                    m_numRepeat--;
-                }
-
-                //return;
+                m_numRepeat--;
             }
+        }
 
-            m_sprite.setId(m_id + m_currentFrame);
+        m_sprite.setId(m_id + m_currentFrame);
 
-            m_clock.restart();
-        }
+        return isFinished() == false;
+    }
+
+    bool isFinished()
+    {
+        return m_currentFrame > m_numFrames - 1;
     }
 
     int getCurrentFrame()
@@ -88,6 +85,13 @@ public:
         return m_currentFrame;
     }
 
+    void setCurrentFrame(int frame)
+    {
+        m_currentFrame = frame;
+
+        m_sprite.setId(m_id + m_currentFrame);
+    }
+
     void setNumRepeat(int numRepeat)
     {
         m_numRepeat = numRepeat;
@@ -113,8 +117,6 @@ public:
         updateTileCoords();
 
         setPosition(getTileX(), getTileY());
-
-        advanceFrame();
     }
 
 private:
@@ -131,8 +133,6 @@ private:
 
     int m_numRepeat;
 
-    sf::Clock m_clock;
-
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const
     {
         states.transform *= getTransform();
@@ -0,0 +1,294 @@
+#ifndef TIBIA_ASSETLOADER_HPP
+#define TIBIA_ASSETLOADER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+namespace tibia
+{
+
+// tasks run on worker threads, images are decoded on the workers and uploaded to
+// their textures by update() on the thread that owns the OpenGL context
+class AssetLoader
+{
+
+public:
+
+    typedef std::function<bool()> TaskFunction;
+
+    struct Task
+    {
+        std::string name;
+
+        TaskFunction function;
+
+        sf::Texture* texture;
+    };
+
+    struct Image
+    {
+        std::string name;
+
+        sf::Image image;
+
+        sf::Texture* texture;
+    };
+
+    typedef std::shared_ptr<Image> ImagePtr;
+
+    AssetLoader()
+    {
+        m_numTasks = 0;
+
+        m_numTasksDone = 0;
+
+        m_isStarted = false;
+
+        m_hasFailed = false;
+    }
+
+    ~AssetLoader()
+    {
+        join();
+    }
+
+    void addTask(std::string name, TaskFunction function)
+    {
+        Task task;
+        task.name     = name;
+        task.function = function;
+        task.texture  = nullptr;
+
+        m_tasksList.push_back(task);
+
+        m_numTasks++;
+    }
+
+    void addTexture(sf::Texture* texture, std::string filename)
+    {
+        Task task;
+        task.name    = filename;
+        task.texture = texture;
+
+        m_tasksList.push_back(task);
+
+        m_numTasks++;
+    }
+
+    // decoded only, for images that are uploaded some other way such as through a texture atlas
+    void addImage(sf::Image* image, std::string filename)
+    {
+        addTask(filename, [image, filename]() { return image->loadFromFile(filename); });
+    }
+
+    void start(unsigned int numThreads = 0)
+    {
+        if (m_isStarted == true)
+        {
+            return;
+        }
+
+        m_isStarted = true;
+
+        if (numThreads == 0)
+        {
+            numThreads = std::max(std::thread::hardware_concurrency(), 2u);
+        }
+
+        numThreads = std::min(numThreads, static_cast<unsigned int>(m_tasksList.size()));
+
+        for (unsigned int i = 0; i < numThreads; i++)
+        {
+            m_threadsList.push_back(std::thread(&AssetLoader::doWork, this));
+        }
+    }
+
+    // uploads decoded images, returns the number of textures uploaded
+    int update()
+    {
+        std::deque<ImagePtr> imagesList;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            imagesList.swap(m_imagesList);
+        }
+
+        for (auto image : imagesList)
+        {
+            if (image->texture->loadFromImage(image->image) == false)
+            {
+                setFailed(image->name);
+            }
+
+            m_numTasksDone++;
+        }
+
+        return imagesList.size();
+    }
+
+    // blocks until every task is done, for when there is nothing to draw in the meantime
+    void wait()
+    {
+        while (isFinished() == false)
+        {
+            update();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    bool isFinished()
+    {
+        if (m_numTasksDone < m_numTasks)
+        {
+            return false;
+        }
+
+        join();
+
+        return true;
+    }
+
+    float getProgress()
+    {
+        if (m_numTasks == 0)
+        {
+            return 1.0f;
+        }
+
+        return static_cast<float>(m_numTasksDone) / static_cast<float>(m_numTasks);
+    }
+
+    int getNumTasks()
+    {
+        return m_numTasks;
+    }
+
+    int getNumTasksDone()
+    {
+        return m_numTasksDone;
+    }
+
+    bool hasFailed()
+    {
+        return m_hasFailed;
+    }
+
+    std::string getFailedName()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_failedName;
+    }
+
+private:
+
+    void doWork()
+    {
+        while (true)
+        {
+            Task task;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                if (m_tasksList.size() == 0)
+                {
+                    return;
+                }
+
+                task = m_tasksList.front();
+
+                m_tasksList.pop_front();
+            }
+
+            if (task.texture != nullptr)
+            {
+                ImagePtr image = std::make_shared<Image>();
+                image->name    = task.name;
+                image->texture = task.texture;
+
+                if (image->image.loadFromFile(task.name) == false)
+                {
+                    setFailed(task.name);
+
+                    m_numTasksDone++;
+
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                m_imagesList.push_back(image);
+
+                continue;
+            }
+
+            if (task.function() == false)
+            {
+                setFailed(task.name);
+            }
+
+            m_numTasksDone++;
+        }
+    }
+
+    void setFailed(std::string name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_hasFailed == false)
+        {
+            m_failedName = name;
+        }
+
+        m_hasFailed = true;
+    }
+
+    void join()
+    {
+        for (auto& thread : m_threadsList)
+        {
+            if (thread.joinable() == true)
+            {
+                thread.join();
+            }
+        }
+
+        m_threadsList.clear();
+    }
+
+    std::deque<Task> m_tasksList;
+
+    std::deque<ImagePtr> m_imagesList;
+
+    std::vector<std::thread> m_threadsList;
+
+    std::mutex m_mutex;
+
+    int m_numTasks;
+
+    std::atomic<int> m_numTasksDone;
+
+    bool m_isStarted;
+
+    std::atomic<bool> m_hasFailed;
+
+    std::string m_failedName;
+
+};
+
+}
+
+#endif // TIBIA_ASSETLOADER_HPP
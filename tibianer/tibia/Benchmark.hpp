@@ -0,0 +1,268 @@
+#ifndef TIBIA_BENCHMARK_HPP
+#define TIBIA_BENCHMARK_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <functional>
+#include <algorithm>
+
+#include <SFML/System.hpp>
+
+#include "tibia/Tibia.hpp"
+#include "tibia/TileChunk.hpp"
+#include "tibia/Random.hpp"
+
+namespace tibia
+{
+
+// times functions and writes the results in the json format of google benchmark, so its compare tools
+// can be used to track the results across commits. times are in microseconds per iteration
+class Benchmark
+{
+
+public:
+
+    static const int ITERATIONS_MIN = 3;
+    static const int ITERATIONS_MAX = 100000;
+
+    struct Result
+    {
+        std::string name;
+
+        int numIterations;
+
+        // items processed by one iteration, e.g. queries or tiles
+        int numItems;
+
+        double timeMean;
+        double timeMin;
+        double timeMax;
+    };
+
+    struct ContextValue
+    {
+        std::string name;
+
+        std::string value;
+    };
+
+    // a map of the given size in tiles with ground tiles, some water and walls and a few objects,
+    // the chunk file is written directly so the map file itself only has to hold the layer names
+    static bool createMap(std::string filename, int width, int height, std::uint64_t seed)
+    {
+        tibia::Random random(seed);
+
+        std::vector<int> tilesList(width * height, 1);
+        std::vector<int> wallsList(width * height, tibia::TILE_NULL);
+
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        file << "<map version=\"1.0\" orientation=\"orthogonal\" width=\"" << width << "\" height=\"" << height << "\" tilewidth=\"" << tibia::TILE_SIZE << "\" tileheight=\"" << tibia::TILE_SIZE << "\">\n";
+        file << " <layer name=\"ground tiles\" width=\"" << width << "\" height=\"" << height << "\"/>\n";
+        file << " <layer name=\"ground walls\" width=\"" << width << "\" height=\"" << height << "\"/>\n";
+        file << " <objectgroup name=\"ground objects\">\n";
+
+        for (int i = 0; i < width * height; i++)
+        {
+            int number = random.getNumber(1, 100);
+
+            if (number <= 5)
+            {
+                tilesList[i] = tibia::SpriteData::water[random.getNumber(0, tibia::SpriteData::water.size() - 1)];
+            }
+            else if (number <= 13)
+            {
+                wallsList[i] = tibia::SpriteData::solid[0];
+            }
+            else if (number <= 15)
+            {
+                file << "  <object gid=\"" << tibia::SpriteData::bucket[0] << "\" x=\"" << (i % width) * tibia::TILE_SIZE << "\" y=\"" << ((i / width) + 1) * tibia::TILE_SIZE << "\"/>\n";
+            }
+        }
+
+        file << " </objectgroup>\n";
+        file << "</map>\n";
+
+        file.close();
+
+        if (file.fail() == true)
+        {
+            return false;
+        }
+
+        tibia::TileChunkFile chunkFile;
+
+        if (chunkFile.beginWrite(filename + ".chunks", tibia::BinaryStream::getFileHash(filename), width, height, 2) == false)
+        {
+            return false;
+        }
+
+        chunkFile.writeLayer(0, tilesList);
+        chunkFile.writeLayer(1, wallsList);
+
+        return chunkFile.endWrite();
+    }
+
+    Benchmark(float timeMin = tibia::BENCHMARK_TIME_MIN)
+    {
+        m_timeMin = timeMin;
+    }
+
+    // the function runs once untimed to warm up, then until it has run for the minimum time.
+    // the setup runs before every iteration and is not timed
+    void run(std::string name, int numItems, std::function<void()> function, std::function<void()> setup = nullptr)
+    {
+        Result result;
+        result.name          = name;
+        result.numIterations = 0;
+        result.numItems      = numItems;
+        result.timeMean      = 0;
+        result.timeMin       = 0;
+        result.timeMax       = 0;
+
+        if (setup != nullptr)
+        {
+            setup();
+        }
+
+        function();
+
+        double timeTotal = 0;
+
+        sf::Clock clock;
+
+        while (result.numIterations < ITERATIONS_MAX && (result.numIterations < ITERATIONS_MIN || timeTotal < m_timeMin * 1000000.0))
+        {
+            if (setup != nullptr)
+            {
+                setup();
+            }
+
+            clock.restart();
+
+            function();
+
+            double time = static_cast<double>(clock.getElapsedTime().asMicroseconds());
+
+            if (result.numIterations == 0 || time < result.timeMin) result.timeMin = time;
+            if (result.numIterations == 0 || time > result.timeMax) result.timeMax = time;
+
+            timeTotal += time;
+
+            result.numIterations++;
+        }
+
+        result.timeMean = timeTotal / result.numIterations;
+
+        m_resultsList.push_back(result);
+
+        std::cout
+            << std::left << std::setw(40) << name << std::right
+            << std::fixed << std::setprecision(2)
+            << std::setw(14) << result.timeMean << " us"
+            << std::setw(14) << result.timeMin  << " us min"
+            << std::setw(10) << result.numIterations << " iterations"
+            << std::endl;
+
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    // shown in the context of the json file, e.g. the scale of the fixtures
+    void addContextValue(std::string name, std::string value)
+    {
+        ContextValue contextValue;
+        contextValue.name  = name;
+        contextValue.value = value;
+
+        m_contextValuesList.push_back(contextValue);
+    }
+
+    const std::vector<Result>& getResults()
+    {
+        return m_resultsList;
+    }
+
+    bool saveJsonFile(std::string filename)
+    {
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        char date[32];
+        std::time_t time = std::time(0);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&time));
+
+        file << "{\n";
+        file << "  \"context\": {\n";
+        file << "    \"date\": \"" << date << "\",\n";
+        file << "    \"executable\": \"tibianer\",\n";
+
+        for (auto& contextValue : m_contextValuesList)
+        {
+            file << "    \"" << contextValue.name << "\": \"" << contextValue.value << "\",\n";
+        }
+
+        file << "    \"time_min\": " << m_timeMin << "\n";
+        file << "  },\n";
+        file << "  \"benchmarks\": [\n";
+
+        file << std::fixed << std::setprecision(3);
+
+        for (unsigned int i = 0; i < m_resultsList.size(); i++)
+        {
+            Result& result = m_resultsList.at(i);
+
+            double itemsPerSecond = 0;
+
+            if (result.timeMean > 0)
+            {
+                itemsPerSecond = result.numItems * (1000000.0 / result.timeMean);
+            }
+
+            file << "    {\n";
+            file << "      \"name\": \""            << result.name          << "\",\n";
+            file << "      \"run_name\": \""        << result.name          << "\",\n";
+            file << "      \"run_type\": \"iteration\",\n";
+            file << "      \"iterations\": "        << result.numIterations << ",\n";
+            file << "      \"real_time\": "         << result.timeMean      << ",\n";
+            file << "      \"cpu_time\": "          << result.timeMean      << ",\n";
+            file << "      \"time_unit\": \"us\",\n";
+            file << "      \"time_min\": "          << result.timeMin       << ",\n";
+            file << "      \"time_max\": "          << result.timeMax       << ",\n";
+            file << "      \"items_per_second\": "  << itemsPerSecond       << "\n";
+            file << "    }" << (i + 1 < m_resultsList.size() ? "," : "") << "\n";
+        }
+
+        file << "  ]\n";
+        file << "}\n";
+
+        return file.good();
+    }
+
+private:
+
+    float m_timeMin;
+
+    std::vector<Result> m_resultsList;
+
+    std::vector<ContextValue> m_contextValuesList;
+
+};
+
+}
+
+#endif // TIBIA_BENCHMARK_HPP
@@ -0,0 +1,193 @@
+#ifndef TIBIA_BINARYSTREAM_HPP
+#define TIBIA_BINARYSTREAM_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <fstream>
+
+namespace tibia
+{
+
+namespace BinaryStream
+{
+    // names and filenames, nothing written by the game comes close
+    const std::uint64_t STRING_SIZE_MAX = 65536;
+
+    inline void writeUint8(std::ostream& stream, std::uint8_t value)
+    {
+        stream.put(static_cast<char>(value));
+    }
+
+    inline std::uint8_t readUint8(std::istream& stream)
+    {
+        return static_cast<std::uint8_t>(stream.get());
+    }
+
+    // fixed-width values are always little-endian on disk
+
+    inline void writeUint32(std::ostream& stream, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            stream.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+        }
+    }
+
+    inline std::uint32_t readUint32(std::istream& stream)
+    {
+        std::uint32_t value = 0;
+
+        for (int i = 0; i < 4; i++)
+        {
+            value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(stream.get())) << (i * 8);
+        }
+
+        return value;
+    }
+
+    inline void writeUint64(std::ostream& stream, std::uint64_t value)
+    {
+        writeUint32(stream, static_cast<std::uint32_t>(value));
+        writeUint32(stream, static_cast<std::uint32_t>(value >> 32));
+    }
+
+    inline std::uint64_t readUint64(std::istream& stream)
+    {
+        std::uint64_t low  = readUint32(stream);
+        std::uint64_t high = readUint32(stream);
+
+        return low | (high << 32);
+    }
+
+    inline void writeFloat(std::ostream& stream, float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        writeUint32(stream, bits);
+    }
+
+    inline float readFloat(std::istream& stream)
+    {
+        std::uint32_t bits = readUint32(stream);
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+
+        return value;
+    }
+
+    // LEB128 variable-length integers, signed values are zigzag encoded
+
+    inline void writeVarUint(std::ostream& stream, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            stream.put(static_cast<char>((value & 0x7F) | 0x80));
+
+            value >>= 7;
+        }
+
+        stream.put(static_cast<char>(value));
+    }
+
+    inline std::uint64_t readVarUint(std::istream& stream)
+    {
+        std::uint64_t value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            int byte = stream.get();
+
+            if (byte == std::char_traits<char>::eof())
+            {
+                break;
+            }
+
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+            if ((byte & 0x80) == 0)
+            {
+                break;
+            }
+        }
+
+        return value;
+    }
+
+    inline void writeVarInt(std::ostream& stream, std::int64_t value)
+    {
+        writeVarUint(stream, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    inline std::int64_t readVarInt(std::istream& stream)
+    {
+        std::uint64_t value = readVarUint(stream);
+
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    inline void writeString(std::ostream& stream, const std::string& value)
+    {
+        writeVarUint(stream, value.size());
+
+        stream.write(value.data(), value.size());
+    }
+
+    // a longer size can only come from a corrupt stream, which is failed instead of allocating it
+    inline std::string readString(std::istream& stream)
+    {
+        std::uint64_t size = readVarUint(stream);
+
+        if (size > STRING_SIZE_MAX)
+        {
+            stream.setstate(std::ios::failbit);
+
+            return std::string();
+        }
+
+        std::string value(static_cast<std::size_t>(size), '\0');
+
+        if (size != 0)
+        {
+            stream.read(&value[0], value.size());
+        }
+
+        return value;
+    }
+
+    // FNV-1a over the contents of a file, 0 if it cannot be read. used to tell when a cache made from the file is stale
+    inline std::uint64_t getFileHash(std::string filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (file.is_open() == false)
+        {
+            return 0;
+        }
+
+        std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+        char buffer[65536];
+
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() != 0)
+        {
+            std::streamsize numBytes = file.gcount();
+
+            for (std::streamsize i = 0; i < numBytes; i++)
+            {
+                hash ^= static_cast<std::uint8_t>(buffer[i]);
+                hash *= 0x100000001B3ULL;
+            }
+        }
+
+        return hash;
+    }
+}
+
+}
+
+#endif // TIBIA_BINARYSTREAM_HPP
@@ -0,0 +1,263 @@
+#ifndef TIBIA_BITMAPFONT_HPP
+#define TIBIA_BITMAPFONT_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+namespace tibia
+{
+
+// fixed width font laid out in a grid of characters inside a texture, usually a texture atlas region
+class BitmapFont
+{
+
+public:
+
+    static const int NUM_GLYPHS = 256;
+
+    BitmapFont()
+    {
+        m_texture = nullptr;
+
+        for (int i = 0; i < NUM_GLYPHS; i++)
+        {
+            m_glyphsList[i] = sf::IntRect(0, 0, 0, 0);
+        }
+    }
+
+    // the characters are laid out in rows as wide as the texture rect, starting at firstCharacter,
+    // e.g. 32 for printable ascii only. characters before it are not in the texture
+    bool load(const sf::Texture* texture, sf::IntRect textureRect, sf::Vector2i characterSize, int firstCharacter)
+    {
+        if (texture == nullptr || characterSize.x <= 0 || characterSize.y <= 0)
+        {
+            return false;
+        }
+
+        int numColumns = textureRect.width  / characterSize.x;
+        int numRows    = textureRect.height / characterSize.y;
+
+        int numCharacters = std::min(numColumns * numRows, NUM_GLYPHS - firstCharacter);
+
+        if (numCharacters <= 0)
+        {
+            return false;
+        }
+
+        m_texture = texture;
+
+        m_characterSize = characterSize;
+
+        for (int i = 0; i < NUM_GLYPHS; i++)
+        {
+            int glyphIndex = i - firstCharacter;
+
+            if (glyphIndex < 0 || glyphIndex >= numCharacters)
+            {
+                m_glyphsList[i] = sf::IntRect(0, 0, 0, 0);
+                continue;
+            }
+
+            m_glyphsList[i] = sf::IntRect
+            (
+                textureRect.left + ((glyphIndex % numColumns) * m_characterSize.x),
+                textureRect.top  + ((glyphIndex / numColumns) * m_characterSize.y),
+                m_characterSize.x,
+                m_characterSize.y
+            );
+        }
+
+        return true;
+    }
+
+    // appends one quad per visible character, '\n' starts a new line
+    void addText(std::vector<sf::Vertex>& verticesList, const char* text, sf::Vector2f position, sf::Color color) const
+    {
+        float x = position.x;
+        float y = position.y;
+
+        for (const char* character = text; *character != '\0'; character++)
+        {
+            if (*character == '\n')
+            {
+                x = position.x;
+                y += m_characterSize.y;
+
+                continue;
+            }
+
+            const sf::IntRect& glyph = m_glyphsList[static_cast<unsigned char>(*character)];
+
+            if (glyph.width != 0)
+            {
+                sf::Vertex quad[4];
+
+                quad[0].position = sf::Vector2f(x,                     y);
+                quad[1].position = sf::Vector2f(x + m_characterSize.x, y);
+                quad[2].position = sf::Vector2f(x + m_characterSize.x, y + m_characterSize.y);
+                quad[3].position = sf::Vector2f(x,                     y + m_characterSize.y);
+
+                quad[0].texCoords = sf::Vector2f(glyph.left,               glyph.top);
+                quad[1].texCoords = sf::Vector2f(glyph.left + glyph.width, glyph.top);
+                quad[2].texCoords = sf::Vector2f(glyph.left + glyph.width, glyph.top + glyph.height);
+                quad[3].texCoords = sf::Vector2f(glyph.left,               glyph.top + glyph.height);
+
+                quad[0].color = color;
+                quad[1].color = color;
+                quad[2].color = color;
+                quad[3].color = color;
+
+                verticesList.push_back(quad[0]);
+                verticesList.push_back(quad[1]);
+                verticesList.push_back(quad[2]);
+                verticesList.push_back(quad[3]);
+            }
+
+            x += m_characterSize.x;
+        }
+    }
+
+    // width of the longest line
+    int getTextWidth(const char* text) const
+    {
+        int width     = 0;
+        int lineWidth = 0;
+
+        for (const char* character = text; *character != '\0'; character++)
+        {
+            if (*character == '\n')
+            {
+                lineWidth = 0;
+                continue;
+            }
+
+            lineWidth += m_characterSize.x;
+
+            if (lineWidth > width)
+            {
+                width = lineWidth;
+            }
+        }
+
+        return width;
+    }
+
+    const sf::Texture* getTexture() const
+    {
+        return m_texture;
+    }
+
+    sf::Vector2i getCharacterSize() const
+    {
+        return m_characterSize;
+    }
+
+private:
+
+    const sf::Texture* m_texture;
+
+    sf::Vector2i m_characterSize;
+
+    sf::IntRect m_glyphsList[NUM_GLYPHS];
+
+};
+
+// labels from any number of bitmap fonts collected over a frame and drawn with one draw call per texture,
+// the vertex buffers are kept between frames so they stop allocating once they have grown
+class BitmapTextBatch
+{
+
+public:
+
+    struct Batch
+    {
+        const sf::Texture* texture;
+
+        std::vector<sf::Vertex> verticesList;
+    };
+
+    void clear()
+    {
+        for (auto& batch : m_batchesList)
+        {
+            batch.verticesList.clear();
+        }
+    }
+
+    void addText(const tibia::BitmapFont& font, const char* text, sf::Vector2f position, sf::Color color)
+    {
+        font.addText(getBatch(font.getTexture())->verticesList, text, position, color);
+    }
+
+    // the position is the bottom center of the text
+    void addTextCentered(const tibia::BitmapFont& font, const char* text, sf::Vector2f position, sf::Color color)
+    {
+        position.x -= font.getTextWidth(text) / 2;
+        position.y -= font.getCharacterSize().y;
+
+        addText(font, text, position, color);
+    }
+
+    // draws the text again offset by one pixel behind itself
+    void addTextCenteredWithShadow(const tibia::BitmapFont& font, const char* text, sf::Vector2f position, sf::Color color, sf::Color shadowColor)
+    {
+        addTextCentered(font, text, sf::Vector2f(position.x + 1, position.y + 1), shadowColor);
+        addTextCentered(font, text, position, color);
+    }
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default)
+    {
+        for (auto& batch : m_batchesList)
+        {
+            if (batch.verticesList.size() == 0)
+            {
+                continue;
+            }
+
+            states.texture = batch.texture;
+
+            target.draw(&batch.verticesList[0], batch.verticesList.size(), sf::Quads, states);
+        }
+    }
+
+    int getNumVertices()
+    {
+        int numVertices = 0;
+
+        for (auto& batch : m_batchesList)
+        {
+            numVertices += batch.verticesList.size();
+        }
+
+        return numVertices;
+    }
+
+private:
+
+    Batch* getBatch(const sf::Texture* texture)
+    {
+        for (auto& batch : m_batchesList)
+        {
+            if (batch.texture == texture)
+            {
+                return &batch;
+            }
+        }
+
+        Batch batch;
+        batch.texture = texture;
+
+        m_batchesList.push_back(batch);
+
+        return &m_batchesList.back();
+    }
+
+    std::vector<Batch> m_batchesList;
+
+};
+
+}
+
+#endif // TIBIA_BITMAPFONT_HPP
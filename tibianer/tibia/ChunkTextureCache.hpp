@@ -0,0 +1,126 @@
+#ifndef TIBIA_CHUNKTEXTURECACHE_HPP
+#define TIBIA_CHUNKTEXTURECACHE_HPP
+
+#include <map>
+#include <memory>
+
+#include <SFML/Graphics.hpp>
+
+#include "tibia/Tibia.hpp"
+
+namespace tibia
+{
+
+// downsampled textures of square chunks of a floor used to draw the map when zoomed far out,
+// chunks are baked on demand and the least recently drawn chunk is dropped once the cache is full
+class ChunkTextureCache
+{
+
+public:
+
+    struct Chunk
+    {
+        std::shared_ptr<sf::Texture> texture;
+
+        unsigned int frameUsed;
+    };
+
+    ChunkTextureCache()
+    {
+        m_frame = 0;
+    }
+
+    void clear()
+    {
+        m_chunksList.clear();
+    }
+
+    void beginFrame()
+    {
+        m_frame++;
+    }
+
+    // nullptr if the chunk has not been baked yet
+    const sf::Texture* getTexture(int chunkX, int chunkY, int z)
+    {
+        auto chunks_it = m_chunksList.find(getKey(chunkX, chunkY, z));
+
+        if (chunks_it == m_chunksList.end())
+        {
+            return nullptr;
+        }
+
+        chunks_it->second.frameUsed = m_frame;
+
+        return chunks_it->second.texture.get();
+    }
+
+    const sf::Texture* addTexture(int chunkX, int chunkY, int z, const sf::Image& image)
+    {
+        if (static_cast<int>(m_chunksList.size()) >= tibia::LOD_CHUNKS_MAX)
+        {
+            removeLeastRecentlyUsed();
+        }
+
+        Chunk chunk;
+        chunk.texture = std::make_shared<sf::Texture>();
+        chunk.frameUsed = m_frame;
+
+        if (chunk.texture->loadFromImage(image) == false)
+        {
+            return nullptr;
+        }
+
+        chunk.texture->setSmooth(true);
+
+        m_chunksList[getKey(chunkX, chunkY, z)] = chunk;
+
+        return chunk.texture.get();
+    }
+
+    // the chunk is baked again the next time it is drawn
+    void removeTexture(int chunkX, int chunkY, int z)
+    {
+        m_chunksList.erase(getKey(chunkX, chunkY, z));
+    }
+
+    int getNumChunks()
+    {
+        return m_chunksList.size();
+    }
+
+private:
+
+    // chunk coords fit in 12 bits each even on the largest maps
+    int getKey(int chunkX, int chunkY, int z)
+    {
+        return (z << 24) | ((chunkY & 0xFFF) << 12) | (chunkX & 0xFFF);
+    }
+
+    void removeLeastRecentlyUsed()
+    {
+        auto oldest_it = m_chunksList.begin();
+
+        for (auto chunks_it = m_chunksList.begin(); chunks_it != m_chunksList.end(); chunks_it++)
+        {
+            if (chunks_it->second.frameUsed < oldest_it->second.frameUsed)
+            {
+                oldest_it = chunks_it;
+            }
+        }
+
+        if (oldest_it != m_chunksList.end())
+        {
+            m_chunksList.erase(oldest_it);
+        }
+    }
+
+    unsigned int m_frame;
+
+    std::map<int, Chunk> m_chunksList;
+
+};
+
+}
+
+#endif // TIBIA_CHUNKTEXTURECACHE_HPP
@@ -0,0 +1,297 @@
+#ifndef TIBIA_COMBATLOG_HPP
+#define TIBIA_COMBATLOG_HPP
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "tibia/Tibia.hpp"
+#include "tibia/Creature.hpp"
+
+namespace tibia
+{
+
+namespace CombatEventTypes
+{
+    enum
+    {
+        hit  = 1 << 0,
+        kill = 1 << 1,
+
+        all = hit | kill
+    };
+}
+
+struct CombatEvent
+{
+    int type;
+
+    float time;
+
+    int damage;
+
+    int attackerTeam;
+    int defenderTeam;
+
+    int defenderHp;
+
+    char attackerName[32];
+    char defenderName[32];
+};
+
+class CombatLog
+{
+
+public:
+
+    typedef std::function<void(const tibia::CombatEvent&)> Subscriber;
+
+    static const unsigned int RING_BUFFER_SIZE = 4096; // must be a power of two
+
+    CombatLog()
+    :
+        m_ringBuffer(RING_BUFFER_SIZE),
+        m_head(0),
+        m_tail(0),
+        m_isRunning(false)
+    {
+        m_filter = tibia::CombatEventTypes::all;
+
+        m_isBinary = false;
+
+        m_numDropped = 0;
+    }
+
+    ~CombatLog()
+    {
+        close();
+    }
+
+    bool open(std::string filename, bool isBinary = false)
+    {
+        close();
+
+        m_isBinary = isBinary;
+
+        if (m_isBinary == true)
+        {
+            m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+        else
+        {
+            m_file.open(filename.c_str(), std::ios::out | std::ios::trunc);
+        }
+
+        if (m_file.is_open() == false)
+        {
+            return false;
+        }
+
+        m_isRunning = true;
+
+        m_writerThread = std::thread(&CombatLog::doWriter, this);
+
+        return true;
+    }
+
+    void close()
+    {
+        if (m_isRunning == false)
+        {
+            return;
+        }
+
+        m_isRunning = false;
+
+        if (m_writerThread.joinable() == true)
+        {
+            m_writerThread.join();
+        }
+
+        m_file.close();
+    }
+
+    bool isOpen()
+    {
+        return m_isRunning;
+    }
+
+    void push(int type, float time, tibia::Creature* attacker, tibia::Creature* defender, int damage = 0)
+    {
+        if ((m_filter & type) == 0)
+        {
+            return;
+        }
+
+        tibia::CombatEvent combatEvent;
+        combatEvent.type         = type;
+        combatEvent.time         = time;
+        combatEvent.damage       = damage;
+        combatEvent.attackerTeam = attacker->getTeam();
+        combatEvent.defenderTeam = defender->getTeam();
+        combatEvent.defenderHp   = defender->getHp();
+
+        copyName(combatEvent.attackerName, attacker->getName());
+        copyName(combatEvent.defenderName, defender->getName());
+
+        for (auto subscriber : m_subscribersList)
+        {
+            subscriber(combatEvent);
+        }
+
+        if (m_isRunning == false)
+        {
+            return;
+        }
+
+        unsigned int head = m_head.load(std::memory_order_relaxed);
+        unsigned int tail = m_tail.load(std::memory_order_acquire);
+
+        if (head - tail >= RING_BUFFER_SIZE)
+        {
+            m_numDropped++;
+            return;
+        }
+
+        m_ringBuffer[head & (RING_BUFFER_SIZE - 1)] = combatEvent;
+
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    void addSubscriber(Subscriber subscriber)
+    {
+        m_subscribersList.push_back(subscriber);
+    }
+
+    void clearSubscribers()
+    {
+        m_subscribersList.clear();
+    }
+
+    void setFilter(int filter)
+    {
+        m_filter = filter;
+    }
+
+    int getFilter()
+    {
+        return m_filter;
+    }
+
+    unsigned int getNumDropped()
+    {
+        return m_numDropped;
+    }
+
+private:
+
+    void copyName(char* destination, const std::string& name)
+    {
+        std::strncpy(destination, name.c_str(), sizeof(tibia::CombatEvent::attackerName) - 1);
+
+        destination[sizeof(tibia::CombatEvent::attackerName) - 1] = '\0';
+    }
+
+    void writeEvent(const tibia::CombatEvent& combatEvent)
+    {
+        if (m_isBinary == true)
+        {
+            m_file.write(reinterpret_cast<const char*>(&combatEvent), sizeof(tibia::CombatEvent));
+
+            return;
+        }
+
+        switch (combatEvent.type)
+        {
+            case tibia::CombatEventTypes::hit:
+                m_file
+                    << combatEvent.time
+                    << " "
+                    << combatEvent.attackerName
+                    << " hit "
+                    << combatEvent.defenderName
+                    << " for "
+                    << combatEvent.damage
+                    << " damage.\n";
+                break;
+
+            case tibia::CombatEventTypes::kill:
+                m_file
+                    << combatEvent.time
+                    << " "
+                    << combatEvent.attackerName
+                    << " killed "
+                    << combatEvent.defenderName
+                    << "\n";
+                break;
+        }
+    }
+
+    bool drainRingBuffer()
+    {
+        unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        unsigned int head = m_head.load(std::memory_order_acquire);
+
+        if (tail == head)
+        {
+            return false;
+        }
+
+        while (tail != head)
+        {
+            writeEvent(m_ringBuffer[tail & (RING_BUFFER_SIZE - 1)]);
+
+            tail++;
+        }
+
+        m_tail.store(tail, std::memory_order_release);
+
+        return true;
+    }
+
+    void doWriter()
+    {
+        while (m_isRunning == true)
+        {
+            if (drainRingBuffer() == true)
+            {
+                m_file.flush();
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        drainRingBuffer();
+
+        m_file.flush();
+    }
+
+    int m_filter;
+
+    bool m_isBinary;
+
+    unsigned int m_numDropped;
+
+    std::vector<tibia::CombatEvent> m_ringBuffer;
+
+    std::atomic<unsigned int> m_head;
+    std::atomic<unsigned int> m_tail;
+
+    std::atomic<bool> m_isRunning;
+
+    std::thread m_writerThread;
+
+    std::ofstream m_file;
+
+    std::vector<Subscriber> m_subscribersList;
+
+};
+
+}
+
+#endif // TIBIA_COMBATLOG_HPP
@@ -0,0 +1,279 @@
+#ifndef TIBIA_COMMAND_HPP
+#define TIBIA_COMMAND_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+
+#include "tibia/BinaryStream.hpp"
+
+namespace tibia
+{
+
+namespace CommandTypes
+{
+    enum
+    {
+        move,
+        turn,
+        spawnProjectile,
+        spawnProjectilesAllDirections,
+        use,
+        setOutfitRandom,
+        setOutfitRandomAll,
+        setZRandom,
+        spawnAnimation,
+        spawnAnimatedDecal,
+    };
+}
+
+struct Command
+{
+    unsigned int tick;
+
+    int type;
+
+    int direction;
+
+    int projectileType;
+
+    int x;
+    int y;
+
+    // spawn id of the creature the command acts on, 0 is the local player
+    int creatureId;
+};
+
+inline tibia::Command makeCommand(int type, int direction = 0, int projectileType = 0, int x = 0, int y = 0, int creatureId = 0)
+{
+    tibia::Command command;
+    command.tick           = 0;
+    command.type           = type;
+    command.direction      = direction;
+    command.projectileType = projectileType;
+    command.x              = x;
+    command.y              = y;
+    command.creatureId     = creatureId;
+
+    return command;
+}
+
+// commands are stamped with the simulation tick they run on
+// recordings store the random seed followed by varint encoded commands
+class CommandStream
+{
+
+public:
+
+    static const std::uint32_t FILE_MAGIC   = 0x52424954; // "TIBR"
+    static const std::uint32_t FILE_VERSION = 2;
+
+    CommandStream()
+    {
+        m_replaySeed = 0;
+
+        m_replayIndex = 0;
+
+        m_recordTick = 0;
+    }
+
+    ~CommandStream()
+    {
+        stopRecording();
+    }
+
+    void push(const tibia::Command& command)
+    {
+        m_pendingList.push_back(command);
+    }
+
+    // moves every command due on or before tick into commandsList, replay commands first
+    void pop(unsigned int tick, std::vector<tibia::Command>& commandsList)
+    {
+        while (m_replayIndex < m_replayList.size() && m_replayList.at(m_replayIndex).tick <= tick)
+        {
+            commandsList.push_back(m_replayList.at(m_replayIndex));
+
+            m_replayIndex++;
+        }
+
+        for (auto& command : m_pendingList)
+        {
+            if (command.tick <= tick)
+            {
+                commandsList.push_back(command);
+            }
+        }
+
+        m_pendingList.erase
+        (
+            std::remove_if
+            (
+                m_pendingList.begin(),
+                m_pendingList.end(),
+                [tick](const tibia::Command& command)
+                {
+                    return command.tick <= tick;
+                }
+            ),
+            m_pendingList.end()
+        );
+    }
+
+    bool startRecording(std::string filename, std::uint64_t seed)
+    {
+        stopRecording();
+
+        m_recordFile.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (m_recordFile.is_open() == false)
+        {
+            return false;
+        }
+
+        tibia::BinaryStream::writeUint32(m_recordFile, FILE_MAGIC);
+        tibia::BinaryStream::writeUint32(m_recordFile, FILE_VERSION);
+        tibia::BinaryStream::writeUint64(m_recordFile, seed);
+
+        m_recordTick = 0;
+
+        return true;
+    }
+
+    void stopRecording()
+    {
+        if (m_recordFile.is_open() == true)
+        {
+            m_recordFile.close();
+        }
+    }
+
+    bool isRecording()
+    {
+        return m_recordFile.is_open();
+    }
+
+    void record(const tibia::Command& command)
+    {
+        if (m_recordFile.is_open() == false)
+        {
+            return;
+        }
+
+        tibia::BinaryStream::writeVarUint(m_recordFile, command.tick - m_recordTick);
+        tibia::BinaryStream::writeVarUint(m_recordFile, command.type);
+        tibia::BinaryStream::writeVarInt (m_recordFile, command.direction);
+        tibia::BinaryStream::writeVarInt (m_recordFile, command.projectileType);
+        tibia::BinaryStream::writeVarInt (m_recordFile, command.x);
+        tibia::BinaryStream::writeVarInt (m_recordFile, command.y);
+        tibia::BinaryStream::writeVarUint(m_recordFile, command.creatureId);
+
+        m_recordTick = command.tick;
+    }
+
+    bool loadReplay(std::string filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(file) != FILE_MAGIC)
+        {
+            return false;
+        }
+
+        // version 1 recordings only hold commands for the local player
+        std::uint32_t version = tibia::BinaryStream::readUint32(file);
+
+        if (version == 0 || version > FILE_VERSION)
+        {
+            return false;
+        }
+
+        m_replaySeed = tibia::BinaryStream::readUint64(file);
+
+        m_replayList.clear();
+
+        m_replayIndex = 0;
+
+        unsigned int tick = 0;
+
+        while (file.peek() != std::char_traits<char>::eof())
+        {
+            tibia::Command command;
+
+            tick += static_cast<unsigned int>(tibia::BinaryStream::readVarUint(file));
+
+            command.tick           = tick;
+            command.type           = static_cast<int>(tibia::BinaryStream::readVarUint(file));
+            command.direction      = static_cast<int>(tibia::BinaryStream::readVarInt(file));
+            command.projectileType = static_cast<int>(tibia::BinaryStream::readVarInt(file));
+            command.x              = static_cast<int>(tibia::BinaryStream::readVarInt(file));
+            command.y              = static_cast<int>(tibia::BinaryStream::readVarInt(file));
+            command.creatureId     = 0;
+
+            if (version >= 2)
+            {
+                command.creatureId = static_cast<int>(tibia::BinaryStream::readVarUint(file));
+            }
+
+            if (file.fail() == true)
+            {
+                break;
+            }
+
+            m_replayList.push_back(command);
+        }
+
+        return true;
+    }
+
+    bool isReplaying()
+    {
+        return m_replayIndex < m_replayList.size();
+    }
+
+    std::uint64_t getReplaySeed()
+    {
+        return m_replaySeed;
+    }
+
+    unsigned int getReplayLastTick()
+    {
+        if (m_replayList.size() == 0)
+        {
+            return 0;
+        }
+
+        return m_replayList.back().tick;
+    }
+
+    std::vector<tibia::Command>* getReplayList()
+    {
+        return &m_replayList;
+    }
+
+private:
+
+    std::vector<tibia::Command> m_pendingList;
+
+    std::vector<tibia::Command> m_replayList;
+
+    unsigned int m_replayIndex;
+
+    std::uint64_t m_replaySeed;
+
+    std::ofstream m_recordFile;
+
+    unsigned int m_recordTick;
+
+};
+
+}
+
+#endif // TIBIA_COMMAND_HPP
@@ -29,8 +29,21 @@ public:
 
         m_tileOffset = tibia::TILE_DRAW_OFFSET;
 
+        m_spawnId = 0;
+
         m_isPlayer = false;
 
+        m_isRemotePlayer = false;
+
+        m_isSitting = false;
+
+        m_isCold = false;
+
+        m_dirtyFlags = tibia::CreatureDirtyFlags::all;
+
+        m_updatedX = -1;
+        m_updatedY = -1;
+
         m_distanceFromPlayer = 0;
 
         m_direction = tibia::Directions::down;
@@ -52,6 +65,8 @@ public:
         m_isDead     = false;
         m_hasDecayed = false;
 
+        m_movementReady = true;
+
         m_hasOutfit = true;
 
         m_outfitHead = 0;
@@ -64,6 +79,8 @@ public:
 
     void setPropertiesByType()
     {
+        m_dirtyFlags = tibia::CreatureDirtyFlags::all;
+
         if (m_type != tibia::CreatureTypes::human)
         {
             m_hasOutfit = false;
@@ -178,7 +195,7 @@ public:
         m_outfitLegs = legs;
         m_outfitFeet = feet;
 
-        updateOutfit();
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     void setOutfitRandom()
@@ -188,7 +205,7 @@ public:
         m_outfitLegs = tibia::getRandomNumber(0, (tibia::Outfits::legs.size() / 4) - 1);
         m_outfitFeet = tibia::getRandomNumber(0, (tibia::Outfits::feet.size() / 4) - 1);
 
-        updateOutfit();
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     void updateOutfit()
@@ -199,60 +216,103 @@ public:
         m_spriteOutfitFeet.setId(tibia::Outfits::feet[(m_outfitFeet * 4) + m_direction]);
     }
 
-    void updateCorpse()
+    // moves the corpse on to its next stage, returns false once it has decayed
+    bool advanceCorpse()
     {
         if (isDead() == false)
         {
-            return;
+            return false;
         }
 
-        m_timeCorpse = m_clockCorpse.getElapsedTime();
+        int corpseId = m_spriteCorpse.getId();
 
-        if (m_timeCorpse.asSeconds() >= tibia::AnimationTimes::decal)
+        if (corpseId == 0)
         {
-            int corpseId = m_spriteCorpse.getId();
+            m_spriteCorpse.setId(tibia::SpriteData::corpse[0]);
+        }
 
-            if (corpseId == 0)
-            {
-                m_spriteCorpse.setId(tibia::SpriteData::corpse[0]);
-            }
+        if (corpseId >= tibia::SpriteData::corpse[0] && corpseId < tibia::SpriteData::corpse[6])
+        {
+            m_spriteCorpse.setId(corpseId + 1);
+        }
+        else if (corpseId == tibia::SpriteData::corpse[6])
+        {
+            setHasDecayed(true);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // only rebuilds what changed since the last update, a cold creature keeps its tile coords current
+    // but leaves its transform and sprites dirty until it is warm again, returns true if it moved
+    bool update()
+    {
+        bool hasMoved = false;
+
+        if (getX() != m_updatedX || getY() != m_updatedY)
+        {
+            hasMoved = true;
+
+            updateTileCoords();
+
+            m_updatedX = getX();
+            m_updatedY = getY();
+
+            m_dirtyFlags |= tibia::CreatureDirtyFlags::position;
+        }
+
+        if (m_isCold == true || m_dirtyFlags == 0)
+        {
+            return hasMoved;
+        }
+
+        if (m_dirtyFlags & (tibia::CreatureDirtyFlags::position | tibia::CreatureDirtyFlags::death))
+        {
+            int tileOffset = m_tileOffset;
 
-            if (corpseId >= tibia::SpriteData::corpse[0] && corpseId < tibia::SpriteData::corpse[6])
+            if (m_isSitting == true)
             {
-                m_spriteCorpse.setId(corpseId + 1);
+                tileOffset *= 2;
             }
-            else if (corpseId == tibia::SpriteData::corpse[6])
+
+            if (m_isDead == true || m_size == tibia::CreatureSizes::large)
             {
-                setHasDecayed(true);
+                tileOffset = 0;
             }
 
-            m_clockCorpse.restart();
+            setPosition(getTileX() - tileOffset, getTileY() - tileOffset);
         }
-    }
 
-    void update()
-    {
-        updateTileCoords();
-
-        int tileOffset = m_tileOffset;
-
-        if (m_isSitting == true)
+        if (m_dirtyFlags & tibia::CreatureDirtyFlags::direction)
         {
-            tileOffset *= 2;
+            updateSprite();
         }
 
-        if (m_isDead == true || m_size == tibia::CreatureSizes::large)
+        if (m_dirtyFlags & (tibia::CreatureDirtyFlags::direction | tibia::CreatureDirtyFlags::outfit))
         {
-            tileOffset = 0;
+            updateOutfit();
         }
 
-        setPosition(getTileX() - tileOffset, getTileY() - tileOffset);
+        m_dirtyFlags = 0;
 
-        updateSprite();
+        return hasMoved;
+    }
 
-        updateOutfit();
+    int getDirtyFlags()
+    {
+        return m_dirtyFlags;
+    }
 
-        updateCorpse();
+    bool isCold()
+    {
+        return m_isCold;
+    }
+
+    void setIsCold(bool b)
+    {
+        m_isCold = b;
     }
 
     void doTurn(int direction)
@@ -293,18 +353,12 @@ public:
         setDirection(dir);
     }
 
-    void doMove(int direction)
+    // movement is ready again once the movement speed has passed, returns false if it was not ready
+    bool doMove(int direction)
     {
-        m_timeMovement = m_clockMovement.getElapsedTime();
-
-        if (m_timeMovement.asSeconds() >= m_movementSpeed)
-        {
-            m_movementReady = true;
-        }
-
         if (m_movementReady == false)
         {
-            return;
+            return false;
         }
 
         int x = getX();
@@ -320,14 +374,14 @@ public:
                 break;
 
             case tibia::Directions::right:
-                if (x != MAP_XY_MAX - 1)
+                if (x != tibia::MapSize::width - 1)
                 {
                     setX(x + 1);
                 }
                 break;
 
             case tibia::Directions::down:
-                if (y != MAP_XY_MAX - 1)
+                if (y != tibia::MapSize::height - 1)
                 {
                     setY(y + 1);
                 }
@@ -349,7 +403,7 @@ public:
                 break;
 
             case tibia::Directions::upRight:
-                if (y != 0 && x != MAP_XY_MAX - 1)
+                if (y != 0 && x != tibia::MapSize::width - 1)
                 {
                     setY(y - 1);
                     setX(x + 1);
@@ -357,7 +411,7 @@ public:
                 break;
 
             case tibia::Directions::downLeft:
-                if (y != MAP_XY_MAX - 1 && x != 0)
+                if (y != tibia::MapSize::height - 1 && x != 0)
                 {
                     setY(y + 1);
                     setX(x - 1);
@@ -365,7 +419,7 @@ public:
                 break;
 
             case tibia::Directions::downRight:
-                if (y != MAP_XY_MAX - 1 && x != MAP_XY_MAX - 1)
+                if (y != tibia::MapSize::height - 1 && x != tibia::MapSize::width - 1)
                 {
                     setY(y + 1);
                     setX(x + 1);
@@ -375,7 +429,7 @@ public:
 
         m_movementReady = false;
 
-        m_clockMovement.restart();
+        return true;
     }
 
     void takeDamage(int damage)
@@ -406,11 +460,11 @@ public:
     {
         m_isDead = b;
 
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::death;
+
         if (m_isDead == true)
         {
             m_spriteCorpse.setId(tibia::SpriteData::corpse[0]);
-
-            m_clockCorpse.restart();
         }
     }
 
@@ -419,6 +473,26 @@ public:
         return m_hasDecayed;
     }
 
+    int getSpawnId()
+    {
+        return m_spawnId;
+    }
+
+    void setSpawnId(int spawnId)
+    {
+        m_spawnId = spawnId;
+    }
+
+    int getCorpseId()
+    {
+        return m_spriteCorpse.getId();
+    }
+
+    void setCorpseId(int id)
+    {
+        m_spriteCorpse.setId(id);
+    }
+
     void setHasDecayed(bool b)
     {
         m_hasDecayed = b;
@@ -432,6 +506,8 @@ public:
     void setTileOffset(int offset)
     {
         m_tileOffset = offset;
+
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::position;
     }
 
     bool isPlayer()
@@ -444,6 +520,17 @@ public:
         m_isPlayer = b;
     }
 
+    // controlled by a client of the server instead of the creature logic
+    bool isRemotePlayer()
+    {
+        return m_isRemotePlayer;
+    }
+
+    void setIsRemotePlayer(bool b)
+    {
+        m_isRemotePlayer = b;
+    }
+
     float getDistanceFromPlayer()
     {
         return m_distanceFromPlayer;
@@ -461,6 +548,11 @@ public:
 
     void setIsSitting(bool b)
     {
+        if (m_isSitting != b)
+        {
+            m_dirtyFlags |= tibia::CreatureDirtyFlags::position;
+        }
+
         m_isSitting = b;
     }
 
@@ -482,6 +574,8 @@ public:
     void setType(int type)
     {
         m_type = type;
+
+        m_dirtyFlags = tibia::CreatureDirtyFlags::all;
     }
 
     int getSize()
@@ -492,6 +586,8 @@ public:
     void setSize(int size)
     {
         m_size = size;
+
+        m_dirtyFlags = tibia::CreatureDirtyFlags::all;
     }
 
     int getDirection()
@@ -501,6 +597,11 @@ public:
 
     void setDirection(int direction)
     {
+        if (m_direction != direction)
+        {
+            m_dirtyFlags |= tibia::CreatureDirtyFlags::direction;
+        }
+
         m_direction = direction;
     }
 
@@ -582,6 +683,8 @@ public:
     void setHasOutfit(bool b)
     {
         m_hasOutfit = b;
+
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     int getOutfitHead()
@@ -592,6 +695,8 @@ public:
     void setOutfitHead(int head)
     {
         m_outfitHead = head;
+
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     int getOutfitBody()
@@ -602,6 +707,8 @@ public:
     void setOutfitBody(int body)
     {
         m_outfitBody = body;
+
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     int getOutfitLegs()
@@ -612,6 +719,8 @@ public:
     void setOutfitLegs(int legs)
     {
         m_outfitLegs = legs;
+
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     int getOutfitFeet()
@@ -622,6 +731,8 @@ public:
     void setOutfitFeet(int feet)
     {
         m_outfitFeet = feet;
+
+        m_dirtyFlags |= tibia::CreatureDirtyFlags::outfit;
     }
 
     tibia::Sprite* getSpriteOutfitHead()
@@ -666,14 +777,25 @@ public:
 
 private:
 
+    int m_spawnId;
+
     int m_tileOffset;
 
     bool m_isPlayer;
 
+    bool m_isRemotePlayer;
+
     float m_distanceFromPlayer;
 
     bool m_isSitting;
 
+    bool m_isCold;
+
+    int m_dirtyFlags;
+
+    int m_updatedX;
+    int m_updatedY;
+
     int m_type;
 
     int m_size;
@@ -709,9 +831,6 @@ private:
     bool m_isDead;
     bool m_hasDecayed;
 
-    sf::Clock m_clockCorpse;
-    sf::Time m_timeCorpse;
-
     std::vector<int> m_spritesList;
     std::vector<int> m_spritesCorpseList;
 
@@ -730,9 +849,6 @@ private:
     tibia::Sprite m_spriteOutfitLegs;
     tibia::Sprite m_spriteOutfitFeet;
 
-    sf::Clock m_clockMovement;
-    sf::Time m_timeMovement;
-
     tibia::Creature* m_attacker;
 
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const
@@ -0,0 +1,27 @@
+#ifndef TIBIA_FLOATINGTEXT_HPP
+#define TIBIA_FLOATINGTEXT_HPP
+
+#include <SFML/Graphics.hpp>
+
+namespace tibia
+{
+
+// plain data so floating texts can live in a reserved vector and be reused without allocating
+struct FloatingText
+{
+    static const int TEXT_LENGTH_MAX = 16;
+
+    char text[TEXT_LENGTH_MAX];
+
+    int x;
+    int y;
+    int z;
+
+    sf::Color color;
+
+    float timeSpawned;
+};
+
+}
+
+#endif // TIBIA_FLOATINGTEXT_HPP
@@ -0,0 +1,175 @@
+#ifndef TIBIA_FRAMEARENA_HPP
+#define TIBIA_FRAMEARENA_HPP
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+#include "tibia/Tibia.hpp"
+
+namespace tibia
+{
+
+// bump allocator for data that only lives until the end of the frame, nothing is freed until reset().
+// a frame that needs more than the arena holds spills to the heap and the arena grows on reset,
+// so after the first few frames the arena is big enough and a frame makes no heap allocations
+class FrameArena
+{
+
+public:
+
+    FrameArena(std::size_t size = tibia::FRAME_ARENA_SIZE)
+    {
+        m_buffer.resize(size);
+
+        m_offset = 0;
+
+        m_numBytesSpilled = 0;
+
+        m_highWaterMark = 0;
+
+        m_numSpills = 0;
+    }
+
+    ~FrameArena()
+    {
+        freeSpills();
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        std::size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+        if (offset + size <= m_buffer.size())
+        {
+            m_offset = offset + size;
+
+            return &m_buffer[offset];
+        }
+
+        m_numBytesSpilled += size;
+
+        m_numSpills++;
+
+        m_spillsList.push_back(::operator new(size));
+
+        return m_spillsList.back();
+    }
+
+    // everything allocated since the last reset is released at once
+    void reset()
+    {
+        m_highWaterMark = std::max(m_highWaterMark, m_offset + m_numBytesSpilled);
+
+        if (m_numBytesSpilled != 0)
+        {
+            freeSpills();
+
+            m_buffer.assign(std::max(m_buffer.size() * 2, m_offset + m_numBytesSpilled), 0);
+        }
+
+        m_offset = 0;
+
+        m_numBytesSpilled = 0;
+    }
+
+    std::size_t getSize()
+    {
+        return m_buffer.size();
+    }
+
+    std::size_t getHighWaterMark()
+    {
+        return m_highWaterMark;
+    }
+
+    unsigned int getNumSpills()
+    {
+        return m_numSpills;
+    }
+
+private:
+
+    void freeSpills()
+    {
+        for (auto spill : m_spillsList)
+        {
+            ::operator delete(spill);
+        }
+
+        m_spillsList.clear();
+    }
+
+    std::vector<char> m_buffer;
+
+    std::size_t m_offset;
+
+    std::size_t m_numBytesSpilled;
+
+    std::size_t m_highWaterMark;
+
+    unsigned int m_numSpills;
+
+    std::vector<void*> m_spillsList;
+
+};
+
+// lets standard containers allocate from a frame arena, deallocate does nothing
+template <typename T>
+class FrameAllocator
+{
+
+public:
+
+    typedef T value_type;
+
+    FrameAllocator(tibia::FrameArena* arena)
+    {
+        m_arena = arena;
+    }
+
+    template <typename U>
+    FrameAllocator(const tibia::FrameAllocator<U>& allocator)
+    {
+        m_arena = allocator.getArena();
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // the memory is given back all at once when the arena is reset
+    void deallocate(T*, std::size_t)
+    {
+    }
+
+    tibia::FrameArena* getArena() const
+    {
+        return m_arena;
+    }
+
+private:
+
+    tibia::FrameArena* m_arena;
+
+};
+
+template <typename T, typename U>
+bool operator==(const tibia::FrameAllocator<T>& a, const tibia::FrameAllocator<U>& b)
+{
+    return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const tibia::FrameAllocator<T>& a, const tibia::FrameAllocator<U>& b)
+{
+    return a.getArena() != b.getArena();
+}
+
+template <typename T>
+using FrameVector = std::vector<T, tibia::FrameAllocator<T>>;
+
+}
+
+#endif // TIBIA_FRAMEARENA_HPP
@@ -1,10 +1,16 @@
 #ifndef TIBIA_GAME_HPP
 #define TIBIA_GAME_HPP
 
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <unordered_map>
 
 #include <boost/algorithm/string.hpp>
 
@@ -21,6 +27,22 @@
 #include "tibia/Creature.hpp"
 #include "tibia/Animation.hpp"
 #include "tibia/Projectile.hpp"
+#include "tibia/CombatLog.hpp"
+#include "tibia/Profiler.hpp"
+#include "tibia/Command.hpp"
+#include "tibia/AssetLoader.hpp"
+#include "tibia/TextCache.hpp"
+#include "tibia/FloatingText.hpp"
+#include "tibia/TimerWheel.hpp"
+#include "tibia/SpatialGrid.hpp"
+#include "tibia/InterestManager.hpp"
+#include "tibia/SoundMixer.hpp"
+#include "tibia/SoundBank.hpp"
+#include "tibia/FrameArena.hpp"
+#include "tibia/MemoryTracker.hpp"
+#include "tibia/ObjectIndex.hpp"
+#include "tibia/ChunkTextureCache.hpp"
+#include "tibia/StateStream.hpp"
 
 namespace tibia
 {
@@ -35,19 +57,60 @@ public:
     typedef std::shared_ptr<tibia::Animation>  AnimationPtr;
     typedef std::shared_ptr<tibia::Projectile> ProjectilePtr;
 
-    typedef std::shared_ptr<sf::Sound> SoundPtr;
+
+    struct TimerEvent
+    {
+        int type;
+
+        std::weak_ptr<tibia::Thing> thing;
+    };
+
+    typedef tibia::TimerWheel<TimerEvent> TimerWheel;
+
+    static const std::uint32_t SNAPSHOT_FILE_MAGIC   = 0x53424954; // "TIBS"
+    static const std::uint32_t SNAPSHOT_FILE_VERSION = 1;
 
     Game()
     :
         m_windowView(sf::FloatRect(0, 0, tibia::GuiData::gameWindowWidth, tibia::GuiData::gameWindowHeight)),
         m_miniMapWindowView(sf::FloatRect(0, 0, tibia::GuiData::gameWindowWidth * 2, tibia::GuiData::gameWindowHeight * 2))
     {
+        m_tick = 0;
+
+        m_showCreatureNames = true;
+
+        m_tickTextExpiry = 0;
+
+        m_hasFinishedAnimations = false;
+
+        m_hasDecayedCreatures = false;
+
+        m_creaturesWarmListIsDirty = true;
+
+        m_playerHasMoved = true;
+
+        m_isViewLod = false;
+
+        m_statePublisher = nullptr;
+
+        m_isSpectating = false;
+
+        m_nextCreatureSpawnId = 1;
+
+        m_numChunksBaked = 0;
+
+        m_floatingTextsList.reserve(tibia::FLOATING_TEXTS_MAX);
+
         m_tileVertices.setPrimitiveType(sf::Quads);
 
-        m_rtLight.create(MAP_TILE_XY_MAX, MAP_TILE_XY_MAX);
+        m_rtLight.create(tibia::LIGHT_WIDTH, tibia::LIGHT_HEIGHT);
+
+        m_rtChunk.create(tibia::LOD_CHUNK_SIZE * tibia::LOD_TILE_SIZE, tibia::LOD_CHUNK_SIZE * tibia::LOD_TILE_SIZE);
+
+        m_chunkVertices.setPrimitiveType(sf::Quads);
 
         m_rectLight.setPosition(0, 0);
-        m_rectLight.setSize(sf::Vector2f(MAP_TILE_XY_MAX, MAP_TILE_XY_MAX));
+        m_rectLight.setSize(sf::Vector2f(tibia::LIGHT_WIDTH, tibia::LIGHT_HEIGHT));
 
         CreaturePtr player = std::make_shared<tibia::Creature>(0, 0, tibia::ZAxis::ground);
         player->setName("Player");
@@ -62,6 +125,40 @@ public:
         m_player = player;
 
         spawnCreature(m_player);
+
+        m_creaturesGrid.setListener(&m_interestManager);
+
+        m_localObserverId = m_interestManager.addObserver(sf::IntRect(0, 0, 0, 0));
+
+        tibia::setRandom(&m_random);
+    }
+
+    ~Game()
+    {
+        if (tibia::getRandom() == &m_random)
+        {
+            tibia::setRandom(nullptr);
+        }
+    }
+
+    void setRandomSeed(std::uint64_t seed)
+    {
+        m_random.setSeed(seed);
+    }
+
+    std::uint64_t getRandomSeed()
+    {
+        return m_random.getSeed();
+    }
+
+    tibia::Random* getRandom()
+    {
+        return &m_random;
+    }
+
+    tibia::Random getRandomStream(int index)
+    {
+        return m_random.getStream(index);
     }
 
     bool createWindows()
@@ -89,51 +186,84 @@ public:
         return true;
     }
 
-    bool loadTextures()
+    void loadTextures(tibia::AssetLoader* assetLoader)
     {
-        if (tibia::Textures::sprites.loadFromFile("images/sprites.png") == false)
-        {
-            return false;
-        }
+        assetLoader->addImage(&tibia::Images::sprites, "images/sprites.png");
 
-        if (tibia::Textures::font.loadFromFile("images/font.png") == false)
-        {
-            return false;
-        }
+        assetLoader->addImage(&tibia::Images::font,  "images/font.png");
+        assetLoader->addImage(&tibia::Images::font2, "images/font2.png");
 
-        if (tibia::Textures::font2.loadFromFile("images/font2.png") == false)
-        {
-            return false;
-        }
+        assetLoader->addImage(&tibia::Images::light,  "images/light.png");
+        assetLoader->addImage(&tibia::Images::light2, "images/light2.png");
+        assetLoader->addImage(&tibia::Images::light3, "images/light3.png");
+        assetLoader->addImage(&tibia::Images::light4, "images/light4.png");
+        assetLoader->addImage(&tibia::Images::light5, "images/light5.png");
+    }
 
-        if (tibia::Textures::light.loadFromFile("images/light.png") == false)
-        {
-            return false;
-        }
+    // must run on the thread that owns the OpenGL context once the images are loaded
+    bool loadTextureAtlas()
+    {
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::sprites, &tibia::Images::sprites);
 
-        if (tibia::Textures::light2.loadFromFile("images/light2.png") == false)
-        {
-            return false;
-        }
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::font,  &tibia::Images::font);
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::font2, &tibia::Images::font2);
 
-        if (tibia::Textures::light3.loadFromFile("images/light3.png") == false)
-        {
-            return false;
-        }
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::light,  &tibia::Images::light);
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::light2, &tibia::Images::light2);
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::light3, &tibia::Images::light3);
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::light4, &tibia::Images::light4);
+        tibia::Textures::atlas.add(tibia::TextureAtlasRegions::light5, &tibia::Images::light5);
 
-        if (tibia::Textures::light4.loadFromFile("images/light4.png") == false)
+        if (tibia::Textures::atlas.build() == false)
         {
             return false;
         }
 
-        if (tibia::Textures::light5.loadFromFile("images/light5.png") == false)
-        {
-            return false;
-        }
+        tibia::loadSpriteRects();
+
+        // both fonts are printable ascii from space onwards, the number of characters per row is the width of the image
+        tibia::BitmapFonts::font.load
+        (
+            tibia::Textures::atlas.getTexture(tibia::TextureAtlasRegions::font),
+            tibia::Textures::atlas.getRect(tibia::TextureAtlasRegions::font),
+            tibia::BitmapFontData::characterSize,
+            tibia::BitmapFontData::firstCharacter
+        );
+
+        tibia::BitmapFonts::font2.load
+        (
+            tibia::Textures::atlas.getTexture(tibia::TextureAtlasRegions::font2),
+            tibia::Textures::atlas.getRect(tibia::TextureAtlasRegions::font2),
+            tibia::BitmapFontData::characterSize,
+            tibia::BitmapFontData::firstCharacter
+        );
+
+        tibia::Images::sprites = sf::Image();
+
+        tibia::Images::font  = sf::Image();
+        tibia::Images::font2 = sf::Image();
+
+        tibia::Images::light  = sf::Image();
+        tibia::Images::light2 = sf::Image();
+        tibia::Images::light3 = sf::Image();
+        tibia::Images::light4 = sf::Image();
+        tibia::Images::light5 = sf::Image();
 
         return true;
     }
 
+    // everything except fonts and windows, which are needed to draw the loading screen
+    void loadAssets(tibia::AssetLoader* assetLoader, std::string mapFilename)
+    {
+        loadTextures(assetLoader);
+
+        assetLoader->addTask("sprite flags", [this]() { loadSpriteFlags(); return true; });
+
+        assetLoader->addTask("sounds", [this]() { return loadSounds(); });
+
+        assetLoader->addTask(mapFilename, [this, mapFilename]() { return loadMap(mapFilename); });
+    }
+
     bool loadFonts()
     {
         if (m_font.loadFromFile(tibia::Fonts::default) == false)
@@ -154,19 +284,48 @@ public:
         return true;
     }
 
+    // sounds are optional, a missing bank or source file only leaves the sound silent
     bool loadSounds()
     {
-        //if (tibia::Sounds::death.loadFromFile("sounds/everquest/snd1/death_m.wav") == false)
-        //{
-            //return false;
-        //}
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::audio);
+
+        std::vector<tibia::SoundBank::Source> sourcesList;
+        sourcesList.push_back(tibia::SoundBank::makeSource("death", "sounds/everquest/snd1/death_m.wav"));
+
+        if (m_soundBank.open(tibia::Sounds::bank, sourcesList) == false)
+        {
+            std::cout << "Creating sound bank: " << tibia::Sounds::bank << std::endl;
+
+            if (tibia::SoundBank::create(tibia::Sounds::bank, sourcesList) == false || m_soundBank.open(tibia::Sounds::bank, sourcesList) == false)
+            {
+                std::cout << "Warning: Failed to create sound bank: " << tibia::Sounds::bank << std::endl;
+                return true;
+            }
+        }
+
+        tibia::Sounds::death = m_soundBank.getBuffer("death");
 
         return true;
     }
 
     bool loadMap(std::string filename)
     {
-        return m_map.load(filename);
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::map);
+
+        if (m_map.load(filename) == false)
+        {
+            return false;
+        }
+
+        m_creaturesGrid.create(tibia::MapSize::width, tibia::MapSize::height);
+
+        m_interestManager.create(&m_creaturesGrid);
+
+        m_animatedDecalsGrid.create(tibia::MapSize::width, tibia::MapSize::height);
+
+        m_chunkTextureCache.clear();
+
+        return true;
     }
 
     void loadCreatures()
@@ -177,14 +336,40 @@ public:
     void loadObjects()
     {
         m_objectsList = *m_map.getObjectsList();
+
+        // objects never move so their positions are set once here instead of every tick.
+        // the map is loaded before the texture atlas is built, so the sprite rects are set again now
+        for (auto object : m_objectsList)
+        {
+            object->setId(object->getId());
+
+            object->update();
+        }
+
+        m_objectIndex.build(m_objectsList, tibia::MapSize::width, tibia::MapSize::height, m_map.getFloorZMin(), m_map.getFloorZMax());
     }
 
+    // runs on a loader thread, the flags are only computed here and copied by applySpriteFlags
     void loadSpriteFlags()
     {
+        m_spriteFlagsList.assign(tibia::SPRITES_TOTAL + 1, 0);
+
         for (unsigned int i = 1; i < tibia::SPRITES_TOTAL + 1; i++)
         {
-            tibia::spriteFlags[i] = tibia::getSpriteFlags(i);
+            m_spriteFlagsList[i] = tibia::getSpriteFlags(i);
+        }
+    }
+
+    // runs on the main thread once the asset loader is finished, since tibia::spriteFlags is read without locking
+    void applySpriteFlags()
+    {
+        for (unsigned int i = 1; i < m_spriteFlagsList.size(); i++)
+        {
+            tibia::spriteFlags[i] = m_spriteFlagsList.at(i);
         }
+
+        m_spriteFlagsList.clear();
+        m_spriteFlagsList.shrink_to_fit();
     }
 
     void handleKeyboardInput()
@@ -197,155 +382,1318 @@ public:
         //
     }
 
-    bool handleCreatureDamage(tibia::Creature* attacker, tibia::Creature* defender, int damage, int* animationOnHit, int* animatedDecalOnHit, int* animatedDecalOnKill)
+    void queueCommand(tibia::Command command)
     {
-        if (attacker == nullptr || defender == nullptr)
+        if (m_commandStream.isReplaying() == true)
         {
-            return false;
+            return;
         }
 
-        if (attacker == defender)
-        {
-            return false;
-        }
+        command.tick = m_tick;
 
-        if (attacker->getTeam() == defender->getTeam())
-        {
-            return false;
-        }
+        m_commandStream.push(command);
+    }
 
-        if (defender->getTeam() == tibia::Teams::neutral)
-        {
-            return false;
-        }
+    void executeCommands()
+    {
+        m_commandsList.clear();
 
-        defender->takeDamageFromCreature(attacker, damage);
+        m_commandStream.pop(m_tick, m_commandsList);
 
-        spawnAnimation
-        (
-            defender->getTileX(),
-            defender->getTileY(),
-            defender->getZ(),
-            animationOnHit
-        );
+        // the creatures of remote players are looked up once for the whole batch
+        bool hasRemoteCommands = false;
 
-        std::cout
-            << attacker->getName()
-            << " hit "
-            << defender->getName()
-            << " for "
-            << damage
-            << " damage."
-            << std::endl;
+        for (auto& command : m_commandsList)
+        {
+            if (command.creatureId != 0)
+            {
+                hasRemoteCommands = true;
+                break;
+            }
+        }
 
-        if (defender->isDead() == false)
+        if (hasRemoteCommands == true)
         {
-            spawnAnimatedDecal
-            (
-                defender->getTileX(),
-                defender->getTileY(),
-                defender->getZ(),
-                animatedDecalOnHit,
-                tibia::AnimationTimes::decal
-            );
+            m_commandCreaturesList.clear();
+
+            for (auto creature : m_creaturesList)
+            {
+                m_commandCreaturesList[creature->getSpawnId()] = creature.get();
+            }
+
+            for (auto creature : m_creaturesSpawnList)
+            {
+                m_commandCreaturesList[creature->getSpawnId()] = creature.get();
+            }
         }
-        else
+
+        for (auto& command : m_commandsList)
         {
-            //SoundPtr sound = std::make_shared<sf::Sound>();
-            //sound->setBuffer(tibia::Sounds::death);
-            //sound->setVolume(tibia::calculateVolumeByDistance(creature->getDistanceFromPlayer()));
-            //spawnSound(sound);
+            command.tick = m_tick;
 
-            spawnAnimatedDecal
-            (
-                defender->getTileX(),
-                defender->getTileY(),
-                defender->getZ(),
-                animatedDecalOnKill,
-                tibia::AnimationTimes::decal
-            );
+            m_commandStream.record(command);
 
-            if (defender->isPlayer() == true)
+            tibia::Creature* creature = m_player.get();
+
+            if (command.creatureId != 0)
             {
-                showGameText("You are dead.", tibia::FontSizes::game, tibia::Colors::white);
+                auto commandCreaturesList_it = m_commandCreaturesList.find(command.creatureId);
+
+                if (commandCreaturesList_it == m_commandCreaturesList.end() || commandCreaturesList_it->second->isDead() == true)
+                {
+                    continue;
+                }
+
+                creature = commandCreaturesList_it->second;
             }
 
-            std::cout
-                << attacker->getName()
-                << " killed "
-                << defender->getName()
-                << std::endl;
+            executeCommand(command, creature);
         }
-
-        return true;
     }
 
-    bool handleCreatureMovement(tibia::Creature* creature, int direction, bool turnOnly = false)
+    void executeCommand(const tibia::Command& command, tibia::Creature* player)
     {
-        bool collisionOccured = false;
+        sf::Vector2f playerTilePosition(player->getTileX(), player->getTileY());
 
-        if (creature->isDead() == true)
+        switch (command.type)
         {
-            return true;
-        }
+            case tibia::CommandTypes::move:
+                handleCreatureMovement(player, command.direction);
+                break;
 
-        if (turnOnly == false)
-        {
-            if (checkMovementCollision(creature, direction) == false)
+            case tibia::CommandTypes::turn:
+                handleCreatureMovement(player, command.direction, true);
+                break;
+
+            case tibia::CommandTypes::spawnProjectile:
+                spawnProjectile
+                (
+                    player,
+                    command.projectileType,
+                    command.direction,
+                    playerTilePosition,
+                    sf::Vector2f
+                    (
+                        playerTilePosition.x + (tibia::getVectorByDirection(command.direction).x * tibia::TILE_SIZE),
+                        playerTilePosition.y + (tibia::getVectorByDirection(command.direction).y * tibia::TILE_SIZE)
+                    )
+                );
+                break;
+
+            case tibia::CommandTypes::spawnProjectilesAllDirections:
+                for (int i = tibia::Directions::begin; i < tibia::Directions::end + 1; i++)
+                {
+                    spawnProjectile
+                    (
+                        player,
+                        command.projectileType,
+                        i,
+                        playerTilePosition,
+                        sf::Vector2f
+                        (
+                            playerTilePosition.x + (tibia::getVectorByDirection(i).x * tibia::TILE_SIZE),
+                            playerTilePosition.y + (tibia::getVectorByDirection(i).y * tibia::TILE_SIZE)
+                        )
+                    );
+                }
+                break;
+
+            case tibia::CommandTypes::use:
             {
-                if (checkMovementMoveAboveOrBelow(creature, direction) == true)
+                sf::Vector2u tilePosition(command.x, command.y);
+
+                if (doCreatureUseLadder(player, tilePosition) == true)
                 {
-                    return false;
+                    break;
                 }
 
-                checkMovementStepTile(creature, direction, true);
+                if (doCreatureUseLever(player, tilePosition) == true)
+                {
+                    break;
+                }
 
-                creature->doMove(direction);
+                if (player->getTileNumber() == tibia::getTileNumberByTileCoords(tilePosition.x, tilePosition.y))
+                {
+                    break;
+                }
 
-                checkMovementStepTile(creature, direction, false);
-            }
-            else
-            {
-                collisionOccured == true;
+                spawnProjectile
+                (
+                    player,
+                    tibia::ProjectileTypes::arrow,
+                    player->getDirection(),
+                    playerTilePosition,
+                    sf::Vector2f(tilePosition.x, tilePosition.y),
+                    true
+                );
+                break;
             }
-        }
 
-        creature->doTurn(direction);
+            case tibia::CommandTypes::setOutfitRandom:
+                player->setOutfitRandom();
+                break;
 
-        creature->setIsSitting(checkCreatureIsSitting(creature));
+            case tibia::CommandTypes::setOutfitRandomAll:
+                for (auto creature : m_creaturesList)
+                {
+                    creature->setOutfitRandom();
+                }
+                break;
 
-        return collisionOccured;
+            case tibia::CommandTypes::setZRandom:
+                player->setZ(tibia::getRandomNumber(m_map.getFloorZMin(), m_map.getFloorZMax()));
+                break;
+
+            case tibia::CommandTypes::spawnAnimation:
+                spawnAnimation(player->getTileX(), player->getTileY(), player->getZ(), tibia::Animations::spellBlue, 1.0);
+                break;
+
+            case tibia::CommandTypes::spawnAnimatedDecal:
+                spawnAnimatedDecal(player->getTileX(), player->getTileY(), player->getZ(), tibia::AnimatedDecals::poolRed, 30.0);
+                spawnAnimatedDecal(player->getTileX(), player->getTileY(), player->getZ(), tibia::AnimatedDecals::corpse,  30.0);
+                break;
+        }
     }
 
-    void doCreatureLogic()
+    // the chunks around the player and every living creature stay loaded, the rest are evicted
+    void doChunkResidency()
     {
+        std::vector<sf::Vector3i> chunkPositionsList;
+
+        chunkPositionsList.push_back(sf::Vector3i(m_player->getX(), m_player->getY(), tibia::TILE_CHUNKS_RESIDENT_RADIUS));
+
         for (auto creature : m_creaturesList)
         {
-            if (creature->isPlayer() == true)
+            if (creature->isDead() == true || creature.get() == m_player.get())
             {
                 continue;
             }
 
-            if (creature->isDead() == true)
-            {
-                continue;
-            }
+            chunkPositionsList.push_back(sf::Vector3i(creature->getX(), creature->getY(), 0));
+        }
 
-            int random = 0;
+        m_map.updateChunks(chunkPositionsList);
+    }
 
-            if (m_creaturesList.size() > tibia::CREATURES_MAX_LOAD)
-            {
-                random = tibia::getRandomNumber(1, 100);
+    // one fixed step of the simulation, nothing in here may read the wall clock
+    void doTick()
+    {
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updateTimers);
 
-                if (random > 50)
-                {
-                    continue;
-                }
-            }
+            updateTimers();
+        }
 
-            random = tibia::getRandomNumber(1, 100);
+        executeCommands();
 
-            if (random > 50)
+        if (m_tick != 0 && m_tick % tibia::TICKS_PER_SECOND == 0)
+        {
+            {
+                tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::doAnimatedWaterAndObjects);
+
+                doAnimatedWater();
+                doAnimatedObjects();
+            }
+
+            {
+                tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::doCreatureLogic);
+
+                doCreatureLogic();
+            }
+
+            doChunkResidency();
+        }
+
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updateAnimatedDecals);
+
+            updateAnimatedDecals();
+        }
+
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updatePlayer);
+
+            updatePlayer();
+        }
+
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updateCreatures);
+
+            updateCreatures();
+        }
+
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updateObjects);
+
+            updateObjects();
+        }
+
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updateProjectiles);
+
+            updateProjectiles();
+        }
+
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::updateAnimations);
+
+            updateAnimations();
+        }
+
+        updateFloatingTexts();
+
+        publishState();
+
+        m_tick++;
+    }
+
+    // FNV-1a over the simulation state, used to compare a replay against its recording
+    std::uint64_t getStateChecksum()
+    {
+        std::uint64_t checksum = 0xCBF29CE484222325ULL;
+
+        auto addValue = [&checksum](std::int64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                checksum ^= static_cast<std::uint64_t>(value >> (i * 8)) & 0xFF;
+                checksum *= 0x100000001B3ULL;
+            }
+        };
+
+        addValue(m_tick);
+
+        for (auto creature : m_creaturesList)
+        {
+            addValue(creature->getX());
+            addValue(creature->getY());
+            addValue(creature->getZ());
+            addValue(creature->getDirection());
+            addValue(creature->getHp());
+            addValue(creature->isDead());
+        }
+
+        addValue(m_projectilesList.size());
+        addValue(m_animatedDecalsList.size());
+
+        return checksum;
+    }
+
+    tibia::StateCreature getStateCreature(tibia::Creature* creature)
+    {
+        tibia::StateCreature stateCreature;
+        stateCreature.spawnId = creature->getSpawnId();
+
+        stateCreature.x = creature->getX();
+        stateCreature.y = creature->getY();
+        stateCreature.z = creature->getZ();
+
+        stateCreature.direction = creature->getDirection();
+
+        stateCreature.hp    = creature->getHp();
+        stateCreature.hpMax = creature->getHpMax();
+
+        stateCreature.type = creature->getType();
+        stateCreature.team = creature->getTeam();
+
+        stateCreature.flags = 0;
+
+        if (creature->isPlayer()   == true) stateCreature.flags |= tibia::StateCreatureFlags::isPlayer;
+        if (creature->isDead()     == true) stateCreature.flags |= tibia::StateCreatureFlags::isDead;
+        if (creature->hasDecayed() == true) stateCreature.flags |= tibia::StateCreatureFlags::hasDecayed;
+        if (creature->hasOutfit()  == true) stateCreature.flags |= tibia::StateCreatureFlags::hasOutfit;
+        if (creature->isSitting()  == true) stateCreature.flags |= tibia::StateCreatureFlags::isSitting;
+
+        stateCreature.outfit[0] = creature->getOutfitHead();
+        stateCreature.outfit[1] = creature->getOutfitBody();
+        stateCreature.outfit[2] = creature->getOutfitLegs();
+        stateCreature.outfit[3] = creature->getOutfitFeet();
+
+        stateCreature.name = creature->getName();
+
+        return stateCreature;
+    }
+
+    void publishState()
+    {
+        if (m_statePublisher == nullptr)
+        {
+            return;
+        }
+
+        m_stateCreaturesList.clear();
+
+        for (auto creature : m_creaturesList)
+        {
+            m_stateCreaturesList.push_back(getStateCreature(creature.get()));
+        }
+
+        for (auto creature : m_creaturesSpawnList)
+        {
+            m_stateCreaturesList.push_back(getStateCreature(creature.get()));
+        }
+
+        m_statePublisher->publish(m_tick, m_stateCreaturesList);
+    }
+
+    // runs in place of doTick when watching a state stream, only what is needed to draw the frame is simulated
+    void applyStateFrame(const tibia::StateFrame& frame)
+    {
+        m_isSpectating = true;
+
+        m_tick = frame.tick;
+
+        updateTimers();
+
+        m_spectatorCreaturesSeenList.clear();
+
+        for (auto& stateCreature : frame.creaturesList)
+        {
+            CreaturePtr creature;
+
+            auto spectatorCreaturesList_it = m_spectatorCreaturesList.find(stateCreature.spawnId);
+
+            if (spectatorCreaturesList_it != m_spectatorCreaturesList.end())
+            {
+                creature = spectatorCreaturesList_it->second;
+            }
+            else
+            {
+                creature = std::make_shared<tibia::Creature>(stateCreature.x * tibia::TILE_SIZE, stateCreature.y * tibia::TILE_SIZE, stateCreature.z);
+                creature->setName(stateCreature.name);
+                creature->setType(stateCreature.type);
+                creature->setPropertiesByType();
+                creature->setTeam(stateCreature.team);
+
+                spawnCreature(creature);
+
+                creature->setSpawnId(stateCreature.spawnId);
+            }
+
+            m_spectatorCreaturesSeenList[stateCreature.spawnId] = creature;
+
+            creature->setCoords(stateCreature.x, stateCreature.y);
+            creature->setZ(stateCreature.z);
+
+            creature->setDirection(stateCreature.direction);
+
+            creature->setHp(stateCreature.hp);
+            creature->setHpMax(stateCreature.hpMax);
+
+            bool isDead = (stateCreature.flags & tibia::StateCreatureFlags::isDead) != 0;
+
+            if (creature->isDead() != isDead)
+            {
+                creature->setIsDead(isDead);
+            }
+
+            creature->setIsPlayer((stateCreature.flags & tibia::StateCreatureFlags::isPlayer) != 0);
+            creature->setHasDecayed((stateCreature.flags & tibia::StateCreatureFlags::hasDecayed) != 0);
+            creature->setHasOutfit((stateCreature.flags & tibia::StateCreatureFlags::hasOutfit) != 0);
+            creature->setIsSitting((stateCreature.flags & tibia::StateCreatureFlags::isSitting) != 0);
+
+            if
+            (
+                creature->getOutfitHead() != stateCreature.outfit[0] ||
+                creature->getOutfitBody() != stateCreature.outfit[1] ||
+                creature->getOutfitLegs() != stateCreature.outfit[2] ||
+                creature->getOutfitFeet() != stateCreature.outfit[3]
+            )
+            {
+                creature->setOutfit(stateCreature.outfit[0], stateCreature.outfit[1], stateCreature.outfit[2], stateCreature.outfit[3]);
+            }
+
+            if (creature->isPlayer() == true)
+            {
+                m_player = creature;
+            }
+        }
+
+        m_spectatorCreaturesList.swap(m_spectatorCreaturesSeenList);
+
+        // creatures missing from the frame, and the ones this process spawned itself, are removed the same way decayed corpses are
+        for (auto creature : m_creaturesList)
+        {
+            auto spectatorCreaturesList_it = m_spectatorCreaturesList.find(creature->getSpawnId());
+
+            if (spectatorCreaturesList_it == m_spectatorCreaturesList.end() || spectatorCreaturesList_it->second != creature)
+            {
+                creature->setHasDecayed(true);
+
+                m_hasDecayedCreatures = true;
+            }
+        }
+
+        m_creaturesWarmListIsDirty = true;
+
+        for (auto& event : frame.eventsList)
+        {
+            switch (event.type)
+            {
+                case tibia::StateEventTypes::projectile:
+                {
+                    ProjectilePtr projectile = std::make_shared<tibia::Projectile>(event.projectileType, event.direction, event.origin, event.destination, event.isPrecise, event.isChild);
+                    projectile->setSpawnTime(getTime());
+                    projectile->setTileCoords(event.origin.x, event.origin.y);
+                    projectile->setZ(event.z);
+                    projectile->setCreatureOwner(nullptr);
+
+                    m_projectilesSpawnList.push_back(projectile);
+
+                    break;
+                }
+
+                case tibia::StateEventTypes::animation:
+                case tibia::StateEventTypes::animatedDecal:
+                {
+                    int animationId[2] = {event.id, event.numFrames};
+
+                    if (event.type == tibia::StateEventTypes::animation)
+                    {
+                        spawnAnimation(event.tileX, event.tileY, event.z, animationId, event.frameTime);
+                    }
+                    else
+                    {
+                        spawnAnimatedDecal(event.tileX, event.tileY, event.z, animationId, event.frameTime);
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        updateAnimatedDecals();
+        updatePlayer();
+        updateCreatures();
+        updateProjectiles();
+        updateAnimations();
+        updateFloatingTexts();
+
+        m_tick++;
+    }
+
+    // everything the simulation needs to carry on from the tick after the snapshot, must be called between ticks
+    void saveSnapshot(std::ostream& stream)
+    {
+        tibia::BinaryStream::writeUint32(stream, SNAPSHOT_FILE_MAGIC);
+        tibia::BinaryStream::writeUint32(stream, SNAPSHOT_FILE_VERSION);
+
+        tibia::BinaryStream::writeUint32(stream, tibia::MapSize::width);
+        tibia::BinaryStream::writeUint32(stream, tibia::MapSize::height);
+
+        tibia::BinaryStream::writeUint32(stream, m_tick);
+
+        std::uint64_t randomState[4];
+        m_random.getState(randomState);
+
+        tibia::BinaryStream::writeUint64(stream, m_random.getSeed());
+
+        for (int i = 0; i < 4; i++)
+        {
+            tibia::BinaryStream::writeUint64(stream, randomState[i]);
+        }
+
+        tibia::BinaryStream::writeVarInt(stream, m_map.getFloorZMin());
+        tibia::BinaryStream::writeVarInt(stream, m_map.getFloorZMax());
+
+        for (int z = m_map.getFloorZMin(); z <= m_map.getFloorZMax(); z++)
+        {
+            tibia::Map::Floor* floor = m_map.getFloor(z);
+
+            for (int i = 0; i < tibia::TileMapTypes::numTypes; i++)
+            {
+                floor->tileMaps[i].writeSnapshot(stream);
+            }
+        }
+
+        tibia::BinaryStream::writeVarUint(stream, m_objectsList.size());
+
+        for (auto object : m_objectsList)
+        {
+            tibia::BinaryStream::writeVarUint(stream, object->getId());
+        }
+
+        // spawned things are written after the lists they would have been merged into on the next tick
+        std::vector<CreaturePtr> creaturesList(m_creaturesList);
+        creaturesList.insert(creaturesList.end(), m_creaturesSpawnList.begin(), m_creaturesSpawnList.end());
+
+        std::vector<ProjectilePtr> projectilesList(m_projectilesList);
+        projectilesList.insert(projectilesList.end(), m_projectilesSpawnList.begin(), m_projectilesSpawnList.end());
+
+        std::vector<AnimationPtr> animationsList(m_animationsList);
+        animationsList.insert(animationsList.end(), m_animationsSpawnList.begin(), m_animationsSpawnList.end());
+
+        std::vector<AnimationPtr> animatedDecalsList(m_animatedDecalsList);
+        animatedDecalsList.insert(animatedDecalsList.end(), m_animatedDecalsSpawnList.begin(), m_animatedDecalsSpawnList.end());
+
+        std::unordered_map<tibia::Thing*, sf::Vector2i> snapshotIndexes;
+
+        tibia::BinaryStream::writeVarUint(stream, creaturesList.size());
+
+        for (unsigned int i = 0; i < creaturesList.size(); i++)
+        {
+            writeSnapshotCreature(stream, creaturesList.at(i).get());
+
+            snapshotIndexes[creaturesList.at(i).get()] = sf::Vector2i(tibia::SnapshotLists::creatures, i);
+        }
+
+        tibia::BinaryStream::writeVarUint(stream, projectilesList.size());
+
+        for (auto projectile : projectilesList)
+        {
+            int creatureOwnerIndex = -1;
+
+            auto snapshotIndexes_it = snapshotIndexes.find(projectile->getCreatureOwner());
+
+            if (snapshotIndexes_it != snapshotIndexes.end())
+            {
+                creatureOwnerIndex = snapshotIndexes_it->second.y;
+            }
+
+            writeSnapshotProjectile(stream, projectile.get(), creatureOwnerIndex);
+        }
+
+        tibia::BinaryStream::writeVarUint(stream, animationsList.size());
+
+        for (unsigned int i = 0; i < animationsList.size(); i++)
+        {
+            writeSnapshotAnimation(stream, animationsList.at(i).get());
+
+            snapshotIndexes[animationsList.at(i).get()] = sf::Vector2i(tibia::SnapshotLists::animations, i);
+        }
+
+        tibia::BinaryStream::writeVarUint(stream, animatedDecalsList.size());
+
+        for (unsigned int i = 0; i < animatedDecalsList.size(); i++)
+        {
+            writeSnapshotAnimation(stream, animatedDecalsList.at(i).get());
+
+            snapshotIndexes[animatedDecalsList.at(i).get()] = sf::Vector2i(tibia::SnapshotLists::animatedDecals, i);
+        }
+
+        // game text is not part of the simulation and its timer is dropped
+        m_timersSnapshotList.clear();
+        m_timerWheel.getTimers(m_timersSnapshotList);
+
+        int numTimers = 0;
+
+        for (auto& timer : m_timersSnapshotList)
+        {
+            if (timer.value.type != tibia::TimerTypes::gameTextExpiry && timer.value.thing.expired() == false)
+            {
+                numTimers++;
+            }
+        }
+
+        tibia::BinaryStream::writeVarUint(stream, numTimers);
+
+        for (auto& timer : m_timersSnapshotList)
+        {
+            if (timer.value.type == tibia::TimerTypes::gameTextExpiry)
+            {
+                continue;
+            }
+
+            ThingPtr thing = timer.value.thing.lock();
+
+            if (thing == nullptr)
+            {
+                continue;
+            }
+
+            sf::Vector2i snapshotIndex(tibia::SnapshotLists::none, 0);
+
+            auto snapshotIndexes_it = snapshotIndexes.find(thing.get());
+
+            if (snapshotIndexes_it != snapshotIndexes.end())
+            {
+                snapshotIndex = snapshotIndexes_it->second;
+            }
+
+            tibia::BinaryStream::writeVarUint(stream, timer.tick - m_tick);
+            tibia::BinaryStream::writeVarUint(stream, timer.value.type);
+            tibia::BinaryStream::writeVarUint(stream, snapshotIndex.x);
+            tibia::BinaryStream::writeVarUint(stream, snapshotIndex.y);
+        }
+    }
+
+    // the map and objects must already be loaded. the whole snapshot is read before anything is changed,
+    // so the game is left as it was if this returns false
+    bool loadSnapshot(std::istream& stream)
+    {
+        if (tibia::BinaryStream::readUint32(stream) != SNAPSHOT_FILE_MAGIC)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(stream) != SNAPSHOT_FILE_VERSION)
+        {
+            return false;
+        }
+
+        if
+        (
+            static_cast<int>(tibia::BinaryStream::readUint32(stream)) != tibia::MapSize::width ||
+            static_cast<int>(tibia::BinaryStream::readUint32(stream)) != tibia::MapSize::height
+        )
+        {
+            return false;
+        }
+
+        unsigned int tick = tibia::BinaryStream::readUint32(stream);
+
+        std::uint64_t randomSeed = tibia::BinaryStream::readUint64(stream);
+
+        std::uint64_t randomState[4];
+
+        for (int i = 0; i < 4; i++)
+        {
+            randomState[i] = tibia::BinaryStream::readUint64(stream);
+        }
+
+        int floorZMin = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        int floorZMax = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        if (floorZMin != m_map.getFloorZMin() || floorZMax != m_map.getFloorZMax())
+        {
+            return false;
+        }
+
+        std::vector<tibia::TileMap::SnapshotChunkList> snapshotChunksList((floorZMax - floorZMin + 1) * tibia::TileMapTypes::numTypes);
+
+        for (int z = floorZMin; z <= floorZMax; z++)
+        {
+            tibia::Map::Floor* floor = m_map.getFloor(z);
+
+            for (int i = 0; i < tibia::TileMapTypes::numTypes; i++)
+            {
+                if (floor->tileMaps[i].readSnapshot(stream, snapshotChunksList.at(((z - floorZMin) * tibia::TileMapTypes::numTypes) + i)) == false)
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (tibia::BinaryStream::readVarUint(stream) != m_objectsList.size())
+        {
+            return false;
+        }
+
+        std::vector<int> objectIdsList(m_objectsList.size());
+
+        for (unsigned int i = 0; i < objectIdsList.size(); i++)
+        {
+            objectIdsList[i] = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        }
+
+        std::vector<CreaturePtr> creaturesList;
+
+        CreaturePtr player = nullptr;
+
+        int numCreatures = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        for (int i = 0; i < numCreatures && stream.fail() == false; i++)
+        {
+            CreaturePtr creature = readSnapshotCreature(stream);
+
+            if (creature == nullptr)
+            {
+                return false;
+            }
+
+            if (creature->isPlayer() == true)
+            {
+                player = creature;
+            }
+
+            creaturesList.push_back(creature);
+        }
+
+        if (player == nullptr)
+        {
+            return false;
+        }
+
+        std::vector<ProjectilePtr> projectilesList;
+
+        int numProjectiles = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        for (int i = 0; i < numProjectiles && stream.fail() == false; i++)
+        {
+            ProjectilePtr projectile = readSnapshotProjectile(stream, creaturesList);
+
+            if (projectile == nullptr)
+            {
+                return false;
+            }
+
+            projectilesList.push_back(projectile);
+        }
+
+        std::vector<AnimationPtr> animationsList;
+
+        int numAnimations = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        for (int i = 0; i < numAnimations && stream.fail() == false; i++)
+        {
+            animationsList.push_back(readSnapshotAnimation(stream));
+        }
+
+        std::vector<AnimationPtr> animatedDecalsList;
+
+        int numAnimatedDecals = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        for (int i = 0; i < numAnimatedDecals && stream.fail() == false; i++)
+        {
+            animatedDecalsList.push_back(readSnapshotAnimation(stream));
+        }
+
+        std::vector<std::pair<unsigned int, TimerEvent>> timersList;
+
+        int numTimers = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        for (int i = 0; i < numTimers && stream.fail() == false; i++)
+        {
+            unsigned int timerTick = tick + static_cast<unsigned int>(tibia::BinaryStream::readVarUint(stream));
+
+            TimerEvent timerEvent;
+            timerEvent.type = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            int snapshotList  = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+            int snapshotIndex = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            switch (snapshotList)
+            {
+                case tibia::SnapshotLists::creatures:
+                    if (snapshotIndex < static_cast<int>(creaturesList.size()))
+                    {
+                        timerEvent.thing = creaturesList.at(snapshotIndex);
+                    }
+                    break;
+
+                case tibia::SnapshotLists::animations:
+                    if (snapshotIndex < static_cast<int>(animationsList.size()))
+                    {
+                        timerEvent.thing = animationsList.at(snapshotIndex);
+                    }
+                    break;
+
+                case tibia::SnapshotLists::animatedDecals:
+                    if (snapshotIndex < static_cast<int>(animatedDecalsList.size()))
+                    {
+                        timerEvent.thing = animatedDecalsList.at(snapshotIndex);
+                    }
+                    break;
+            }
+
+            timersList.push_back(std::make_pair(timerTick, timerEvent));
+        }
+
+        if (stream.fail() == true)
+        {
+            return false;
+        }
+
+        // everything was read, the game is replaced from here on
+
+        m_tick = tick;
+
+        m_random.setState(randomSeed, randomState);
+
+        for (int z = floorZMin; z <= floorZMax; z++)
+        {
+            tibia::Map::Floor* floor = m_map.getFloor(z);
+
+            for (int i = 0; i < tibia::TileMapTypes::numTypes; i++)
+            {
+                floor->tileMaps[i].applySnapshot(snapshotChunksList.at(((z - floorZMin) * tibia::TileMapTypes::numTypes) + i));
+            }
+        }
+
+        for (unsigned int i = 0; i < objectIdsList.size(); i++)
+        {
+            m_objectsList.at(i)->setId(objectIdsList.at(i));
+        }
+
+        m_chunkTextureCache.clear();
+
+        m_creaturesGrid.clear();
+        m_animatedDecalsGrid.clear();
+
+        m_creaturesSpawnList.clear();
+        m_creaturesWarmList.clear();
+        m_creaturesVisibleList.clear();
+
+        m_projectilesSpawnList.clear();
+
+        m_animationsSpawnList.clear();
+
+        m_animatedDecalsSpawnList.clear();
+        m_animatedDecalsVisibleList.clear();
+
+        m_thingsList.clear();
+        m_thingsSpawnList.clear();
+
+        m_floatingTextsList.clear();
+        m_textList.clear();
+
+        m_creaturesList.swap(creaturesList);
+        m_projectilesList.swap(projectilesList);
+        m_animationsList.swap(animationsList);
+        m_animatedDecalsList.swap(animatedDecalsList);
+
+        m_player = player;
+
+        for (auto creature : m_creaturesList)
+        {
+            creature->setSpawnId(m_nextCreatureSpawnId++);
+
+            m_creaturesGrid.insert(creature.get());
+        }
+
+        for (auto animatedDecal : m_animatedDecalsList)
+        {
+            m_animatedDecalsGrid.insert(animatedDecal.get());
+        }
+
+        m_timerWheel.reset(m_tick);
+
+        for (auto& timer : timersList)
+        {
+            m_timerWheel.schedule(timer.first, timer.second);
+        }
+
+        m_tickTextExpiry = 0;
+
+        m_hasFinishedAnimations = false;
+        m_hasDecayedCreatures   = false;
+
+        m_creaturesWarmListIsDirty = true;
+
+        m_playerHasMoved = true;
+
+        if (m_statePublisher != nullptr)
+        {
+            m_statePublisher->requestKeyframe();
+        }
+
+        return true;
+    }
+
+    bool saveSnapshotFile(std::string filename)
+    {
+        std::ostringstream stream(std::ios::out | std::ios::binary);
+
+        saveSnapshot(stream);
+
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        std::string buffer = stream.str();
+
+        file.write(buffer.data(), buffer.size());
+
+        return file.good();
+    }
+
+    bool loadSnapshotFile(std::string filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+        stream << file.rdbuf();
+
+        return loadSnapshot(stream);
+    }
+
+    void writeSnapshotCreature(std::ostream& stream, tibia::Creature* creature)
+    {
+        tibia::BinaryStream::writeVarInt(stream, creature->getX());
+        tibia::BinaryStream::writeVarInt(stream, creature->getY());
+        tibia::BinaryStream::writeVarInt(stream, creature->getZ());
+
+        tibia::BinaryStream::writeString(stream, creature->getName());
+
+        tibia::BinaryStream::writeVarUint(stream, creature->getType());
+        tibia::BinaryStream::writeVarUint(stream, creature->getSize());
+        tibia::BinaryStream::writeVarUint(stream, creature->getTeam());
+        tibia::BinaryStream::writeVarUint(stream, creature->getDirection());
+
+        tibia::BinaryStream::writeVarInt(stream, creature->getHp());
+        tibia::BinaryStream::writeVarInt(stream, creature->getHpMax());
+        tibia::BinaryStream::writeVarInt(stream, creature->getMp());
+        tibia::BinaryStream::writeVarInt(stream, creature->getMpMax());
+
+        tibia::BinaryStream::writeFloat(stream, creature->getMovementSpeed());
+
+        int flags = 0;
+
+        if (creature->isPlayer()         == true) flags |= 1 << 0;
+        if (creature->isDead()           == true) flags |= 1 << 1;
+        if (creature->hasDecayed()       == true) flags |= 1 << 2;
+        if (creature->isSitting()        == true) flags |= 1 << 3;
+        if (creature->hasOutfit()        == true) flags |= 1 << 4;
+        if (creature->getMovementReady() == true) flags |= 1 << 5;
+
+        tibia::BinaryStream::writeUint8(stream, flags);
+
+        tibia::BinaryStream::writeVarUint(stream, creature->getOutfitHead());
+        tibia::BinaryStream::writeVarUint(stream, creature->getOutfitBody());
+        tibia::BinaryStream::writeVarUint(stream, creature->getOutfitLegs());
+        tibia::BinaryStream::writeVarUint(stream, creature->getOutfitFeet());
+
+        tibia::BinaryStream::writeVarUint(stream, creature->getCorpseId());
+    }
+
+    CreaturePtr readSnapshotCreature(std::istream& stream)
+    {
+        int x = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        int y = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        int z = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        CreaturePtr creature = std::make_shared<tibia::Creature>(x * tibia::TILE_SIZE, y * tibia::TILE_SIZE, z);
+
+        creature->setName(tibia::BinaryStream::readString(stream));
+
+        creature->setType(static_cast<int>(tibia::BinaryStream::readVarUint(stream)));
+        creature->setPropertiesByType();
+
+        // always the size of the type, the sprite list of the type has no sprites for another size
+        int size = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        creature->setTeam(static_cast<int>(tibia::BinaryStream::readVarUint(stream)));
+        creature->setDirection(static_cast<int>(tibia::BinaryStream::readVarUint(stream)));
+
+        creature->setHp(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+        creature->setHpMax(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+        creature->setMp(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+        creature->setMpMax(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+
+        creature->setMovementSpeed(tibia::BinaryStream::readFloat(stream));
+
+        int flags = tibia::BinaryStream::readUint8(stream);
+
+        creature->setIsPlayer((flags & (1 << 0)) != 0);
+        creature->setIsDead((flags & (1 << 1)) != 0);
+        creature->setHasDecayed((flags & (1 << 2)) != 0);
+        creature->setIsSitting((flags & (1 << 3)) != 0);
+        creature->setHasOutfit((flags & (1 << 4)) != 0);
+        creature->setMovementReady((flags & (1 << 5)) != 0);
+
+        int outfitHead = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        int outfitBody = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        int outfitLegs = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        int outfitFeet = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        creature->setOutfit(outfitHead, outfitBody, outfitLegs, outfitFeet);
+
+        creature->setCorpseId(static_cast<int>(tibia::BinaryStream::readVarUint(stream)));
+
+        // the creature only indexes its sprite and outfit tables once drawn, a corrupt snapshot is caught here before that
+        if
+        (
+            creature->getType() < 0 || creature->getType() >= tibia::CreatureTypes::numTypes ||
+            creature->getSize() != size ||
+            creature->getDirection() < tibia::Directions::up || creature->getDirection() > tibia::Directions::left ||
+            isOutfitValid(tibia::Outfits::head, outfitHead) == false ||
+            isOutfitValid(tibia::Outfits::body, outfitBody) == false ||
+            isOutfitValid(tibia::Outfits::legs, outfitLegs) == false ||
+            isOutfitValid(tibia::Outfits::feet, outfitFeet) == false
+        )
+        {
+            return nullptr;
+        }
+
+        return creature;
+    }
+
+    // four sprites per outfit, one for each direction
+    bool isOutfitValid(const std::vector<int>& outfitsList, int outfit)
+    {
+        return outfit >= 0 && (outfit * 4) + 3 < static_cast<int>(outfitsList.size());
+    }
+
+    void writeSnapshotProjectile(std::ostream& stream, tibia::Projectile* projectile, int creatureOwnerIndex)
+    {
+        tibia::BinaryStream::writeVarUint(stream, projectile->getType());
+        tibia::BinaryStream::writeVarUint(stream, projectile->getDirection());
+
+        tibia::BinaryStream::writeFloat(stream, projectile->getVectorOrigin().x);
+        tibia::BinaryStream::writeFloat(stream, projectile->getVectorOrigin().y);
+
+        tibia::BinaryStream::writeFloat(stream, projectile->getVectorDestination().x);
+        tibia::BinaryStream::writeFloat(stream, projectile->getVectorDestination().y);
+
+        tibia::BinaryStream::writeUint8(stream, (projectile->isPrecise() == true ? 1 : 0) | (projectile->isChild() == true ? 2 : 0));
+
+        tibia::BinaryStream::writeVarInt(stream, projectile->getTileX());
+        tibia::BinaryStream::writeVarInt(stream, projectile->getTileY());
+        tibia::BinaryStream::writeVarInt(stream, projectile->getZ());
+
+        tibia::BinaryStream::writeVarInt(stream, projectile->getRange());
+        tibia::BinaryStream::writeVarInt(stream, projectile->getDamage());
+
+        tibia::BinaryStream::writeFloat(stream, projectile->getSpeed());
+        tibia::BinaryStream::writeFloat(stream, projectile->getSpawnTime());
+
+        tibia::BinaryStream::writeVarUint(stream, projectile->getNumTileCrossingsResolved());
+
+        tibia::BinaryStream::writeVarInt(stream, creatureOwnerIndex);
+    }
+
+    // the owner has to be read back before the projectile, creatures come first in a snapshot
+    ProjectilePtr readSnapshotProjectile(std::istream& stream, const std::vector<CreaturePtr>& creaturesList)
+    {
+        int type      = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        int direction = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        sf::Vector2f origin;
+        origin.x = tibia::BinaryStream::readFloat(stream);
+        origin.y = tibia::BinaryStream::readFloat(stream);
+
+        sf::Vector2f destination;
+        destination.x = tibia::BinaryStream::readFloat(stream);
+        destination.y = tibia::BinaryStream::readFloat(stream);
+
+        int flags = tibia::BinaryStream::readUint8(stream);
+
+        // the constructor looks the type and direction up in the sprite tables
+        if
+        (
+            type < 0 || type >= tibia::ProjectileTypes::numTypes ||
+            direction < tibia::Directions::begin || direction > tibia::Directions::end ||
+            stream.fail() == true
+        )
+        {
+            return nullptr;
+        }
+
+        ProjectilePtr projectile = std::make_shared<tibia::Projectile>(type, direction, origin, destination, (flags & 1) != 0, (flags & 2) != 0);
+
+        int tileX = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        int tileY = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        projectile->setTileCoords(tileX, tileY);
+        projectile->setZ(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+
+        projectile->setRange(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+        projectile->setDamage(static_cast<int>(tibia::BinaryStream::readVarInt(stream)));
+
+        projectile->setSpeed(tibia::BinaryStream::readFloat(stream));
+        projectile->setSpawnTime(tibia::BinaryStream::readFloat(stream));
+
+        projectile->setNumTileCrossingsResolved(static_cast<unsigned int>(tibia::BinaryStream::readVarUint(stream)));
+
+        int creatureOwnerIndex = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        projectile->setCreatureOwner(nullptr);
+
+        if (creatureOwnerIndex >= 0 && creatureOwnerIndex < static_cast<int>(creaturesList.size()))
+        {
+            projectile->setCreatureOwner(creaturesList.at(creatureOwnerIndex).get());
+        }
+
+        return projectile;
+    }
+
+    void writeSnapshotAnimation(std::ostream& stream, tibia::Animation* animation)
+    {
+        tibia::BinaryStream::writeVarInt(stream, animation->getTileX());
+        tibia::BinaryStream::writeVarInt(stream, animation->getTileY());
+        tibia::BinaryStream::writeVarInt(stream, animation->getZ());
+
+        tibia::BinaryStream::writeVarUint(stream, animation->getId());
+        tibia::BinaryStream::writeVarUint(stream, animation->getNumFrames());
+        tibia::BinaryStream::writeVarUint(stream, animation->getCurrentFrame());
+        tibia::BinaryStream::writeVarUint(stream, animation->getNumRepeat());
+
+        tibia::BinaryStream::writeFloat(stream, animation->getFrameTime());
+    }
+
+    AnimationPtr readSnapshotAnimation(std::istream& stream)
+    {
+        int tileX = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        int tileY = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        int z     = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        int id        = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        int numFrames = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        AnimationPtr animation = std::make_shared<tibia::Animation>(tileX, tileY, z, id, numFrames);
+
+        animation->setCurrentFrame(static_cast<int>(tibia::BinaryStream::readVarUint(stream)));
+        animation->setNumRepeat(static_cast<int>(tibia::BinaryStream::readVarUint(stream)));
+
+        animation->setFrameTime(tibia::BinaryStream::readFloat(stream));
+
+        return animation;
+    }
+
+    bool handleCreatureDamage(tibia::Creature* attacker, tibia::Creature* defender, int damage, int* animationOnHit, int* animatedDecalOnHit, int* animatedDecalOnKill)
+    {
+        if (attacker == nullptr || defender == nullptr)
+        {
+            return false;
+        }
+
+        if (attacker == defender)
+        {
+            return false;
+        }
+
+        if (attacker->getTeam() == defender->getTeam())
+        {
+            return false;
+        }
+
+        if (defender->getTeam() == tibia::Teams::neutral)
+        {
+            return false;
+        }
+
+        bool defenderWasDead = defender->isDead();
+
+        defender->takeDamageFromCreature(attacker, damage);
+
+        if (defenderWasDead == false && defender->isDead() == true)
+        {
+            scheduleTimer(tibia::TimerTypes::corpseDecay, defender->shared_from_this(), tibia::AnimationTimes::decal);
+        }
+
+        spawnAnimation
+        (
+            defender->getTileX(),
+            defender->getTileY(),
+            defender->getZ(),
+            animationOnHit
+        );
+
+        m_combatLog.push(tibia::CombatEventTypes::hit, getTime(), attacker, defender, damage);
+
+        tibia::FloatingText floatingText;
+        std::snprintf(floatingText.text, sizeof(floatingText.text), "%d", damage);
+        floatingText.x     = defender->getTileX();
+        floatingText.y     = defender->getTileY();
+        floatingText.z     = defender->getZ();
+        floatingText.color = tibia::Colors::red;
+
+        spawnFloatingText(floatingText);
+
+        if (defender->isDead() == false)
+        {
+            spawnAnimatedDecal
+            (
+                defender->getTileX(),
+                defender->getTileY(),
+                defender->getZ(),
+                animatedDecalOnHit,
+                tibia::AnimationTimes::decal
+            );
+        }
+        else
+        {
+            spawnSound(tibia::Sounds::death, defender);
+
+            spawnAnimatedDecal
+            (
+                defender->getTileX(),
+                defender->getTileY(),
+                defender->getZ(),
+                animatedDecalOnKill,
+                tibia::AnimationTimes::decal
+            );
+
+            if (defender->isPlayer() == true)
+            {
+                showGameText("You are dead.", tibia::FontSizes::game, tibia::Colors::white);
+            }
+
+            m_combatLog.push(tibia::CombatEventTypes::kill, getTime(), attacker, defender);
+        }
+
+        return true;
+    }
+
+    bool handleCreatureMovement(tibia::Creature* creature, int direction, bool turnOnly = false)
+    {
+        bool collisionOccured = false;
+
+        if (creature->isDead() == true)
+        {
+            return true;
+        }
+
+        if (turnOnly == false)
+        {
+            if (checkMovementCollision(creature, direction) == false)
+            {
+                if (checkMovementMoveAboveOrBelow(creature, direction) == true)
+                {
+                    return false;
+                }
+
+                checkMovementStepTile(creature, direction, true);
+
+                if (creature->doMove(direction) == true)
+                {
+                    scheduleTimer(tibia::TimerTypes::movementReady, creature->shared_from_this(), creature->getMovementSpeed());
+                }
+
+                checkMovementStepTile(creature, direction, false);
+            }
+            else
+            {
+                collisionOccured == true;
+            }
+        }
+
+        creature->doTurn(direction);
+
+        creature->setIsSitting(checkCreatureIsSitting(creature));
+
+        return collisionOccured;
+    }
+
+    void doCreatureLogic()
+    {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::creatures);
+
+        for (auto creature : m_creaturesList)
+        {
+            if (creature->isPlayer() == true || creature->isRemotePlayer() == true)
+            {
+                continue;
+            }
+
+            if (creature->isDead() == true)
+            {
+                continue;
+            }
+
+            int random = 0;
+
+            if (m_creaturesList.size() > tibia::CREATURES_MAX_LOAD)
+            {
+                random = tibia::getRandomNumber(1, 100);
+
+                if (random > 50)
+                {
+                    continue;
+                }
+            }
+
+            random = tibia::getRandomNumber(1, 100);
+
+            if (random > 50)
             {
                 int direction = creature->getDirection();
 
@@ -402,190 +1750,610 @@ public:
                     destination.x = findCreature->getTileX();
                     destination.y = findCreature->getTileY();
 
-                    sf::Vector2f normal = tibia::getNormalByVectors(origin, destination);
+                    sf::Vector2f normal = tibia::getNormalByVectors(origin, destination);
+
+                    normal.x = tibia::getFloatNormalEx(normal.x);
+                    normal.y = tibia::getFloatNormalEx(normal.y);
+
+                    int direction = tibia::getDirectionByVector(normal);
+
+                    if (random < 25)
+                    {
+                        if (calculateDistanceBetweenCreatures(creature.get(), findCreature.get()) > tibia::ProjectileRanges::default)
+                        {
+                            continue;
+                        }
+
+                        sf::Vector2u checkBlockProjectilesPosition = getTileCoordsByCreatureDirection(creature.get(), direction);
+
+                        if (checkTileIsBlockProjectiles(checkBlockProjectilesPosition, creature->getZ()) == true)
+                        {
+                            continue;
+                        }
+
+                        int projectileType = tibia::ProjectileTypes::spellFire;
+
+                        switch (creature->getTeam())
+                        {
+                            case tibia::Teams::good:
+                                projectileType = tibia::ProjectileTypes::spellBlue;
+                                break;
+
+                            case tibia::Teams::evil:
+                                projectileType = tibia::ProjectileTypes::spellBlack;
+                                break;
+                        }
+
+                        bool projectileIsDiagnonal = true;
+
+                        if (findCreature->getTileX() == creature->getTileX() || findCreature->getTileY() == creature->getTileY())
+                        {
+                            projectileIsDiagnonal = false;
+                        }
+
+                        bool creatureShouldShootProjectile = true;
+
+                        int random3 = tibia::getRandomNumber(1, 100);
+
+                        if (random3 > 10 && projectileIsDiagnonal == true)
+                        {
+                            creatureShouldShootProjectile = false;
+                        }
+
+                        if (creatureShouldShootProjectile == true)
+                        {
+                            spawnProjectile
+                            (
+                                creature.get(),
+                                projectileType,
+                                direction,
+                                origin,
+                                destination
+                            );
+                        }
+
+                        creature->doTurn(direction);
+
+                        break;
+                    }
+                    else
+                    {
+                        int random2 = tibia::getRandomNumber(1, 100);
+
+                        if (random2 > 10)
+                        {
+                            continue;
+                        }
+
+                        handleCreatureMovement(creature.get(), direction);
+
+                        creature->doTurn(direction);
+
+                        break;
+                    }
+                }
+            }
+
+            random = tibia::getRandomNumber(1, 100);
+
+            if (random > 10)
+            {
+                doCreatureUseLadder(creature.get(), creature->getTilePosition());
+            }
+
+            updateCreature(creature.get(), false);
+        }
+    }
+
+    void updatePlayer()
+    {
+        m_playerHasMoved = m_player->update();
+
+        m_creaturesGrid.update(m_player.get());
+    }
+
+    // the distance from the player is only recalculated when either of them has moved
+    void updateCreature(tibia::Creature* creature, bool playerHasMoved)
+    {
+        if (creature->update() == true || playerHasMoved == true)
+        {
+            creature->setDistanceFromPlayer(calculateDistanceBetweenCreatures(m_player.get(), creature));
+        }
+
+        m_creaturesGrid.update(creature);
+    }
+
+    // creatures far from the player are parked cold and only the warm set is visited every tick
+    void updateCreatures()
+    {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::creatures);
+
+        if (m_creaturesSpawnList.size() != 0)
+        {
+            for (auto creaturesSpawnList_it = m_creaturesSpawnList.begin(); creaturesSpawnList_it != m_creaturesSpawnList.end(); creaturesSpawnList_it++)
+            {
+                m_creaturesList.push_back(*creaturesSpawnList_it);
+
+                m_creaturesGrid.insert(creaturesSpawnList_it->get());
+            }
+            m_creaturesSpawnList.clear();
+
+            m_creaturesWarmListIsDirty = true;
+        }
+
+        if (m_hasDecayedCreatures == true)
+        {
+            for (auto creature : m_creaturesList)
+            {
+                if (creature->hasDecayed() == true)
+                {
+                    m_creaturesGrid.remove(creature.get());
+                }
+            }
+
+            m_creaturesList.erase
+            (
+                std::remove_if
+                (
+                    m_creaturesList.begin(),
+                    m_creaturesList.end(),
+                    [](const CreaturePtr& creature)
+                    {
+                        return creature->hasDecayed() == true;
+                    }
+                ),
+                m_creaturesList.end()
+            );
+
+            m_hasDecayedCreatures = false;
+
+            m_creaturesWarmListIsDirty = true;
+        }
+
+        if
+        (
+            m_creaturesWarmListIsDirty == true ||
+            m_tick % tibia::TICKS_PER_SECOND == 0 ||
+            std::abs(m_player->getX() - m_creaturesWarmListOrigin.x) >= tibia::CREATURES_WARM_REBUILD_DISTANCE ||
+            std::abs(m_player->getY() - m_creaturesWarmListOrigin.y) >= tibia::CREATURES_WARM_REBUILD_DISTANCE
+        )
+        {
+            updateCreaturesWarmList();
+        }
+
+        for (auto creature : m_creaturesWarmList)
+        {
+            updateCreature(creature, m_playerHasMoved);
+        }
+    }
+
+    void updateCreaturesWarmList()
+    {
+        m_creaturesWarmList.clear();
+
+        for (auto creature : m_creaturesList)
+        {
+            if (creature->isPlayer() == true)
+            {
+                continue;
+            }
+
+            float distanceFromPlayer = calculateDistanceBetweenCreatures(m_player.get(), creature.get());
+
+            creature->setDistanceFromPlayer(distanceFromPlayer);
+
+            // remote players move whether or not the local player is near
+            bool isCold = distanceFromPlayer > tibia::CREATURES_WARM_DISTANCE && creature->isRemotePlayer() == false;
+
+            creature->setIsCold(isCold);
+
+            if (isCold == false)
+            {
+                m_creaturesWarmList.push_back(creature.get());
+            }
+        }
+
+        m_creaturesWarmListOrigin = sf::Vector2i(m_player->getX(), m_player->getY());
+
+        m_creaturesWarmListIsDirty = false;
+    }
+
+    void updateObjects()
+    {
+        if (m_objectsSpawnList.size() == 0)
+        {
+            return;
+        }
+
+        for (auto objectsSpawnList_it = m_objectsSpawnList.begin(); objectsSpawnList_it != m_objectsSpawnList.end(); objectsSpawnList_it++)
+        {
+            (*objectsSpawnList_it)->update();
+
+            m_objectsList.push_back(*objectsSpawnList_it);
+        }
+        m_objectsSpawnList.clear();
 
-                    normal.x = tibia::getFloatNormalEx(normal.x);
-                    normal.y = tibia::getFloatNormalEx(normal.y);
+        m_objectIndex.build(m_objectsList, tibia::MapSize::width, tibia::MapSize::height, m_map.getFloorZMin(), m_map.getFloorZMax());
+    }
 
-                    int direction = tibia::getDirectionByVector(normal);
+    void updateAnimations()
+    {
+        for (auto animationsSpawnList_it = m_animationsSpawnList.begin(); animationsSpawnList_it != m_animationsSpawnList.end(); animationsSpawnList_it++)
+        {
+            m_animationsList.push_back(*animationsSpawnList_it);
+        }
+        m_animationsSpawnList.clear();
+    }
 
-                    if (random < 25)
-                    {
-                        if (calculateDistanceBetweenCreatures(creature.get(), findCreature.get()) > tibia::ProjectileRanges::default)
-                        {
-                            continue;
-                        }
+    void updateAnimatedDecals()
+    {
+        for (auto animatedDecalsSpawnList_it = m_animatedDecalsSpawnList.begin(); animatedDecalsSpawnList_it != m_animatedDecalsSpawnList.end(); animatedDecalsSpawnList_it++)
+        {
+            m_animatedDecalsList.push_back(*animatedDecalsSpawnList_it);
 
-                        sf::Vector2u checkBlockProjectilesPosition = getTileCoordsByCreatureDirection(creature.get(), direction);
+            m_animatedDecalsGrid.insert(animatedDecalsSpawnList_it->get());
+        }
+        m_animatedDecalsSpawnList.clear();
+    }
 
-                        if (checkTileIsBlockProjectiles(checkBlockProjectilesPosition, creature->getZ()) == true)
-                        {
-                            continue;
-                        }
+    void scheduleTimer(int type, ThingPtr thing, float time)
+    {
+        TimerEvent timerEvent;
+        timerEvent.type  = type;
+        timerEvent.thing = thing;
 
-                        int projectileType = tibia::ProjectileTypes::spellFire;
+        m_timerWheel.schedule(m_tick + tibia::getTicksByTime(time), timerEvent);
+    }
 
-                        switch (creature->getTeam())
-                        {
-                            case tibia::Teams::good:
-                                projectileType = tibia::ProjectileTypes::spellBlue;
-                                break;
+    // only the timers due on this tick are visited, things that no longer exist are skipped
+    void updateTimers()
+    {
+        m_timersDueList.clear();
 
-                            case tibia::Teams::evil:
-                                projectileType = tibia::ProjectileTypes::spellBlack;
-                                break;
-                        }
+        m_timerWheel.advance(m_tick, m_timersDueList);
 
-                        bool projectileIsDiagnonal = true;
+        for (auto& timer : m_timersDueList)
+        {
+            if (timer.value.type == tibia::TimerTypes::gameTextExpiry)
+            {
+                if (timer.tick == m_tickTextExpiry)
+                {
+                    m_textList.clear();
+                }
 
-                        if (findCreature->getTileX() == creature->getTileX() || findCreature->getTileY() == creature->getTileY())
-                        {
-                            projectileIsDiagnonal = false;
-                        }
+                continue;
+            }
 
-                        bool creatureShouldShootProjectile = true;
+            ThingPtr thing = timer.value.thing.lock();
 
-                        int random3 = tibia::getRandomNumber(1, 100);
+            if (thing == nullptr)
+            {
+                continue;
+            }
 
-                        if (random3 > 10 && projectileIsDiagnonal == true)
-                        {
-                            creatureShouldShootProjectile = false;
-                        }
+            switch (timer.value.type)
+            {
+                case tibia::TimerTypes::corpseDecay:
+                {
+                    tibia::Creature* creature = static_cast<tibia::Creature*>(thing.get());
 
-                        if (creatureShouldShootProjectile == true)
-                        {
-                            spawnProjectile
-                            (
-                                creature.get(),
-                                projectileType,
-                                direction,
-                                origin,
-                                destination
-                            );
-                        }
+                    if (creature->advanceCorpse() == true)
+                    {
+                        scheduleTimer(tibia::TimerTypes::corpseDecay, thing, tibia::AnimationTimes::decal);
+                    }
+                    else if (creature->hasDecayed() == true)
+                    {
+                        m_hasDecayedCreatures = true;
+                    }
 
-                        creature->doTurn(direction);
+                    break;
+                }
 
-                        break;
+                case tibia::TimerTypes::animationFrame:
+                {
+                    tibia::Animation* animation = static_cast<tibia::Animation*>(thing.get());
+
+                    if (animation->advanceFrame() == true)
+                    {
+                        scheduleTimer(tibia::TimerTypes::animationFrame, thing, animation->getFrameTime());
                     }
                     else
                     {
-                        int random2 = tibia::getRandomNumber(1, 100);
+                        m_hasFinishedAnimations = true;
+                    }
 
-                        if (random2 > 10)
-                        {
-                            continue;
-                        }
+                    break;
+                }
 
-                        handleCreatureMovement(creature.get(), direction);
+                case tibia::TimerTypes::movementReady:
+                {
+                    tibia::Creature* creature = static_cast<tibia::Creature*>(thing.get());
 
-                        creature->doTurn(direction);
+                    creature->setMovementReady(true);
 
-                        break;
-                    }
+                    break;
                 }
             }
+        }
 
-            random = tibia::getRandomNumber(1, 100);
+        if (m_hasFinishedAnimations == true)
+        {
+            removeFinishedAnimations(m_animationsList);
 
-            if (random > 10)
+            for (auto animatedDecal : m_animatedDecalsList)
             {
-                doCreatureUseLadder(creature.get(), creature->getTilePosition());
+                if (animatedDecal->isFinished() == true)
+                {
+                    m_animatedDecalsGrid.remove(animatedDecal.get());
+                }
             }
 
-            creature->update();
+            removeFinishedAnimations(m_animatedDecalsList);
+
+            m_hasFinishedAnimations = false;
         }
     }
 
-    void updatePlayer()
+    void removeFinishedAnimations(std::vector<AnimationPtr>& animationsList)
     {
-        m_player->update();
+        animationsList.erase
+        (
+            std::remove_if
+            (
+                animationsList.begin(),
+                animationsList.end(),
+                [](const AnimationPtr& animation)
+                {
+                    return animation->isFinished() == true;
+                }
+            ),
+            animationsList.end()
+        );
     }
 
-    void updateCreatures()
+    // the oldest text is replaced once the list is full so it never grows past its reserved size
+    void spawnFloatingText(tibia::FloatingText floatingText)
     {
-        for (auto creature : m_creaturesList)
-        {
-            if (creature->isPlayer() == true)
-            {
-                continue;
-            }
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::effects);
 
-            float distanceFromPlayer = calculateDistanceBetweenCreatures(m_player.get(), creature.get());
+        floatingText.timeSpawned = getTime();
 
-            creature->setDistanceFromPlayer(distanceFromPlayer);
+        if (m_floatingTextsList.size() < tibia::FLOATING_TEXTS_MAX)
+        {
+            m_floatingTextsList.push_back(floatingText);
 
-            creature->update();
+            return;
         }
-    }
 
-    void updateObjects()
-    {
-        for (auto object : m_objectsList)
-        {
-            object->update();
-        }
-    }
+        auto oldest_it = m_floatingTextsList.begin();
 
-    void updateAnimations()
-    {
-        for (auto animation : m_animationsList)
+        for (auto floatingTextsList_it = m_floatingTextsList.begin(); floatingTextsList_it != m_floatingTextsList.end(); floatingTextsList_it++)
         {
-            animation->update();
+            if (floatingTextsList_it->timeSpawned < oldest_it->timeSpawned)
+            {
+                oldest_it = floatingTextsList_it;
+            }
         }
+
+        *oldest_it = floatingText;
     }
 
-    void updateAnimatedDecals()
+    void updateFloatingTexts()
     {
-        for (auto animatedDecal : m_animatedDecalsList)
+        float time = getTime();
+
+        for (unsigned int i = 0; i < m_floatingTextsList.size(); i++)
         {
-            animatedDecal->update();
+            if (time - m_floatingTextsList.at(i).timeSpawned < tibia::FLOATING_TEXT_TIME)
+            {
+                continue;
+            }
+
+            m_floatingTextsList.at(i) = m_floatingTextsList.back();
+            m_floatingTextsList.pop_back();
+
+            i--;
         }
     }
 
     void updateProjectiles()
     {
-        for (auto projectile : m_projectilesList)
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::effects);
+
+        for (auto projectilesSpawnList_it = m_projectilesSpawnList.begin(); projectilesSpawnList_it != m_projectilesSpawnList.end(); projectilesSpawnList_it++)
         {
-            projectile->update();
+            m_projectilesList.push_back(*projectilesSpawnList_it);
         }
+        m_projectilesSpawnList.clear();
+
+        float time = getTime();
+
+        // remove_if runs the predicate once per projectile in order, so each projectile is resolved exactly once
+        m_projectilesList.erase
+        (
+            std::remove_if
+            (
+                m_projectilesList.begin(),
+                m_projectilesList.end(),
+                [this, time](const ProjectilePtr& projectile)
+                {
+                    if (projectile == nullptr)
+                    {
+                        return true;
+                    }
+
+                    projectile->update(time);
+
+                    return resolveProjectileTileCrossings(projectile.get(), time);
+                }
+            ),
+            m_projectilesList.end()
+        );
     }
 
-    void updateSounds()
+    bool resolveProjectileTileCrossings(tibia::Projectile* projectile, float time)
     {
-        for (auto soundsList_it = m_soundsList.begin(); soundsList_it != m_soundsList.end(); soundsList_it++)
+        tibia::Projectile::TileCrossing* tileCrossing = projectile->getNextTileCrossing(time);
+
+        while (tileCrossing != nullptr)
         {
-            sf::Sound* sound = soundsList_it->get();
+            sf::Vector2i tilePosition = tileCrossing->tilePosition;
 
-            if (sound == nullptr)
+            if
+            (
+                tilePosition.x < 0 ||
+                tilePosition.y < 0 ||
+                tilePosition.x >= tibia::getMapTileWidth() ||
+                tilePosition.y >= tibia::getMapTileHeight()
+            )
             {
-                return;
+                return true;
             }
 
-            if (sound->getStatus() == sf::SoundSource::Status::Stopped)
+            sf::Vector2u tileCoords(tilePosition.x, tilePosition.y);
+
+            // a spectator only needs to know where the projectile stops, hits and their effects come from the stream
+            if (m_isSpectating == true)
             {
-                soundsList_it = m_soundsList.erase(soundsList_it);
-                soundsList_it--;
+                if
+                (
+                    checkTileIsBlockProjectiles(tileCoords, projectile->getZ()) == true ||
+                    checkTileHasCreature(tileCoords, projectile->getZ()) != nullptr ||
+                    projectile->isLastTileCrossing() == true
+                )
+                {
+                    return true;
+                }
+
+                tileCrossing = projectile->getNextTileCrossing(time);
+
                 continue;
             }
+
+            if (checkTileIsBlockProjectiles(tileCoords, projectile->getZ()) == true)
+            {
+                spawnAnimation
+                (
+                    tilePosition.x,
+                    tilePosition.y,
+                    projectile->getZ(),
+                    projectile->getAnimationOnBlock()
+                );
+
+                return true;
+            }
+
+            tibia::Creature* attacker = projectile->getCreatureOwner();
+            tibia::Creature* defender = checkTileHasCreature(tileCoords, projectile->getZ());
+
+            if (attacker != nullptr && defender != nullptr)
+            {
+                int* projectileAnimatedDecalOnKill = tibia::AnimatedDecals::poolRed;
+
+                if (projectile->getType() == tibia::ProjectileTypes::arrowPoison)
+                {
+                    projectileAnimatedDecalOnKill = tibia::AnimatedDecals::poolGreen;
+                }
+
+                bool creatureIsDamaged = handleCreatureDamage
+                (
+                    attacker,
+                    defender,
+                    projectile->getDamage(),
+                    projectile->getAnimationOnHit(),
+                    projectile->getAnimatedDecalOnHit(),
+                    projectileAnimatedDecalOnKill
+                );
+
+                if (creatureIsDamaged == true)
+                {
+                    return true;
+                }
+            }
+
+            if (projectile->isLastTileCrossing() == true)
+            {
+                int *projectileAnimationOnMiss = tibia::Animations::hitMiss;
+
+                if (checkTileIsWater(tileCoords, projectile->getZ()) == true)
+                {
+                    projectileAnimationOnMiss = tibia::Animations::waterSplash;
+                }
+
+                spawnAnimation
+                (
+                    tilePosition.x,
+                    tilePosition.y,
+                    projectile->getZ(),
+                    projectileAnimationOnMiss
+                );
+
+                return true;
+            }
+
+            tileCrossing = projectile->getNextTileCrossing(time);
+        }
+
+        return false;
+    }
+
+    void updateSounds()
+    {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::audio);
+
+        m_soundMixer.update();
+    }
+
+    // the volume is only worked out for creatures the local observer can hear
+    void spawnSound(const sf::SoundBuffer* buffer, tibia::Creature* source)
+    {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::audio);
+
+        if (buffer == nullptr)
+        {
+            return;
         }
+
+        float volume = calculateVolumeForCreature(source);
+
+        m_soundMixer.addSound(*buffer, volume, m_tick);
     }
 
-    void spawnSound(SoundPtr sound)
+    // floors below ground only see themselves, floors at or above ground see each other
+    bool isZVisibleFromPlayer(int z)
     {
-        sound->play();
+        int playerZ = m_player->getZ();
 
-        m_soundsList.push_back(sound);
+        if (playerZ < tibia::ZAxis::ground || z < tibia::ZAxis::ground)
+        {
+            return z == playerZ;
+        }
+
+        return true;
     }
 
     void spawnCreature(CreaturePtr creature)
     {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::creatures);
+
+        creature->setSpawnId(m_nextCreatureSpawnId++);
+
         m_creaturesSpawnList.push_back(creature);
     }
 
+    // removed at the end of the next tick the same way decayed corpses are
+    void removeCreature(tibia::Creature* creature)
+    {
+        creature->setHasDecayed(true);
+
+        m_hasDecayedCreatures = true;
+    }
+
     void spawnAnimation(int tileX, int tileY, int z, int animationId[], float frameTime = tibia::AnimationTimes::default)
     {
-        if (m_player->getZ() == tibia::ZAxis::underGround && z != tibia::ZAxis::underGround)
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::effects);
+
+        if (m_player->getZ() < tibia::ZAxis::ground && z != m_player->getZ())
         {
             return;
         }
@@ -603,10 +2371,16 @@ public:
         }
 
         m_animationsSpawnList.push_back(animation);
+
+        scheduleTimer(tibia::TimerTypes::animationFrame, animation, frameTime);
+
+        publishAnimationEvent(tibia::StateEventTypes::animation, tileX, tileY, z, animationId, frameTime);
     }
 
     void spawnAnimatedDecal(int tileX, int tileY, int z, int animationId[], float frameTime = tibia::AnimationTimes::decal)
     {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::effects);
+
         if (m_animatedDecalsList.size() != 0)
         {
             for (auto animatedDecalsList_it = m_animatedDecalsList.begin(); animatedDecalsList_it != m_animatedDecalsList.end(); animatedDecalsList_it++)
@@ -632,17 +2406,58 @@ public:
         AnimationPtr animatedDecal = std::make_shared<tibia::Animation>(tileX, tileY, z, animationId[0], animationId[1]);
         animatedDecal->setFrameTime(frameTime);
 
-        m_animatedDecalsSpawnList.push_back(animatedDecal);
+        m_animatedDecalsSpawnList.push_back(animatedDecal);
+
+        scheduleTimer(tibia::TimerTypes::animationFrame, animatedDecal, frameTime);
+
+        publishAnimationEvent(tibia::StateEventTypes::animatedDecal, tileX, tileY, z, animationId, frameTime);
+    }
+
+    void publishAnimationEvent(int type, int tileX, int tileY, int z, int animationId[], float frameTime)
+    {
+        if (m_statePublisher == nullptr)
+        {
+            return;
+        }
+
+        tibia::StateEvent event;
+        event.type      = type;
+        event.tileX     = tileX;
+        event.tileY     = tileY;
+        event.z         = z;
+        event.id        = animationId[0];
+        event.numFrames = animationId[1];
+        event.frameTime = frameTime;
+
+        m_statePublisher->addEvent(event);
     }
 
     void spawnProjectile(tibia::Creature* creature, int projectileType, int direction, sf::Vector2f origin, sf::Vector2f destination, bool isPrecise = false, bool isChild = false)
     {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::effects);
+
         ProjectilePtr projectile = std::make_shared<tibia::Projectile>(projectileType, direction, origin, destination, isPrecise, isChild);
+        projectile->setSpawnTime(getTime());
         projectile->setTileCoords(origin.x, origin.y);
         projectile->setZ(creature->getZ());
         projectile->setCreatureOwner(creature);
 
         m_projectilesSpawnList.push_back(projectile);
+
+        if (m_statePublisher != nullptr)
+        {
+            tibia::StateEvent event;
+            event.type           = tibia::StateEventTypes::projectile;
+            event.projectileType = projectileType;
+            event.direction      = direction;
+            event.origin         = origin;
+            event.destination    = destination;
+            event.isPrecise      = isPrecise;
+            event.isChild        = isChild;
+            event.z              = creature->getZ();
+
+            m_statePublisher->addEvent(event);
+        }
     }
 
     void drawCreatureBars()
@@ -661,7 +2476,7 @@ public:
         barHealth.setFillColor(tibia::Colors::white);
         barHealth.setOutlineThickness(0);
 
-        for (auto creature : m_creaturesList)
+        for (auto creature : m_creaturesVisibleList)
         {
             if (creature->isPlayer() == true)
             {
@@ -678,11 +2493,6 @@ public:
                 continue;
             }
 
-            if (creature->getDistanceFromPlayer() > tibia::DRAW_DISTANCE_MAX)
-            {
-                continue;
-            }
-
             switch (creature->getTeam())
             {
                 case tibia::Teams::neutral:
@@ -732,6 +2542,123 @@ public:
         }
     }
 
+    // creature names and floating texts are collected into one batch and drawn together
+    void drawLabels()
+    {
+        tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::drawLabels);
+
+        m_labelBatch.clear();
+
+        if (m_showCreatureNames == true)
+        {
+            for (auto creature : m_creaturesVisibleList)
+            {
+                if (creature->isPlayer() == true || creature->isDead() == true)
+                {
+                    continue;
+                }
+
+                if (creature->getZ() != m_player->getZ())
+                {
+                    continue;
+                }
+
+                sf::Color creatureColor = tibia::Colors::white;
+
+                switch (creature->getTeam())
+                {
+                    case tibia::Teams::good:
+                        creatureColor = tibia::Colors::green;
+                        break;
+
+                    case tibia::Teams::evil:
+                        creatureColor = tibia::Colors::red;
+                        break;
+                }
+
+                sf::Vector2f textPosition
+                (
+                    creature->getTileX() + (tibia::TILE_SIZE / 2) - tibia::TILE_DRAW_OFFSET,
+                    creature->getTileY() - (tibia::TILE_SIZE / 2) - 2
+                );
+
+                if (creature->isSitting() == true)
+                {
+                    textPosition.x -= tibia::TILE_DRAW_OFFSET;
+                    textPosition.y -= tibia::TILE_DRAW_OFFSET;
+                }
+
+                m_labelBatch.addTextCenteredWithShadow(tibia::BitmapFonts::font, creature->getName().c_str(), textPosition, creatureColor, tibia::Colors::black);
+            }
+        }
+
+        float time = getTime();
+
+        for (auto& floatingText : m_floatingTextsList)
+        {
+            if (isZVisibleFromPlayer(floatingText.z) == false)
+            {
+                continue;
+            }
+
+            float progress = (time - floatingText.timeSpawned) / tibia::FLOATING_TEXT_TIME;
+
+            sf::Vector2f textPosition
+            (
+                floatingText.x + (tibia::TILE_SIZE / 2) - tibia::TILE_DRAW_OFFSET,
+                floatingText.y - (progress * tibia::FLOATING_TEXT_RISE)
+            );
+
+            sf::Color textColor = floatingText.color;
+            textColor.a = static_cast<sf::Uint8>(255 * (1.0f - std::min(progress, 1.0f)));
+
+            sf::Color shadowColor = tibia::Colors::black;
+            shadowColor.a = textColor.a;
+
+            m_labelBatch.addTextCenteredWithShadow(tibia::BitmapFonts::font, floatingText.text, textPosition, textColor, shadowColor);
+        }
+
+        m_labelBatch.draw(m_window);
+    }
+
+    // std::stable_sort allocates a merge buffer on every call, so things on the same tile keep the order
+    // they were added in through their index instead and are sorted in a buffer that is kept between frames
+    template <class T>
+    void sortByTileCoords(std::vector<T*>& thingsList)
+    {
+        m_thingsSortList.clear();
+
+        for (unsigned int i = 0; i < thingsList.size(); i++)
+        {
+            m_thingsSortList.push_back(std::make_pair(static_cast<tibia::Thing*>(thingsList[i]), i));
+        }
+
+        std::sort
+        (
+            m_thingsSortList.begin(),
+            m_thingsSortList.end(),
+            [](const std::pair<tibia::Thing*, unsigned int>& a, const std::pair<tibia::Thing*, unsigned int>& b)
+            {
+                if (tibia::Thing::sortByTileCoords()(a.first, b.first) == true)
+                {
+                    return true;
+                }
+
+                if (tibia::Thing::sortByTileCoords()(b.first, a.first) == true)
+                {
+                    return false;
+                }
+
+                return a.second < b.second;
+            }
+        );
+
+        for (unsigned int i = 0; i < thingsList.size(); i++)
+        {
+            thingsList[i] = static_cast<T*>(m_thingsSortList[i].first);
+        }
+    }
+
     void drawThings()
     {
         for (auto thingsSpawnList_it = m_thingsSpawnList.begin(); thingsSpawnList_it != m_thingsSpawnList.end(); thingsSpawnList_it++)
@@ -745,7 +2672,7 @@ public:
             return;
         }
 
-        std::stable_sort(m_thingsList.begin(), m_thingsList.end(), tibia::Thing::sortByTileCoords());
+        sortByTileCoords(m_thingsList);
 
         for (auto thing : m_thingsList)
         {
@@ -765,32 +2692,69 @@ public:
         m_window.draw(*m_player);
     }
 
-    void drawCreatures(bool deadOnly = false)
+    // the tiles covered by the view plus a margin for sprites drawn offset from their tile, clamped to the map
+    sf::IntRect getViewTileRect(const sf::View& view, int margin)
     {
-        for (auto creaturesSpawnList_it = m_creaturesSpawnList.begin(); creaturesSpawnList_it != m_creaturesSpawnList.end(); creaturesSpawnList_it++)
-        {
-            m_creaturesList.push_back(*creaturesSpawnList_it);
-        }
-        m_creaturesSpawnList.clear();
+        sf::Vector2f viewTopLeft = view.getCenter() - (view.getSize() / 2.0f);
 
-        if (m_creaturesList.size() == 0)
+        int x1 = static_cast<int>(std::floor(viewTopLeft.x / tibia::TILE_SIZE)) - margin;
+        int y1 = static_cast<int>(std::floor(viewTopLeft.y / tibia::TILE_SIZE)) - margin;
+
+        int x2 = static_cast<int>(std::ceil((viewTopLeft.x + view.getSize().x) / tibia::TILE_SIZE)) + margin;
+        int y2 = static_cast<int>(std::ceil((viewTopLeft.y + view.getSize().y) / tibia::TILE_SIZE)) + margin;
+
+        x1 = std::max(x1, 0);
+        y1 = std::max(y1, 0);
+
+        x2 = std::min(x2, tibia::MapSize::width);
+        y2 = std::min(y2, tibia::MapSize::height);
+
+        return sf::IntRect(x1, y1, std::max(x2 - x1, 0), std::max(y2 - y1, 0));
+    }
+
+    sf::IntRect getTileRectAroundPlayer(int distance)
+    {
+        return sf::IntRect(m_player->getX() - distance, m_player->getY() - distance, (distance * 2) + 1, (distance * 2) + 1);
+    }
+
+    // the local observer covers the view and the mini map around the player
+    void updateLocalObserver()
+    {
+        sf::IntRect miniMapTileRect = getTileRectAroundPlayer(static_cast<int>(tibia::DRAW_DISTANCE_MAX * 2));
+
+        if (m_viewTileRect.width == 0)
         {
+            m_interestManager.setObserverRect(m_localObserverId, miniMapTileRect);
             return;
         }
 
-        for (auto creaturesList_it = m_creaturesList.begin(); creaturesList_it != m_creaturesList.end(); creaturesList_it++)
+        int x1 = std::min(m_viewTileRect.left, miniMapTileRect.left);
+        int y1 = std::min(m_viewTileRect.top,  miniMapTileRect.top);
+
+        int x2 = std::max(m_viewTileRect.left + m_viewTileRect.width,  miniMapTileRect.left + miniMapTileRect.width);
+        int y2 = std::max(m_viewTileRect.top  + m_viewTileRect.height, miniMapTileRect.top  + miniMapTileRect.height);
+
+        m_interestManager.setObserverRect(m_localObserverId, sf::IntRect(x1, y1, x2 - x1, y2 - y1));
+    }
+
+    // silent unless the local observer is interested in the creature
+    float calculateVolumeForCreature(tibia::Creature* creature)
+    {
+        if (m_interestManager.hasCreature(m_localObserverId, creature) == false)
         {
-            tibia::Creature* creature = creaturesList_it->get();
+            return 0;
+        }
 
-            if (creature == nullptr)
-            {
-                return;
-            }
+        return tibia::calculateVolumeByDistance(calculateDistanceBetweenCreatures(m_player.get(), creature));
+    }
+
+    void drawCreatures(bool deadOnly = false)
+    {
+        for (auto creature : m_creaturesVisibleList)
+        {
 
             if (creature->hasDecayed() == true)
             {
-                creaturesList_it = m_creaturesList.erase(creaturesList_it);
-                creaturesList_it--;
                 continue;
             }
 
@@ -809,17 +2773,7 @@ public:
                 }
             }
 
-            if (m_player->getZ() != tibia::ZAxis::underGround && creature->getZ() == tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (m_player->getZ() == tibia::ZAxis::underGround && creature->getZ() != tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (creature->getDistanceFromPlayer() > tibia::DRAW_DISTANCE_MAX)
+            if (isZVisibleFromPlayer(creature->getZ()) == false)
             {
                 continue;
             }
@@ -839,41 +2793,24 @@ public:
 
     void drawObjects()
     {
-        for (auto objectsSpawnList_it = m_objectsSpawnList.begin(); objectsSpawnList_it != m_objectsSpawnList.end(); objectsSpawnList_it++)
-        {
-            m_objectsList.push_back(*objectsSpawnList_it);
-        }
-        m_objectsSpawnList.clear();
-
-        if (m_objectsList.size() == 0)
+        // objects are part of the chunk textures
+        if (m_objectsList.size() == 0 || m_isViewLod == true)
         {
             return;
         }
 
-        for (auto objectsList_it = m_objectsList.begin(); objectsList_it != m_objectsList.end(); objectsList_it++)
-        {
-            tibia::Object* object = objectsList_it->get();
-
-            if (object == nullptr)
-            {
-                return;
-            }
-
-            if (m_player->getZ() != tibia::ZAxis::underGround && object->getZ() == tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (m_player->getZ() == tibia::ZAxis::underGround && object->getZ() != tibia::ZAxis::underGround)
-            {
-                continue;
-            }
+        m_objectsQueryList.clear();
 
-            if (calculateDistanceBetweenThings(m_player.get(), object) > tibia::DRAW_DISTANCE_MAX)
+        for (int z = m_map.getFloorZMin(); z <= m_map.getFloorZMax(); z++)
+        {
+            if (isZVisibleFromPlayer(z) == true)
             {
-                continue;
+                m_objectIndex.query(m_viewTileRect, z, m_objectsQueryList);
             }
+        }
 
+        for (auto object : m_objectsQueryList)
+        {
             //if (object->getTileX() > m_player->getTileX() && object->getTileY() > m_player->getTileY())
             //{
                 //continue;
@@ -884,7 +2821,7 @@ public:
             {
                 if (object->getId() == spriteId)
                 {
-                    object->setTileX(object->getTileX() + tibia::TILE_SIZE);
+                    object->setTileX((object->getX() * tibia::TILE_SIZE) + tibia::TILE_SIZE);
                     break;
                 }
             }
@@ -895,12 +2832,6 @@ public:
 
     void drawAnimations()
     {
-        for (auto animationsSpawnList_it = m_animationsSpawnList.begin(); animationsSpawnList_it != m_animationsSpawnList.end(); animationsSpawnList_it++)
-        {
-            m_animationsList.push_back(*animationsSpawnList_it);
-        }
-        m_animationsSpawnList.clear();
-
         if (m_animationsList.size() == 0)
         {
             return;
@@ -912,216 +2843,57 @@ public:
 
             if (animation == nullptr)
             {
-                return;
-            }
-
-            if (animation->getCurrentFrame() > animation->getNumFrames() - 1)
-            {
-                animationsList_it = m_animationsList.erase(animationsList_it);
-                animationsList_it--;
-                continue;
-            }
-
-            if (m_player->getZ() != tibia::ZAxis::underGround && animation->getZ() == tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (m_player->getZ() == tibia::ZAxis::underGround && animation->getZ() != tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            m_thingsSpawnList.push_back(animation);
-        }
-    }
-
-    void drawAnimatedDecals()
-    {
-        for (auto animatedDecalsSpawnList_it = m_animatedDecalsSpawnList.begin(); animatedDecalsSpawnList_it != m_animatedDecalsSpawnList.end(); animatedDecalsSpawnList_it++)
-        {
-            m_animatedDecalsList.push_back(*animatedDecalsSpawnList_it);
-        }
-        m_animatedDecalsSpawnList.clear();
-
-        if (m_animatedDecalsList.size() == 0)
-        {
-            return;
-        }
-
-        for (auto animatedDecalsList_it = m_animatedDecalsList.begin(); animatedDecalsList_it != m_animatedDecalsList.end(); animatedDecalsList_it++)
-        {
-            tibia::Animation* animatedDecal = animatedDecalsList_it->get();
-
-            if (animatedDecal == nullptr)
-            {
-                return;
-            }
-
-            if (animatedDecal->getCurrentFrame() > animatedDecal->getNumFrames() - 1)
-            {
-                animatedDecalsList_it = m_animatedDecalsList.erase(animatedDecalsList_it);
-                animatedDecalsList_it--;
-                continue;
-            }
-
-            if (m_player->getZ() != tibia::ZAxis::underGround && animatedDecal->getZ() == tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (m_player->getZ() == tibia::ZAxis::underGround && animatedDecal->getZ() != tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (calculateDistanceBetweenThings(m_player.get(), animatedDecal) > tibia::DRAW_DISTANCE_MAX)
-            {
-                continue;
-            }
-
-            //m_window.draw(*animatedDecal);
-            m_thingsSpawnList.push_back(animatedDecal);
-        }
-    }
-
-    void drawProjectiles()
-    {
-        for (auto projectilesSpawnList_it = m_projectilesSpawnList.begin(); projectilesSpawnList_it != m_projectilesSpawnList.end(); projectilesSpawnList_it++)
-        {
-            m_projectilesList.push_back(*projectilesSpawnList_it);
-        }
-        m_projectilesSpawnList.clear();
-
-        if (m_projectilesList.size() == 0)
-        {
-            return;
-        }
-
-        for (auto projectilesList_it = m_projectilesList.begin(); projectilesList_it != m_projectilesList.end(); projectilesList_it++)
-        {
-            tibia::Projectile* projectile = projectilesList_it->get();
-
-            if (projectile == nullptr)
-            {
-                return;
-            }
-
-            if (m_player->getZ() != tibia::ZAxis::underGround && projectile->getZ() == tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (m_player->getZ() == tibia::ZAxis::underGround && projectile->getZ() != tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            sf::Vector2f projectileSpritePosition     = projectile->getSpritePosition();
-            sf::Vector2f projectileSpriteTilePosition = projectile->getSpriteTilePosition();
-
-            //std::cout << "projectileSpriteTilePosition x,y: " << projectileSpriteTilePosition.x << "," << projectileSpriteTilePosition.y << std::endl;
-
-            if
-            (
-                projectileSpriteTilePosition.x < 0 ||
-                projectileSpriteTilePosition.y < 0 ||
-                projectileSpriteTilePosition.x > tibia::MAP_TILE_XY_MAX ||
-                projectileSpriteTilePosition.y > tibia::MAP_TILE_XY_MAX
-            )
-            {
-                projectilesList_it = m_projectilesList.erase(projectilesList_it);
-                projectilesList_it--;
-                continue;
-            }
-
-            int projectileDistanceTravelled = projectile->getDistanceTravelled();
-
-            if (projectileDistanceTravelled > 0 && projectileDistanceTravelled % tibia::TILE_SIZE == 0)
-            {
-                if (checkTileIsBlockProjectiles(sf::Vector2u(projectileSpriteTilePosition.x, projectileSpriteTilePosition.y), projectile->getZ()) == true)
-                {
-                    spawnAnimation
-                    (
-                        projectileSpriteTilePosition.x,
-                        projectileSpriteTilePosition.y,
-                        projectile->getZ(),
-                        projectile->getAnimationOnBlock()
-                    );
-
-                    projectilesList_it = m_projectilesList.erase(projectilesList_it);
-                    projectilesList_it--;
-                    continue;
-                }
-
-                tibia::Creature* attacker = projectile->getCreatureOwner();
-                tibia::Creature* defender = checkTileHasCreature(sf::Vector2u(projectileSpriteTilePosition.x, projectileSpriteTilePosition.y), projectile->getZ());
-
-                if (attacker != nullptr && defender != nullptr)
-                {
-                    int* projectileAnimatedDecalOnKill = tibia::AnimatedDecals::poolRed;
-
-                    if (projectile->getType() == tibia::ProjectileTypes::arrowPoison)
-                    {
-                        projectileAnimatedDecalOnKill = tibia::AnimatedDecals::poolGreen;
-                    }
+                return;
+            }
 
-                    bool creatureIsDamaged = handleCreatureDamage
-                    (
-                        attacker,
-                        defender,
-                        projectile->getDamage(),
-                        projectile->getAnimationOnHit(),
-                        projectile->getAnimatedDecalOnHit(),
-                        projectileAnimatedDecalOnKill
-                    );
+            if (animation->getCurrentFrame() > animation->getNumFrames() - 1)
+            {
+                continue;
+            }
 
-                    if (creatureIsDamaged == true)
-                    {
-                        projectilesList_it = m_projectilesList.erase(projectilesList_it);
-                        projectilesList_it--;
-                        continue;
-                    }
-                }
+            if (isZVisibleFromPlayer(animation->getZ()) == false)
+            {
+                continue;
+            }
 
-                int projectileTileDistanceTravelled = projectile->getTileDistanceTravelled();
+            m_thingsSpawnList.push_back(animation);
+        }
+    }
 
-                //std::cout << "projectileTileDistanceTravelled: " << projectileTileDistanceTravelled << std::endl;
+    void drawAnimatedDecals()
+    {
+        for (auto animatedDecal : m_animatedDecalsVisibleList)
+        {
+            if (animatedDecal->getCurrentFrame() > animatedDecal->getNumFrames() - 1)
+            {
+                continue;
+            }
 
-                if
-                (
-                    projectileTileDistanceTravelled >= projectile->getRange()
-                    //std::abs(projectileSpritePosition.x) >= (projectile->getRange() * tibia::TILE_SIZE) ||
-                    //std::abs(projectileSpritePosition.y) >= (projectile->getRange() * tibia::TILE_SIZE)
-                )
-                {
-                    int *projectileAnimationOnMiss = tibia::Animations::hitMiss;
+            if (isZVisibleFromPlayer(animatedDecal->getZ()) == false)
+            {
+                continue;
+            }
 
-                    if (checkTileIsWater(sf::Vector2u(projectileSpriteTilePosition.x, projectileSpriteTilePosition.y), projectile->getZ()) == true)
-                    {
-                        projectileAnimationOnMiss = tibia::Animations::waterSplash;
-                    }
+            //m_window.draw(*animatedDecal);
+            m_thingsSpawnList.push_back(animatedDecal);
+        }
+    }
 
-                    spawnAnimation
-                    (
-                        projectileSpriteTilePosition.x,
-                        projectileSpriteTilePosition.y,
-                        projectile->getZ(),
-                        projectileAnimationOnMiss
-                    );
+    void drawProjectiles()
+    {
+        if (m_projectilesList.size() == 0)
+        {
+            return;
+        }
 
-                    projectilesList_it = m_projectilesList.erase(projectilesList_it);
-                    projectilesList_it--;
-                    continue;
-                }
+        for (auto projectile : m_projectilesList)
+        {
+            if (isZVisibleFromPlayer(projectile->getZ()) == false)
+            {
+                continue;
             }
 
-            //tibia::Sprite spr;
-            //spr.setId(1);
-            //spr.setPosition(projectile->getSpriteTilePosition().x, projectile->getSpriteTilePosition().y);
-            //m_window.draw(spr);
-
-            m_thingsSpawnList.push_back(projectile);
+            m_thingsSpawnList.push_back(projectile.get());
         }
     }
 
@@ -1132,29 +2904,31 @@ public:
             return;
         }
 
-        m_map.tileMapGroundTiles.doAnimatedWater();
+        tibia::TileMap* tileMap = m_map.getTileMap(m_player->getZ(), tibia::TileMapTypes::tiles);
+
+        if (tileMap == nullptr)
+        {
+            return;
+        }
+
+        tileMap->doAnimatedWater();
     }
 
     void doAnimatedObjects()
     {
-        for (auto object : m_objectsList)
-        {
-            if (object->isAnimated() == false)
-            {
-                continue;
-            }
+        m_objectsQueryList.clear();
 
-            if (m_player->getZ() != tibia::ZAxis::underGround && object->getZ() == tibia::ZAxis::underGround)
-            {
-                continue;
-            }
-
-            if (m_player->getZ() == tibia::ZAxis::underGround && object->getZ() != tibia::ZAxis::underGround)
+        for (int z = m_map.getFloorZMin(); z <= m_map.getFloorZMax(); z++)
+        {
+            if (isZVisibleFromPlayer(z) == true)
             {
-                continue;
+                m_objectIndex.query(getTileRectAroundPlayer(tibia::DRAW_DISTANCE_MAX), z, m_objectsQueryList);
             }
+        }
 
-            if (calculateDistanceBetweenThings(m_player.get(), object.get()) > tibia::DRAW_DISTANCE_MAX)
+        for (auto object : m_objectsQueryList)
+        {
+            if (object->isAnimated() == false)
             {
                 continue;
             }
@@ -1170,7 +2944,7 @@ public:
                     break;
                 }
 
-                std::vector<int> sprites = tibia::animatedObjectsList.at(j);
+                const std::vector<int>& sprites = tibia::animatedObjectsList.at(j);
 
                 for (unsigned int n = 0; n < sprites.size(); n++)
                 {
@@ -1198,46 +2972,15 @@ public:
         }
     }
 
-    void drawTextList(std::vector<sf::Text> textList)
+    void drawTextList(std::vector<sf::Text>& textList)
     {
         int textPositionOffsetY = 0;
 
-        for (auto text : textList)
+        for (auto& text : textList)
         {
-            //std::string textString = text.getString();
-            //std::cout << textString << std::endl;
-
-            text.setPosition(text.getPosition().x, text.getPosition().y + textPositionOffsetY);
-
-            sf::Text textShadow = text;
-
-            textShadow.setColor(tibia::Colors::gameTextShadowColor);
-
-            textShadow.setPosition(text.getPosition().x + 1, text.getPosition().y + 1);
-            m_window.draw(textShadow);
-
-            textShadow.setPosition(text.getPosition().x - 1, text.getPosition().y - 1);
-            m_window.draw(textShadow);
-
-            textShadow.setPosition(text.getPosition().x + 1, text.getPosition().y);
-            m_window.draw(textShadow);
-
-            textShadow.setPosition(text.getPosition().x - 1, text.getPosition().y);
-            m_window.draw(textShadow);
+            sf::Vector2f textPosition(text.getPosition().x, text.getPosition().y + textPositionOffsetY);
 
-            textShadow.setPosition(text.getPosition().x,     text.getPosition().y + 1);
-            m_window.draw(textShadow);
-
-            textShadow.setPosition(text.getPosition().x,     text.getPosition().y - 1);
-            m_window.draw(textShadow);
-
-            textShadow.setPosition(text.getPosition().x + 1, text.getPosition().y - 1);
-            m_window.draw(textShadow);
-
-            textShadow.setPosition(text.getPosition().x - 1, text.getPosition().y + 1);
-            m_window.draw(textShadow);
-
-            m_window.draw(text);
+            m_textCache.draw(m_window, *text.getFont(), text.getString(), text.getCharacterSize(), text.getColor(), tibia::Colors::gameTextShadowColor, textPosition);
 
             textPositionOffsetY += tibia::TILE_SIZE;
         }
@@ -1304,63 +3047,51 @@ public:
             )
         );
 
-        m_clockText.restart();
+        // an older expiry timer still pending for the previous text is ignored
+        m_tickTextExpiry = m_tick + tibia::getTicksByTime(tibia::TEXT_TIME);
+
+        TimerEvent timerEvent;
+        timerEvent.type = tibia::TimerTypes::gameTextExpiry;
+
+        m_timerWheel.schedule(m_tickTextExpiry, timerEvent);
     }
 
     void drawGameText()
     {
-        sf::Time timeText = m_clockText.getElapsedTime();
-
-        if (timeText.asSeconds() < tibia::TEXT_TIME)
-        {
-            drawTextList(m_textList);
-        }
+        drawTextList(m_textList);
     }
 
-    void drawTileMap(tibia::TileMap* tileMap)
+    // appends a quad for every tile inside the rectangle of tiles
+    void addTileMapVertices(tibia::TileMap* tileMap, sf::IntRect tileRect, sf::VertexArray& vertices)
     {
-        int x = ((m_windowView.getCenter().x - (tibia::TILE_SIZE / 2)) / tibia::TILE_SIZE) - NUM_TILES_FROM_CENTER_X;
-        int y = ((m_windowView.getCenter().y - (tibia::TILE_SIZE / 2)) / tibia::TILE_SIZE) - NUM_TILES_FROM_CENTER_Y;
-
-        if (x < 0) x = 0;
-        if (y < 0) y = 0;
-
-        std::vector<int>* tiles = tileMap->getTiles();
-
-        if (tiles->size() == 0)
-        {
-            return;
-        }
+        int x1 = std::max(tileRect.left, 0);
+        int y1 = std::max(tileRect.top,  0);
 
-        std::vector<tibia::TileMap::TilePtr> *tilesList = tileMap->getTilesList();
-
-        m_tileVertices.clear();
+        int x2 = std::min(tileRect.left + tileRect.width,  tibia::MapSize::width);
+        int y2 = std::min(tileRect.top  + tileRect.height, tibia::MapSize::height);
 
-        for (unsigned int i = x; i < x + tibia::NUM_TILES_X; i++)
+        for (int i = x1; i < x2; i++)
         {
-            for (unsigned int j = y; j < y + tibia::NUM_TILES_Y; j++)
+            for (int j = y1; j < y2; j++)
             {
-                if (i > tibia::MAP_SIZE - 1) continue;
-                if (j > tibia::MAP_SIZE - 1) continue;
 
-                int tileNumber = i + j * tibia::MAP_SIZE;
+                int tileNumber = i + j * tibia::MapSize::width;
 
-                if (tileNumber < 0 || tileNumber > tibia::TILE_NUMBER_MAX)
+                tibia::Tile* tile = tileMap->getTile(tileNumber);
+
+                if (tile == nullptr)
                 {
                     continue;
                 }
 
-                tibia::Tile* tile = tilesList->at(tileNumber).get();
-
-                int tileId = tile->getId(); //tiles->at(tileNumber);
+                int tileId = tile->getId();
 
                 if (tileId == tibia::TILE_NULL || tileId == 1)
                 {
                     continue;
                 }
 
-                int tu = (tileId - 1) % (tibia::Textures::sprites.getSize().x / tibia::TILE_SIZE);
-                int tv = (tileId - 1) / (tibia::Textures::sprites.getSize().x / tibia::TILE_SIZE);
+                sf::IntRect tileRect = tibia::getSpriteRectById(tileId);
 
                 sf::Vertex quad[4];
 
@@ -1369,10 +3100,10 @@ public:
                 quad[2].position = sf::Vector2f((i + 1) * tibia::TILE_SIZE, (j + 1) * tibia::TILE_SIZE);
                 quad[3].position = sf::Vector2f(i       * tibia::TILE_SIZE, (j + 1) * tibia::TILE_SIZE);
 
-                quad[0].texCoords = sf::Vector2f(tu       * tibia::TILE_SIZE, tv       * tibia::TILE_SIZE);
-                quad[1].texCoords = sf::Vector2f((tu + 1) * tibia::TILE_SIZE, tv       * tibia::TILE_SIZE);
-                quad[2].texCoords = sf::Vector2f((tu + 1) * tibia::TILE_SIZE, (tv + 1) * tibia::TILE_SIZE);
-                quad[3].texCoords = sf::Vector2f(tu       * tibia::TILE_SIZE, (tv + 1) * tibia::TILE_SIZE);
+                quad[0].texCoords = sf::Vector2f(tileRect.left,                    tileRect.top);
+                quad[1].texCoords = sf::Vector2f(tileRect.left + tibia::TILE_SIZE, tileRect.top);
+                quad[2].texCoords = sf::Vector2f(tileRect.left + tibia::TILE_SIZE, tileRect.top + tibia::TILE_SIZE);
+                quad[3].texCoords = sf::Vector2f(tileRect.left,                    tileRect.top + tibia::TILE_SIZE);
 
                 if (tile->getFlags() & tibia::TileFlags::offset)
                 {
@@ -1387,12 +3118,26 @@ public:
                     quad[3].position.y -= tibia::TILE_DRAW_OFFSET;
                 }
 
-                m_tileVertices.append(quad[0]);
-                m_tileVertices.append(quad[1]);
-                m_tileVertices.append(quad[2]);
-                m_tileVertices.append(quad[3]);
+                vertices.append(quad[0]);
+                vertices.append(quad[1]);
+                vertices.append(quad[2]);
+                vertices.append(quad[3]);
             }
         }
+    }
+
+    void drawTileMap(tibia::TileMap* tileMap)
+    {
+        tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::drawTileMapTiles + tileMap->getType());
+
+        if (tileMap->isEmpty() == true)
+        {
+            return;
+        }
+
+        m_tileVertices.clear();
+
+        addTileMapVertices(tileMap, m_viewTileRect, m_tileVertices);
 
         sf::RenderStates states;
         states.texture = &tibia::Textures::sprites;
@@ -1400,113 +3145,267 @@ public:
         m_window.draw(m_tileVertices, states);
     }
 
-    void drawGameWindow(sf::RenderWindow* mainWindow)
+    // a tile is drawn into its own chunk and, since things are drawn offset up and left, into the chunks before it
+    void removeChunkTextures(int tileX, int tileY, int z)
     {
-        m_windowView.setCenter
-        (
-            m_player->getTileX() + (tibia::TILE_SIZE / 2),
-            m_player->getTileY() + (tibia::TILE_SIZE / 2)
-        );
+        int chunkX1 = std::max(tileX - tibia::VIEW_TILE_MARGIN, 0) / tibia::LOD_CHUNK_SIZE;
+        int chunkY1 = std::max(tileY - tibia::VIEW_TILE_MARGIN, 0) / tibia::LOD_CHUNK_SIZE;
 
-        m_window.setView(m_windowView);
-        m_window.clear(tibia::Colors::black);
+        int chunkX2 = tileX / tibia::LOD_CHUNK_SIZE;
+        int chunkY2 = tileY / tibia::LOD_CHUNK_SIZE;
 
-        int playerX = m_player->getTileX();
-        int playerY = m_player->getTileY();
-        int playerZ = m_player->getZ();
+        for (int chunkY = chunkY1; chunkY <= chunkY2; chunkY++)
+        {
+            for (int chunkX = chunkX1; chunkX <= chunkX2; chunkX++)
+            {
+                m_chunkTextureCache.removeTexture(chunkX, chunkY, z);
+            }
+        }
+    }
+
+    // renders the tile maps and objects of a chunk into a small texture the size of the chunk at the lod tile size
+    const sf::Texture* bakeChunk(int chunkX, int chunkY, int z)
+    {
+        tibia::Map::Floor* floor = m_map.getFloor(z);
 
-        if (playerZ == tibia::ZAxis::underGround)
+        if (floor == nullptr)
         {
-            drawTileMap(&m_map.tileMapUnderGroundTiles);
-            drawTileMap(&m_map.tileMapUnderGroundEdges);
-            drawTileMap(&m_map.tileMapUnderGroundObjects);
+            return nullptr;
         }
-        else
+
+        sf::IntRect chunkTileRect(chunkX * tibia::LOD_CHUNK_SIZE, chunkY * tibia::LOD_CHUNK_SIZE, tibia::LOD_CHUNK_SIZE, tibia::LOD_CHUNK_SIZE);
+
+        // things drawn offset up and left from the tiles after the chunk reach into it
+        sf::IntRect drawTileRect(chunkTileRect.left, chunkTileRect.top, chunkTileRect.width + tibia::VIEW_TILE_MARGIN, chunkTileRect.height + tibia::VIEW_TILE_MARGIN);
+
+        sf::View chunkView
+        (
+            sf::FloatRect
+            (
+                chunkTileRect.left   * tibia::TILE_SIZE,
+                chunkTileRect.top    * tibia::TILE_SIZE,
+                chunkTileRect.width  * tibia::TILE_SIZE,
+                chunkTileRect.height * tibia::TILE_SIZE
+            )
+        );
+
+        m_rtChunk.setView(chunkView);
+        m_rtChunk.clear(tibia::Colors::transparent);
+
+        sf::RenderStates states;
+        states.texture = &tibia::Textures::sprites;
+
+        for (int i = 0; i < tibia::TileMapTypes::numTypes; i++)
         {
-            drawTileMap(&m_map.tileMapGroundTiles);
-            drawTileMap(&m_map.tileMapGroundEdges);
-            drawTileMap(&m_map.tileMapGroundObjects);
+            if (floor->tileMaps[i].isEmpty() == true)
+            {
+                continue;
+            }
+
+            m_chunkVertices.clear();
+
+            addTileMapVertices(&floor->tileMaps[i], drawTileRect, m_chunkVertices);
+
+            m_rtChunk.draw(m_chunkVertices, states);
         }
 
-        //////////////////////////////////////////////////
+        m_objectsQueryList.clear();
 
-        drawAnimatedDecals();
+        m_objectIndex.query(drawTileRect, z, m_objectsQueryList);
 
-        drawCreatures(true);
+        sortByTileCoords(m_objectsQueryList);
 
-        drawObjects();
+        for (auto object : m_objectsQueryList)
+        {
+            m_rtChunk.draw(*object);
+        }
 
-        drawCreatures(false);
+        m_rtChunk.display();
 
-        drawProjectiles();
+        return m_chunkTextureCache.addTexture(chunkX, chunkY, z, m_rtChunk.getTexture().copyToImage());
+    }
 
-        drawAnimations();
+    // at most a few missing chunks are baked each frame, the rest show up over the next frames
+    void drawFloorChunks(int z)
+    {
+        tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::drawChunks);
+
+        if (m_viewTileRect.width <= 0 || m_viewTileRect.height <= 0)
+        {
+            return;
+        }
 
-        drawThings(); // draw sorted by y-axis
+        int chunkX1 = m_viewTileRect.left / tibia::LOD_CHUNK_SIZE;
+        int chunkY1 = m_viewTileRect.top  / tibia::LOD_CHUNK_SIZE;
 
-        //////////////////////////////////////////////////
+        int chunkX2 = (m_viewTileRect.left + m_viewTileRect.width  - 1) / tibia::LOD_CHUNK_SIZE;
+        int chunkY2 = (m_viewTileRect.top  + m_viewTileRect.height - 1) / tibia::LOD_CHUNK_SIZE;
 
-/*
-        for (auto creature : m_creaturesList)
+        float chunkScale = static_cast<float>(tibia::TILE_SIZE) / tibia::LOD_TILE_SIZE;
+
+        for (int chunkY = chunkY1; chunkY <= chunkY2; chunkY++)
         {
-            if (creature->isPlayer() == true || creature->isDead() == true)
+            for (int chunkX = chunkX1; chunkX <= chunkX2; chunkX++)
             {
-                continue;
-            }
+                const sf::Texture* texture = m_chunkTextureCache.getTexture(chunkX, chunkY, z);
 
-            if (creature->getZ() != m_player->getZ())
-            {
-                continue;
+                if (texture == nullptr)
+                {
+                    if (m_numChunksBaked >= tibia::LOD_CHUNK_BAKES_PER_FRAME)
+                    {
+                        continue;
+                    }
+
+                    texture = bakeChunk(chunkX, chunkY, z);
+
+                    m_numChunksBaked++;
+
+                    if (texture == nullptr)
+                    {
+                        continue;
+                    }
+                }
+
+                sf::Sprite spriteChunk(*texture);
+                spriteChunk.setPosition(chunkX * tibia::LOD_CHUNK_SIZE * tibia::TILE_SIZE, chunkY * tibia::LOD_CHUNK_SIZE * tibia::TILE_SIZE);
+                spriteChunk.setScale(chunkScale, chunkScale);
+
+                m_window.draw(spriteChunk);
             }
+        }
+    }
+
+    void drawFloor(int z)
+    {
+        tibia::Map::Floor* floor = m_map.getFloor(z);
+
+        if (floor == nullptr)
+        {
+            return;
+        }
+
+        if (m_isViewLod == true)
+        {
+            drawFloorChunks(z);
+            return;
+        }
+
+        drawTileMap(&floor->tileMaps[tibia::TileMapTypes::tiles]);
+        drawTileMap(&floor->tileMaps[tibia::TileMapTypes::edges]);
+        drawTileMap(&floor->tileMaps[tibia::TileMapTypes::walls]);
+        drawTileMap(&floor->tileMaps[tibia::TileMapTypes::objects]);
+    }
+
+    // a floor hides itself and everything above it once it has tiles over the player
+    bool checkFloorIsAbovePlayer(int z)
+    {
+        tibia::TileMap* tileMap = m_map.getTileMap(z, tibia::TileMapTypes::tiles);
+
+        if (tileMap == nullptr)
+        {
+            return false;
+        }
+
+        int playerX = m_player->getTileX();
+        int playerY = m_player->getTileY();
 
-            if (creature->getDistanceFromPlayer() > tibia::DRAW_DISTANCE_MAX)
+        for (int i = -2; i < 3; i++)
+        {
+            for (int j = -2; j < 3; j++)
             {
-                continue;
+                int tileNumber = tibia::getTileNumberByTileCoords(playerX + (i * tibia::TILE_SIZE), playerY + (j * tibia::TILE_SIZE));
+
+                if (tileMap->getTileId(tileNumber) != tibia::TILE_NULL)
+                {
+                    return true;
+                }
             }
+        }
+
+        return false;
+    }
+
+    // centers the view on the player and gathers what it can see, the draw functions only use what is gathered here
+    void updateWindowView()
+    {
+        m_windowView.setCenter
+        (
+            m_player->getTileX() + (tibia::TILE_SIZE / 2),
+            m_player->getTileY() + (tibia::TILE_SIZE / 2)
+        );
+
+        m_window.setView(m_windowView);
 
-            sf::Text text(creature->getName(), m_fontSmall, tibia::FontSizes::small);
+        m_viewTileRect = getViewTileRect(m_windowView, tibia::VIEW_TILE_MARGIN);
 
-            int textX = creature->getTileX() - (text.getLocalBounds().width / 2) + (tibia::TILE_SIZE / 2) - tibia::TILE_DRAW_OFFSET;
-            int textY = creature->getTileY() - tibia::TILE_SIZE - (tibia::TILE_DRAW_OFFSET / 2) - 1;
+        m_isViewLod = m_windowView.getSize().x >= tibia::TILES_WIDTH * tibia::LOD_ZOOM_LEVEL;
 
-            if (creature->isSitting() == true)
+        updateLocalObserver();
+
+        m_creaturesVisibleList.clear();
+
+        for (auto creature : m_interestManager.getCreatures(m_localObserverId))
+        {
+            if (m_viewTileRect.contains(creature->getX(), creature->getY()) == true)
             {
-                textX -= tibia::TILE_DRAW_OFFSET;
-                textY -= tibia::TILE_DRAW_OFFSET;
+                m_creaturesVisibleList.push_back(creature);
             }
+        }
+
+        m_animatedDecalsVisibleList.clear();
+        m_animatedDecalsGrid.query(m_viewTileRect, m_animatedDecalsVisibleList);
+    }
+
+    void drawGameWindow(sf::RenderTarget* mainWindow)
+    {
+        tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::drawGameWindow);
+
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::render);
+
+        updateWindowView();
+
+        m_window.clear(tibia::Colors::black);
+
+        if (m_isViewLod == true)
+        {
+            m_chunkTextureCache.beginFrame();
+
+            m_numChunksBaked = 0;
+        }
+
+        int playerZ = m_player->getZ();
+
+        // below ground only the player's floor is drawn, otherwise the floors from ground up to the player's
+        int drawFloorZ = tibia::ZAxis::ground;
+
+        if (playerZ < tibia::ZAxis::ground)
+        {
+            drawFloorZ = playerZ;
+        }
+
+        drawFloor(drawFloorZ);
+
+        //////////////////////////////////////////////////
+
+        drawAnimatedDecals();
 
-            text.setColor(tibia::Colors::black);
-            text.setPosition
-            (
-                textX + 1,
-                textY + 1
-            );
+        drawCreatures(true);
 
-            m_window.draw(text);
+        drawObjects();
 
-            sf::Color creatureColor = tibia::Colors::white;
+        drawCreatures(false);
 
-            switch (creature->getTeam())
-            {
-                case tibia::Teams::good:
-                    creatureColor = tibia::Colors::green;
-                    break;
+        drawProjectiles();
 
-                case tibia::Teams::evil:
-                    creatureColor = tibia::Colors::red;
-                    break;
-            }
+        drawAnimations();
 
-            text.setColor(creatureColor);
-            text.setPosition
-            (
-                textX,
-                textY
-            );
+        {
+            tibia::Profiler::ScopedTimer profilerTimer(&m_profiler, tibia::ProfilerZones::drawThings);
 
-            m_window.draw(text);
+            drawThings(); // draw sorted by y-axis
         }
-*/
+
+        //////////////////////////////////////////////////
 
 /*
         for (auto object : m_objectsList)
@@ -1538,47 +3437,18 @@ public:
         }
 */
 
-        if (playerZ != tibia::ZAxis::underGround)
+        if (playerZ >= tibia::ZAxis::ground)
         {
-            bool drawAboveGround = true;
-
-            if (playerZ == tibia::ZAxis::ground)
+            for (int floorZ = tibia::ZAxis::ground + 1; floorZ <= m_map.getFloorZMax(); floorZ++)
             {
-                std::vector<int>* aboveGroundTiles = m_map.tileMapAboveGroundTiles.getTiles();
-
-                std::vector<int> aboveGroundTileNumbers;
-
-                for (int i = -2; i < 3; i++)
-                {
-                    aboveGroundTileNumbers.push_back(tibia::getTileNumberByTileCoords(playerX - (2 * tibia::TILE_SIZE), playerY + (i * tibia::TILE_SIZE)));
-                    aboveGroundTileNumbers.push_back(tibia::getTileNumberByTileCoords(playerX - (1 * tibia::TILE_SIZE), playerY + (i * tibia::TILE_SIZE)));
-                    aboveGroundTileNumbers.push_back(tibia::getTileNumberByTileCoords(playerX                         , playerY + (i * tibia::TILE_SIZE)));
-                    aboveGroundTileNumbers.push_back(tibia::getTileNumberByTileCoords(playerX + (1 * tibia::TILE_SIZE), playerY + (i * tibia::TILE_SIZE)));
-                    aboveGroundTileNumbers.push_back(tibia::getTileNumberByTileCoords(playerX + (2 * tibia::TILE_SIZE), playerY + (i * tibia::TILE_SIZE)));
-                }
-
-                for (auto tileNumber : aboveGroundTileNumbers)
+                if (floorZ > playerZ && checkFloorIsAbovePlayer(floorZ) == true)
                 {
-                    if (tileNumber < 0 || tileNumber > tibia::TILE_NUMBER_MAX)
-                    {
-                        continue;
-                    }
-
-                    if (aboveGroundTiles->at(tileNumber) != tibia::TILE_NULL)
-                    {
-                        drawAboveGround = false;
-                        break;
-                    }
+                    break;
                 }
-            }
 
-            if (drawAboveGround == true)
-            {
-                drawTileMap(&m_map.tileMapAboveGroundTiles);
-                drawTileMap(&m_map.tileMapAboveGroundEdges);
-                drawTileMap(&m_map.tileMapAboveGroundObjects);
+                drawFloor(floorZ);
 
-                if (playerZ == tibia::ZAxis::aboveGround)
+                if (floorZ == playerZ)
                 {
                     //////////////////////////////////////////////////
 
@@ -1589,18 +3459,19 @@ public:
             }
         }
 
-        if (playerZ == tibia::ZAxis::underGround)
+        if (playerZ < tibia::ZAxis::ground)
         {
+            tibia::Profiler::ScopedTimer profilerTimerLights(&m_profiler, tibia::ProfilerZones::drawLights);
+
+            sf::View lightView(m_windowView.getCenter(), sf::Vector2f(tibia::LIGHT_WIDTH, tibia::LIGHT_HEIGHT));
+
+            m_rtLight.setView(lightView);
+
             m_rtLight.clear(tibia::Colors::black);
 
-            for (auto creature : m_creaturesList)
+            for (auto creature : m_creaturesVisibleList)
             {
-                if (creature->getZ() != tibia::ZAxis::underGround)
-                {
-                    continue;
-                }
-
-                if (creature->getDistanceFromPlayer() > tibia::DRAW_DISTANCE_MAX)
+                if (creature->getZ() != playerZ)
                 {
                     continue;
                 }
@@ -1609,11 +3480,11 @@ public:
 
                 if (creature->isPlayer() == true)
                 {
-                    spriteLight.setTexture(tibia::Textures::light3);
+                    tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light3);
                 }
                 else
                 {
-                    spriteLight.setTexture(tibia::Textures::light2);
+                    tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light2);
                 }
 
                 spriteLight.setOrigin(spriteLight.getLocalBounds().width / 2, spriteLight.getLocalBounds().height / 2);
@@ -1624,19 +3495,13 @@ public:
                 m_rtLight.draw(spriteLight, sf::BlendMode::BlendAdd);
             }
 
-            for (auto object : m_objectsList)
-            {
-                if (object->getZ() != tibia::ZAxis::underGround)
-                {
-                    continue;
-                }
+            m_objectsQueryList.clear();
 
-                if (calculateDistanceBetweenThings(m_player.get(), object.get()) > tibia::DRAW_DISTANCE_MAX)
-                {
-                    continue;
-                }
+            m_objectIndex.query(m_viewTileRect, playerZ, m_objectsQueryList);
 
-                if (checkTileIsLight(object->getTilePosition(), tibia::ZAxis::underGround) == false)
+            for (auto object : m_objectsQueryList)
+            {
+                if (checkTileIsLight(object->getTilePosition(), playerZ) == false)
                 {
                     continue;
                 }
@@ -1645,11 +3510,11 @@ public:
 
                 if (object->getId() == tibia::SpriteData::ladder || object->getId() == tibia::SpriteData::stairs)
                 {
-                    spriteLight.setTexture(tibia::Textures::light);
+                    tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light);
                 }
                 else
                 {
-                    spriteLight.setTexture(tibia::Textures::light2);
+                    tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light2);
                 }
 
                 spriteLight.setOrigin(spriteLight.getLocalBounds().width / 2, spriteLight.getLocalBounds().height / 2);
@@ -1660,53 +3525,62 @@ public:
                 m_rtLight.draw(spriteLight, sf::BlendMode::BlendAdd);
             }
 
-            auto underGroundObjects = m_map.tileMapUnderGroundObjects.getTilesList();
+            tibia::TileMap* lightTileMap = m_map.getTileMap(playerZ, tibia::TileMapTypes::objects);
 
-            for (auto tile : *underGroundObjects)
-            {
-                int tileNumber = tile->getNumber();
+            int lightTileDistance = static_cast<int>(tibia::DRAW_DISTANCE_MAX);
 
-                int tileId = tile->getId();
+            int lightTileX1 = std::max((m_player->getTileX() / tibia::TILE_SIZE) - lightTileDistance, 0);
+            int lightTileY1 = std::max((m_player->getTileY() / tibia::TILE_SIZE) - lightTileDistance, 0);
 
-                if (tileId == tibia::TILE_NULL)
+            int lightTileX2 = std::min((m_player->getTileX() / tibia::TILE_SIZE) + lightTileDistance, tibia::MapSize::width  - 1);
+            int lightTileY2 = std::min((m_player->getTileY() / tibia::TILE_SIZE) + lightTileDistance, tibia::MapSize::height - 1);
+
+            for (int lightTileX = lightTileX1; lightTileX <= lightTileX2; lightTileX++)
+            {
+                for (int lightTileY = lightTileY1; lightTileY <= lightTileY2; lightTileY++)
                 {
-                    continue;
-                }
+                    int tileNumber = lightTileX + lightTileY * tibia::MapSize::width;
 
-                sf::Vector2u tileCoords = tibia::getTileCoordsByTileNumber(tileNumber);
+                    if (lightTileMap == nullptr || lightTileMap->getTileId(tileNumber) == tibia::TILE_NULL)
+                    {
+                        continue;
+                    }
 
-                //std::cout << "tileCoords: " << tileCoords.x << "," << tileCoords.y << std::endl;
+                    sf::Vector2u tileCoords = tibia::getTileCoordsByTileNumber(tileNumber);
 
-                //tibia::Sprite spr;
-                //spr.setId(1);
-                //spr.setPosition(tileCoords.x, tileCoords.y);
-                //m_window.draw(spr);
+                    //std::cout << "tileCoords: " << tileCoords.x << "," << tileCoords.y << std::endl;
 
-                if (calculateDistanceByTile(m_player->getTileX(), m_player->getTileY(), tileCoords.x, tileCoords.y) > tibia::DRAW_DISTANCE_MAX)
-                {
-                    continue;
-                }
+                    //tibia::Sprite spr;
+                    //spr.setId(1);
+                    //spr.setPosition(tileCoords.x, tileCoords.y);
+                    //m_window.draw(spr);
 
-                if (checkTileIsLight(tileCoords, tibia::ZAxis::underGround) == false)
-                {
-                    continue;
-                }
+                    if (calculateDistanceByTile(m_player->getTileX(), m_player->getTileY(), tileCoords.x, tileCoords.y) > tibia::DRAW_DISTANCE_MAX)
+                    {
+                        continue;
+                    }
 
-                sf::Sprite spriteLight;
+                    if (checkTileIsLight(tileCoords, playerZ) == false)
+                    {
+                        continue;
+                    }
 
-                spriteLight.setTexture(tibia::Textures::light2);
+                    sf::Sprite spriteLight;
 
-                spriteLight.setOrigin(spriteLight.getLocalBounds().width / 2, spriteLight.getLocalBounds().height / 2);
-                spriteLight.setPosition(tileCoords.x + (tibia::TILE_SIZE / 2), tileCoords.y + (tibia::TILE_SIZE / 2));
+                    tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light2);
 
-                spriteLight.setColor(tibia::Colors::light);
+                    spriteLight.setOrigin(spriteLight.getLocalBounds().width / 2, spriteLight.getLocalBounds().height / 2);
+                    spriteLight.setPosition(tileCoords.x + (tibia::TILE_SIZE / 2), tileCoords.y + (tibia::TILE_SIZE / 2));
 
-                m_rtLight.draw(spriteLight, sf::BlendMode::BlendAdd);
+                    spriteLight.setColor(tibia::Colors::light);
+
+                    m_rtLight.draw(spriteLight, sf::BlendMode::BlendAdd);
+                }
             }
 
             for (auto projectile : m_projectilesList)
             {
-                if (projectile->getZ() != tibia::ZAxis::underGround)
+                if (projectile->getZ() != playerZ)
                 {
                     continue;
                 }
@@ -1715,7 +3589,7 @@ public:
 
                 sf::Sprite spriteLight;
 
-                spriteLight.setTexture(tibia::Textures::light);
+                tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light);
 
                 spriteLight.setOrigin(spriteLight.getLocalBounds().width / 2, spriteLight.getLocalBounds().height / 2);
                 spriteLight.setPosition(tileCoords.x + (tibia::TILE_SIZE / 2), tileCoords.y + (tibia::TILE_SIZE / 2));
@@ -1727,7 +3601,7 @@ public:
 
             for (auto animation : m_animationsList)
             {
-                if (animation->getZ() != tibia::ZAxis::underGround)
+                if (animation->getZ() != playerZ)
                 {
                     continue;
                 }
@@ -1736,7 +3610,7 @@ public:
 
                 sf::Sprite spriteLight;
 
-                spriteLight.setTexture(tibia::Textures::light);
+                tibia::Textures::atlas.setSprite(spriteLight, tibia::TextureAtlasRegions::light);
 
                 spriteLight.setOrigin(spriteLight.getLocalBounds().width / 2, spriteLight.getLocalBounds().height / 2);
                 spriteLight.setPosition(tileCoords.x + (tibia::TILE_SIZE / 2), tileCoords.y + (tibia::TILE_SIZE / 2));
@@ -1748,6 +3622,8 @@ public:
 
             m_rtLight.display();
 
+            m_rectLight.setPosition(lightView.getCenter() - (lightView.getSize() / 2.0f));
+
             m_rectLight.setTexture(&m_rtLight.getTexture());
 
             m_window.draw(m_rectLight, sf::BlendMode::BlendMultiply);
@@ -1755,6 +3631,8 @@ public:
 
         drawCreatureBars();
 
+        drawLabels();
+
         drawGameText();
 
         m_window.display();
@@ -1766,19 +3644,14 @@ public:
         mainWindow->draw(m_windowSprite);
     }
 
-    void addMiniMapObjects(std::vector<sf::Vertex> &verticesList)
+    void addMiniMapObjects(tibia::FrameVector<sf::Vertex> &verticesList)
     {
-        for (auto object : m_objectsList)
-        {
-            if (object->getZ() != m_player->getZ())
-            {
-                continue;
-            }
+        m_objectsQueryList.clear();
 
-            if (calculateDistanceBetweenThings(m_player.get(), object.get()) > (tibia::DRAW_DISTANCE_MAX * 2))
-            {
-                continue;
-            }
+        m_objectIndex.query(getTileRectAroundPlayer(tibia::DRAW_DISTANCE_MAX * 2), m_player->getZ(), m_objectsQueryList);
+
+        for (auto object : m_objectsQueryList)
+        {
 
             int tileFlags = tibia::spriteFlags[object->getId()];
 
@@ -1816,26 +3689,30 @@ public:
         }
     }
 
-    void addMiniMapCreatures(std::vector<sf::Vertex> &verticesList)
+    void addMiniMapCreatures(tibia::FrameVector<sf::Vertex> &verticesList)
     {
-        for (auto creature : m_creaturesList)
+        updateLocalObserver();
+
+        sf::IntRect miniMapTileRect = getTileRectAroundPlayer(static_cast<int>(tibia::DRAW_DISTANCE_MAX * 2));
+
+        for (auto creature : m_interestManager.getCreatures(m_localObserverId))
         {
             if (creature->isPlayer() == true)
             {
                 continue;
             }
 
-            if (creature->isDead() == true)
+            if (miniMapTileRect.contains(creature->getX(), creature->getY()) == false)
             {
                 continue;
             }
 
-            if (creature->getZ() != m_player->getZ())
+            if (creature->isDead() == true)
             {
                 continue;
             }
 
-            if (creature->getDistanceFromPlayer() > (tibia::DRAW_DISTANCE_MAX * 2))
+            if (creature->getZ() != m_player->getZ())
             {
                 continue;
             }
@@ -1886,26 +3763,34 @@ public:
 
     void updateMiniMapWindow()
     {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::render);
+
         m_miniMapWindow.clear(tibia::Colors::black);
 
-        std::vector<sf::Vertex> miniMapVertices;
+        // only the tiles the mini map view can show, with a margin for movement until the next update
+        int miniMapTileWidth  = (m_miniMapWindowView.getSize().x / tibia::TILE_SIZE) + (tibia::NUM_TILES_X * 2);
+        int miniMapTileHeight = (m_miniMapWindowView.getSize().y / tibia::TILE_SIZE) + (tibia::NUM_TILES_Y * 2);
 
-        switch (m_player->getZ())
-        {
-            case tibia::ZAxis::underGround:
-                m_map.tileMapUnderGroundTiles.addMiniMapTiles(miniMapVertices);
-                m_map.tileMapUnderGroundObjects.addMiniMapTiles(miniMapVertices);
-                break;
+        // a quad per tile on both tile maps, reserved up front so the vector never moves inside the arena
+        tibia::FrameAllocator<sf::Vertex> miniMapAllocator(&m_frameArena);
 
-            case tibia::ZAxis::ground:
-                m_map.tileMapGroundTiles.addMiniMapTiles(miniMapVertices);
-                m_map.tileMapGroundObjects.addMiniMapTiles(miniMapVertices);
-                break;
+        tibia::FrameVector<sf::Vertex> miniMapVertices(miniMapAllocator);
+        miniMapVertices.reserve((miniMapTileWidth * miniMapTileHeight * 2 * 4) + 4);
 
-            case tibia::ZAxis::aboveGround:
-                m_map.tileMapAboveGroundTiles.addMiniMapTiles(miniMapVertices);
-                m_map.tileMapAboveGroundObjects.addMiniMapTiles(miniMapVertices);
-                break;
+        sf::IntRect miniMapTileRect
+        (
+            (m_player->getTileX() / tibia::TILE_SIZE) - (miniMapTileWidth  / 2),
+            (m_player->getTileY() / tibia::TILE_SIZE) - (miniMapTileHeight / 2),
+            miniMapTileWidth,
+            miniMapTileHeight
+        );
+
+        tibia::Map::Floor* floor = m_map.getFloor(m_player->getZ());
+
+        if (floor != nullptr)
+        {
+            floor->tileMaps[tibia::TileMapTypes::tiles].addMiniMapTiles(miniMapVertices, miniMapTileRect);
+            floor->tileMaps[tibia::TileMapTypes::objects].addMiniMapTiles(miniMapVertices, miniMapTileRect);
         }
 
         addMiniMapObjects(miniMapVertices);
@@ -1932,8 +3817,10 @@ public:
         m_miniMapWindow.draw(&miniMapVertices[0], miniMapVertices.size(), sf::Quads);
     }
 
-    void drawMiniMapWindow(sf::RenderWindow* mainWindow)
+    void drawMiniMapWindow(sf::RenderTarget* mainWindow)
     {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::render);
+
         m_miniMapWindowView.setCenter
         (
             m_player->getTileX() + (tibia::TILE_SIZE / 2),
@@ -1967,14 +3854,11 @@ public:
     {
         int tileFlags = 0;
 
-        for (auto tileMapList_it = m_map.tileMapList.begin(); tileMapList_it != m_map.tileMapList.end(); tileMapList_it++)
-        {
-            tibia::TileMap* tileMap = *tileMapList_it;
+        tibia::Map::Floor* floor = m_map.getFloor(tileZ);
 
-            if (tileMap->getZ() != tileZ)
-            {
-                continue;
-            }
+        for (int i = 0; floor != nullptr && i < tibia::TileMapTypes::numTypes; i++)
+        {
+            tibia::TileMap* tileMap = &floor->tileMaps[i];
 
             if (tileMap->getType() == tibia::TileMapTypes::edges)
             {
@@ -1999,40 +3883,21 @@ public:
 
             int tileNumber = tibia::getTileNumberByTileCoords(tilePosition.x, tilePosition.y);
 
-            if (tileNumber < 0 || tileNumber > tibia::TILE_NUMBER_MAX)
-            {
-                continue;
-            }
-
-            std::vector<tibia::TileMap::TilePtr> *tilesList = tileMap->getTilesList();
+            tibia::Tile* tile = tileMap->getTile(tileNumber);
 
-            if (tilesList->size() == 0 || tilesList->size() < tileNumber)
+            if (tile == nullptr)
             {
                 continue;
             }
 
-            tibia::Tile* tile = tilesList->at(tileNumber).get();
-
             tileFlags |= tile->getFlags();
         }
 
-        for (auto object : m_objectsList)
+        for (auto object : m_objectIndex.getObjects(tilePosition.x / tibia::TILE_SIZE, tilePosition.y / tibia::TILE_SIZE, tileZ))
         {
-            if (object->getZ() != tileZ)
-            {
-                continue;
-            }
-
-            if
-            (
-                object->getPosition().x == tilePosition.x &&
-                object->getPosition().y == tilePosition.y
-            )
-            {
-                int tileObjectFlags = tibia::spriteFlags[object->getId()];
+            int tileObjectFlags = tibia::spriteFlags[object->getId()];
 
-                tileFlags |= tileObjectFlags;
-            }
+            tileFlags |= tileObjectFlags;
         }
 
         return tileFlags;
@@ -2040,6 +3905,11 @@ public:
 
     bool checkTileIsNull(sf::Vector2u tilePosition, int tileZ)
     {
+        if (m_map.getFloor(tileZ) == nullptr)
+        {
+            return true;
+        }
+
         int tileFlags = getTileFlags(tilePosition, tileZ);
 
         return tileFlags & tibia::TileFlags::null;
@@ -2115,11 +3985,19 @@ public:
         return tileFlags & tibia::TileFlags::light;
     }
 
+    // only the creatures in the grid cell holding the tile are compared
     tibia::Creature* checkTileHasCreature(sf::Vector2u tilePosition, int tileZ, bool skipDead = true)
     {
         tibia::Creature* foundCreature = nullptr;
 
-        for (auto creature : m_creaturesList)
+        const std::vector<tibia::Creature*>* cell = m_creaturesGrid.getCell(tilePosition.x / tibia::TILE_SIZE, tilePosition.y / tibia::TILE_SIZE);
+
+        if (cell == nullptr)
+        {
+            return foundCreature;
+        }
+
+        for (auto creature : *cell)
         {
             //if (creature->isPlayer() == true)
             //{
@@ -2138,7 +4016,7 @@ public:
             {
                 if (creature->getTileX() == tilePosition.x && creature->getTileY() == tilePosition.y)
                 {
-                    return creature.get();
+                    return creature;
                 }
             }
         }
@@ -2165,7 +4043,7 @@ public:
                 break;
 
             case tibia::Directions::right:
-                if (creature->getX() == tibia::MAP_SIZE - 1)
+                if (creature->getX() == tibia::MapSize::width - 1)
                 {
                     break;
                 }
@@ -2174,7 +4052,7 @@ public:
                 break;
 
             case tibia::Directions::down:
-                if (creature->getY() == tibia::MAP_SIZE - 1)
+                if (creature->getY() == tibia::MapSize::height - 1)
                 {
                     break;
                 }
@@ -2201,7 +4079,7 @@ public:
                 break;
 
             case tibia::Directions::upRight:
-                if (creature->getY() == 0 || creature->getX() == tibia::MAP_SIZE - 1)
+                if (creature->getY() == 0 || creature->getX() == tibia::MapSize::width - 1)
                 {
                     break;
                 }
@@ -2210,7 +4088,7 @@ public:
                 break;
 
             case tibia::Directions::downLeft:
-                if (creature->getY() == tibia::MAP_SIZE - 1 || creature->getX() == 0)
+                if (creature->getY() == tibia::MapSize::height - 1 || creature->getX() == 0)
                 {
                     break;
                 }
@@ -2219,7 +4097,7 @@ public:
                 break;
 
             case tibia::Directions::downRight:
-                if (creature->getY() == tibia::MAP_SIZE - 1 || creature->getX() == tibia::MAP_SIZE - 1)
+                if (creature->getY() == tibia::MapSize::height - 1 || creature->getX() == tibia::MapSize::width - 1)
                 {
                     break;
                 }
@@ -2244,9 +4122,17 @@ public:
 
         int checkTileNumber = tibia::getTileNumberByTileCoords(checkTileCoords.x, checkTileCoords.y);
 
-        if (creature->getZ() == tibia::ZAxis::aboveGround)
+        if (creature->getZ() > tibia::ZAxis::ground)
         {
-            int checkTileId = m_map.tileMapAboveGroundTiles.getTilesList()->at(checkTileNumber)->getId();
+            tibia::TileMap* tileMap = m_map.getTileMap(creature->getZ(), tibia::TileMapTypes::tiles);
+
+            // a floor the map does not have has nothing to walk on
+            if (tileMap == nullptr)
+            {
+                return true;
+            }
+
+            int checkTileId = tileMap->getTileId(checkTileNumber);
 
             if (checkTileId == tibia::TILE_NULL)
             {
@@ -2326,24 +4212,14 @@ public:
             return false;
         }
 
-        tibia::TileMap* tileMap;
+        tibia::TileMap* tileMap = m_map.getTileMap(creature->getZ(), tibia::TileMapTypes::tiles);
 
-        switch (creature->getZ())
+        if (tileMap == nullptr)
         {
-            case tibia::ZAxis::aboveGround:
-                tileMap = &m_map.tileMapAboveGroundTiles;
-                break;
-
-            case tibia::ZAxis::ground:
-                tileMap = &m_map.tileMapGroundTiles;
-                break;
-
-            case tibia::ZAxis::underGround:
-                tileMap = &m_map.tileMapUnderGroundTiles;
-                break;
+            return false;
         }
 
-        int checkTileId = tileMap->getTilesList()->at(checkTileNumber)->getId();
+        int checkTileId = tileMap->getTileId(checkTileNumber);
 
         int newTileId = 0;
 
@@ -2375,11 +4251,21 @@ public:
             return false;
         }
 
-        tileMap->updateTileId(checkTileNumber, newTileId);
+        updateTileId(tileMap, checkTileNumber, newTileId);
 
         return true;
     }
 
+    // the lod chunks baked with the old tile are baked again
+    void updateTileId(tibia::TileMap* tileMap, int tileNumber, int tileId)
+    {
+        tileMap->updateTileId(tileNumber, tileId);
+
+        sf::Vector2u tileCoords = tibia::getTileCoordsByTileNumber(tileNumber);
+
+        removeChunkTextures(tileCoords.x / tibia::TILE_SIZE, tileCoords.y / tibia::TILE_SIZE, tileMap->getZ());
+    }
+
     bool doCreatureUseLever(tibia::Creature* creature, sf::Vector2u tilePosition)
     {
         int creatureDistanceFromTile = calculateDistanceByTile(creature->getTileX(), creature->getTileY(), tilePosition.x, tilePosition.y);
@@ -2391,21 +4277,11 @@ public:
             return false;
         }
 
-        tibia::TileMap* tileMap;
+        tibia::TileMap* tileMap = m_map.getTileMap(creature->getZ(), tibia::TileMapTypes::objects);
 
-        switch (creature->getZ())
+        if (tileMap == nullptr)
         {
-            case tibia::ZAxis::aboveGround:
-                tileMap = &m_map.tileMapAboveGroundObjects;
-                break;
-
-            case tibia::ZAxis::ground:
-                tileMap = &m_map.tileMapGroundObjects;
-                break;
-
-            case tibia::ZAxis::underGround:
-                tileMap = &m_map.tileMapUnderGroundObjects;
-                break;
+            return false;
         }
 
         int tileNumber = tibia::getTileNumberByTileCoords(tilePosition.x, tilePosition.y);
@@ -2415,7 +4291,7 @@ public:
             return false;
         }
 
-        int checkTileId = tileMap->getTilesList()->at(tileNumber)->getId();
+        int checkTileId = tileMap->getTileId(tileNumber);
 
         int newTileId = 0;
 
@@ -2433,7 +4309,7 @@ public:
             return false;
         }
 
-        tileMap->updateTileId(tileNumber, newTileId);
+        updateTileId(tileMap, tileNumber, newTileId);
 
         return true;
     }
@@ -2518,6 +4394,13 @@ public:
 
     bool isPlayerNearWater()
     {
+        tibia::TileMap* tileMap = m_map.getTileMap(m_player->getZ(), tibia::TileMapTypes::tiles);
+
+        if (tileMap == nullptr)
+        {
+            return false;
+        }
+
         int x = m_player->getX() - NUM_TILES_FROM_CENTER_X;
         int y = m_player->getY() - NUM_TILES_FROM_CENTER_Y;
 
@@ -2528,17 +4411,19 @@ public:
         {
             for (int j = y; j < y + tibia::NUM_TILES_Y; j++)
             {
-                if (i > tibia::MAP_SIZE - 1) continue;
-                if (j > tibia::MAP_SIZE - 1) continue;
+                if (i > tibia::MapSize::width  - 1) continue;
+                if (j > tibia::MapSize::height - 1) continue;
 
                 int tileNumber = tibia::getTileNumberByTileCoords(i * tibia::TILE_SIZE, j * tibia::TILE_SIZE);
 
-                if (tileNumber < 0 || tileNumber > tibia::TILE_NUMBER_MAX)
+                tibia::Tile* tile = tileMap->getTile(tileNumber);
+
+                if (tile == nullptr)
                 {
                     continue;
                 }
 
-                if (m_map.tileMapGroundTiles.getTilesList()->at(tileNumber)->getFlags() & tibia::TileFlags::water)
+                if (tile->getFlags() & tibia::TileFlags::water)
                 {
                     return true;
                 }
@@ -2560,8 +4445,8 @@ public:
         {
             for (int j = y; j < y + tibia::NUM_TILES_Y; j++)
             {
-                if (i > tibia::MAP_SIZE - 1) continue;
-                if (j > tibia::MAP_SIZE - 1) continue;
+                if (i > tibia::MapSize::width  - 1) continue;
+                if (j > tibia::MapSize::height - 1) continue;
 
                 tibia::Sprite spr;
                 spr.setId(1);
@@ -2612,9 +4497,9 @@ public:
         return &m_projectilesList;
     }
 
-    std::vector<SoundPtr>* getSoundList()
+    tibia::SoundMixer* getSoundMixer()
     {
-        return &m_soundsList;
+        return &m_soundMixer;
     }
 
     sf::Clock* getClock()
@@ -2622,14 +4507,19 @@ public:
         return &m_clock;
     }
 
-    sf::Clock* getClockAnimatedWaterAndObjects()
+    unsigned int getTick()
+    {
+        return m_tick;
+    }
+
+    float getTime()
     {
-        return &m_clockAnimatedWaterAndObjects;
+        return m_tick * tibia::TICK_TIME;
     }
 
-    sf::Clock* getClockCreatureLogic()
+    tibia::CommandStream* getCommandStream()
     {
-        return &m_clockCreatureLogic;
+        return &m_commandStream;
     }
 
     sf::Clock* getClockMiniMap()
@@ -2672,16 +4562,93 @@ public:
         return &m_map;
     }
 
+    // the tiles in view as of the last updateWindowView
+    sf::IntRect getWindowViewTileRect()
+    {
+        return m_viewTileRect;
+    }
+
+    void setStatePublisher(tibia::StatePublisher* statePublisher)
+    {
+        m_statePublisher = statePublisher;
+    }
+
+    bool isSpectating()
+    {
+        return m_isSpectating;
+    }
+
     tibia::Creature* getPlayer()
     {
         return m_player.get();
     }
 
+    // releases the transient data of the frame, call once the frame has been displayed
+    void endFrame()
+    {
+        m_frameArena.reset();
+    }
+
+    tibia::FrameArena* getFrameArena()
+    {
+        return &m_frameArena;
+    }
+
+    tibia::InterestManager* getInterestManager()
+    {
+        return &m_interestManager;
+    }
+
+    tibia::CombatLog* getCombatLog()
+    {
+        return &m_combatLog;
+    }
+
+    tibia::Profiler* getProfiler()
+    {
+        return &m_profiler;
+    }
+
+    tibia::TextCache* getTextCache()
+    {
+        return &m_textCache;
+    }
+
+    bool getShowCreatureNames()
+    {
+        return m_showCreatureNames;
+    }
+
+    void setShowCreatureNames(bool b)
+    {
+        m_showCreatureNames = b;
+    }
+
+    int getNumFloatingTexts()
+    {
+        return m_floatingTextsList.size();
+    }
+
+    int getNumCreaturesWarm()
+    {
+        return m_creaturesWarmList.size();
+    }
+
 private:
 
+    tibia::Random m_random;
+
+    unsigned int m_tick;
+
+    tibia::CommandStream m_commandStream;
+
+    std::vector<tibia::Command> m_commandsList;
+
+    std::vector<int> m_spriteFlagsList;
+
+    std::unordered_map<int, tibia::Creature*> m_commandCreaturesList;
+
     sf::Clock m_clock;
-    sf::Clock m_clockAnimatedWaterAndObjects;
-    sf::Clock m_clockCreatureLogic;
     sf::Clock m_clockMiniMap;
 
     sf::RenderTexture m_window;
@@ -2703,23 +4670,94 @@ private:
 
     std::vector<sf::Text> m_textList;
 
-    sf::Clock m_clockText;
+    tibia::FrameArena m_frameArena;
+
+    tibia::TextCache m_textCache;
+
+    tibia::BitmapTextBatch m_labelBatch;
+
+    std::vector<tibia::FloatingText> m_floatingTextsList;
+
+    bool m_showCreatureNames;
+
+    unsigned int m_tickTextExpiry;
+
+    TimerWheel m_timerWheel;
+
+    TimerWheel::TimerList m_timersDueList;
+    TimerWheel::TimerList m_timersSnapshotList;
+
+    bool m_hasFinishedAnimations;
 
     tibia::Map m_map;
 
+    tibia::CombatLog m_combatLog;
+
+    tibia::Profiler m_profiler;
+
     sf::VertexArray m_tileVertices;
 
     CreaturePtr m_player;
 
     std::vector<tibia::Thing*> m_thingsList;
+
+    std::vector<std::pair<tibia::Thing*, unsigned int>> m_thingsSortList;
     std::vector<tibia::Thing*> m_thingsSpawnList;
 
     std::vector<tibia::Map::ObjectPtr> m_objectsList;
     std::vector<tibia::Map::ObjectPtr> m_objectsSpawnList;
 
+    tibia::ObjectIndex m_objectIndex;
+
+    std::vector<tibia::Object*> m_objectsQueryList;
+
+    bool m_isViewLod;
+
+    int m_numChunksBaked;
+
+    tibia::ChunkTextureCache m_chunkTextureCache;
+
+    tibia::StatePublisher* m_statePublisher;
+
+    std::vector<tibia::StateCreature> m_stateCreaturesList;
+
+    bool m_isSpectating;
+
+    std::unordered_map<int, CreaturePtr> m_spectatorCreaturesList;
+    std::unordered_map<int, CreaturePtr> m_spectatorCreaturesSeenList;
+
+    int m_nextCreatureSpawnId;
+
+    sf::RenderTexture m_rtChunk;
+
+    sf::VertexArray m_chunkVertices;
+
     std::vector<CreaturePtr> m_creaturesList;
     std::vector<CreaturePtr> m_creaturesSpawnList;
 
+    std::vector<tibia::Creature*> m_creaturesWarmList;
+
+    sf::Vector2i m_creaturesWarmListOrigin;
+
+    bool m_creaturesWarmListIsDirty;
+
+    bool m_hasDecayedCreatures;
+
+    bool m_playerHasMoved;
+
+    tibia::SpatialGrid<tibia::Creature> m_creaturesGrid;
+    tibia::SpatialGrid<tibia::Animation> m_animatedDecalsGrid;
+
+    sf::IntRect m_viewTileRect;
+
+    std::vector<tibia::Creature*> m_creaturesVisibleList;
+
+    tibia::InterestManager m_interestManager;
+
+    int m_localObserverId;
+
+    std::vector<tibia::Animation*> m_animatedDecalsVisibleList;
+
     std::vector<AnimationPtr> m_animationsList;
     std::vector<AnimationPtr> m_animationsSpawnList;
 
@@ -2729,8 +4767,10 @@ private:
     std::vector<ProjectilePtr> m_projectilesList;
     std::vector<ProjectilePtr> m_projectilesSpawnList;
 
-    std::vector<SoundPtr> m_soundsList;
-    std::vector<SoundPtr> m_soundsSpawnList;
+    // voices are stopped before the buffers they play are released
+    tibia::SoundBank m_soundBank;
+
+    tibia::SoundMixer m_soundMixer;
 };
 
 }
@@ -0,0 +1,312 @@
+#ifndef TIBIA_INTERESTMANAGER_HPP
+#define TIBIA_INTERESTMANAGER_HPP
+
+#include <vector>
+#include <unordered_map>
+
+#include <SFML/Graphics.hpp>
+
+#include "tibia/Tibia.hpp"
+#include "tibia/Creature.hpp"
+#include "tibia/SpatialGrid.hpp"
+
+namespace tibia
+{
+
+// keeps, for every observer, the set of creatures in the grid cells its rectangle overlaps.
+// each cell knows the observers covering it, so a creature crossing a cell boundary only touches
+// the observers of the two cells and an observer moving only touches the cells it gained or lost.
+// the set is a superset of what the observer cares about, users still compare coords and floors
+class InterestManager : public tibia::SpatialGrid<tibia::Creature>::Listener
+{
+
+public:
+
+    struct Observer
+    {
+        bool isActive;
+
+        sf::IntRect tileRect;
+        sf::IntRect cellRect;
+
+        std::vector<tibia::Creature*> creaturesList;
+
+        // index of each creature in creaturesList
+        std::unordered_map<tibia::Creature*, int> creatureIndexesList;
+    };
+
+    InterestManager()
+    {
+        m_grid = nullptr;
+
+        m_numChanges = 0;
+    }
+
+    // call after the grid has been created, observers keep their rectangles
+    void create(tibia::SpatialGrid<tibia::Creature>* grid)
+    {
+        m_grid = grid;
+
+        m_cellObserversList.clear();
+        m_cellObserversList.resize(m_grid->getNumCells());
+
+        for (auto& observer : m_observersList)
+        {
+            observer.cellRect = sf::IntRect(0, 0, 0, 0);
+
+            observer.creaturesList.clear();
+            observer.creatureIndexesList.clear();
+        }
+
+        for (unsigned int i = 0; i < m_observersList.size(); i++)
+        {
+            if (m_observersList[i].isActive == true)
+            {
+                setCellRect(i, m_grid->getCellRect(m_observersList[i].tileRect));
+            }
+        }
+    }
+
+    int addObserver(sf::IntRect tileRect)
+    {
+        int observerId = -1;
+
+        for (unsigned int i = 0; i < m_observersList.size(); i++)
+        {
+            if (m_observersList[i].isActive == false)
+            {
+                observerId = i;
+                break;
+            }
+        }
+
+        if (observerId == -1)
+        {
+            observerId = m_observersList.size();
+
+            m_observersList.push_back(Observer());
+        }
+
+        Observer& observer = m_observersList[observerId];
+        observer.isActive = true;
+        observer.tileRect = sf::IntRect(0, 0, 0, 0);
+        observer.cellRect = sf::IntRect(0, 0, 0, 0);
+
+        setObserverRect(observerId, tileRect);
+
+        return observerId;
+    }
+
+    void removeObserver(int observerId)
+    {
+        setCellRect(observerId, sf::IntRect(0, 0, 0, 0));
+
+        m_observersList[observerId].isActive = false;
+    }
+
+    // rectangle of tiles the observer is interested in, costs nothing unless it now overlaps other cells
+    void setObserverRect(int observerId, sf::IntRect tileRect)
+    {
+        m_observersList[observerId].tileRect = tileRect;
+
+        if (m_grid == nullptr)
+        {
+            return;
+        }
+
+        sf::IntRect cellRect = m_grid->getCellRect(tileRect);
+
+        if (cellRect == m_observersList[observerId].cellRect)
+        {
+            return;
+        }
+
+        setCellRect(observerId, cellRect);
+    }
+
+    const std::vector<tibia::Creature*>& getCreatures(int observerId)
+    {
+        return m_observersList[observerId].creaturesList;
+    }
+
+    bool hasCreature(int observerId, tibia::Creature* creature)
+    {
+        std::unordered_map<tibia::Creature*, int>& creatureIndexesList = m_observersList[observerId].creatureIndexesList;
+
+        return creatureIndexesList.find(creature) != creatureIndexesList.end();
+    }
+
+    // creatures added to or removed from a set since the start
+    unsigned int getNumChanges()
+    {
+        return m_numChanges;
+    }
+
+    void onThingAdded(tibia::Creature* creature, int cellIndex)
+    {
+        for (auto observerId : m_cellObserversList[cellIndex])
+        {
+            addCreature(m_observersList[observerId], creature);
+        }
+    }
+
+    void onThingRemoved(tibia::Creature* creature, int cellIndex)
+    {
+        for (auto observerId : m_cellObserversList[cellIndex])
+        {
+            removeCreature(m_observersList[observerId], creature);
+        }
+    }
+
+    // observers covering both cells keep the creature
+    void onThingMoved(tibia::Creature* creature, int fromCellIndex, int toCellIndex)
+    {
+        for (auto observerId : m_cellObserversList[fromCellIndex])
+        {
+            if (isCellInRect(m_observersList[observerId].cellRect, toCellIndex) == false)
+            {
+                removeCreature(m_observersList[observerId], creature);
+            }
+        }
+
+        for (auto observerId : m_cellObserversList[toCellIndex])
+        {
+            if (isCellInRect(m_observersList[observerId].cellRect, fromCellIndex) == false)
+            {
+                addCreature(m_observersList[observerId], creature);
+            }
+        }
+    }
+
+private:
+
+    // unsubscribes from the cells only in the old rectangle and subscribes to the cells only in the new one
+    void setCellRect(int observerId, sf::IntRect cellRect)
+    {
+        Observer& observer = m_observersList[observerId];
+
+        sf::IntRect oldCellRect = observer.cellRect;
+
+        for (int cellY = oldCellRect.top; cellY < oldCellRect.top + oldCellRect.height; cellY++)
+        {
+            for (int cellX = oldCellRect.left; cellX < oldCellRect.left + oldCellRect.width; cellX++)
+            {
+                if (cellRect.contains(cellX, cellY) == true)
+                {
+                    continue;
+                }
+
+                int cellIndex = m_grid->getCellIndexByCellCoords(cellX, cellY);
+
+                std::vector<int>& cellObservers = m_cellObserversList[cellIndex];
+
+                for (unsigned int i = 0; i < cellObservers.size(); i++)
+                {
+                    if (cellObservers[i] == observerId)
+                    {
+                        cellObservers[i] = cellObservers.back();
+                        cellObservers.pop_back();
+
+                        break;
+                    }
+                }
+
+                for (auto creature : m_grid->getCellByIndex(cellIndex))
+                {
+                    removeCreature(observer, creature);
+                }
+            }
+        }
+
+        for (int cellY = cellRect.top; cellY < cellRect.top + cellRect.height; cellY++)
+        {
+            for (int cellX = cellRect.left; cellX < cellRect.left + cellRect.width; cellX++)
+            {
+                if (oldCellRect.contains(cellX, cellY) == true)
+                {
+                    continue;
+                }
+
+                int cellIndex = m_grid->getCellIndexByCellCoords(cellX, cellY);
+
+                m_cellObserversList[cellIndex].push_back(observerId);
+
+                for (auto creature : m_grid->getCellByIndex(cellIndex))
+                {
+                    addCreature(observer, creature);
+                }
+            }
+        }
+
+        observer.cellRect = cellRect;
+    }
+
+    bool isCellInRect(const sf::IntRect& cellRect, int cellIndex)
+    {
+        for (int cellY = cellRect.top; cellY < cellRect.top + cellRect.height; cellY++)
+        {
+            int first = m_grid->getCellIndexByCellCoords(cellRect.left, cellY);
+
+            if (cellIndex >= first && cellIndex < first + cellRect.width)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void addCreature(Observer& observer, tibia::Creature* creature)
+    {
+        if (observer.creatureIndexesList.find(creature) != observer.creatureIndexesList.end())
+        {
+            return;
+        }
+
+        observer.creatureIndexesList[creature] = observer.creaturesList.size();
+
+        observer.creaturesList.push_back(creature);
+
+        m_numChanges++;
+    }
+
+    void removeCreature(Observer& observer, tibia::Creature* creature)
+    {
+        auto creatureIndexesList_it = observer.creatureIndexesList.find(creature);
+
+        if (creatureIndexesList_it == observer.creatureIndexesList.end())
+        {
+            return;
+        }
+
+        int index = creatureIndexesList_it->second;
+
+        observer.creatureIndexesList.erase(creatureIndexesList_it);
+
+        tibia::Creature* lastCreature = observer.creaturesList.back();
+
+        observer.creaturesList[index] = lastCreature;
+        observer.creaturesList.pop_back();
+
+        if (lastCreature != creature)
+        {
+            observer.creatureIndexesList[lastCreature] = index;
+        }
+
+        m_numChanges++;
+    }
+
+    tibia::SpatialGrid<tibia::Creature>* m_grid;
+
+    std::vector<Observer> m_observersList;
+
+    // the observers whose rectangle overlaps each cell
+    std::vector<std::vector<int>> m_cellObserversList;
+
+    unsigned int m_numChanges;
+
+};
+
+}
+
+#endif // TIBIA_INTERESTMANAGER_HPP
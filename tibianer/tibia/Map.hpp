@@ -5,6 +5,10 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/range/algorithm/replace_if.hpp>
@@ -16,6 +20,9 @@
 #include "tinyxml2.h"
 
 #include "tibia/Tibia.hpp"
+#include "tibia/TileMap.hpp"
+#include "tibia/TileChunk.hpp"
+#include "tibia/BinaryStream.hpp"
 #include "tibia/Object.hpp"
 
 namespace tibia
@@ -29,136 +36,130 @@ public:
     typedef std::shared_ptr<tibia::Object> ObjectPtr;
     typedef std::vector<ObjectPtr> ObjectList;
 
-    std::vector<tibia::TileMap*> tileMapList;
+    // one tile map per type, indexed by tibia::TileMapTypes
+    struct Floor
+    {
+        int z;
+
+        tibia::TileMap tileMaps[tibia::TileMapTypes::numTypes];
+    };
 
-    tibia::TileMap tileMapUnderGroundTiles;
-    tibia::TileMap tileMapUnderGroundEdges;
-    tibia::TileMap tileMapUnderGroundObjects;
+    struct Layer
+    {
+        int z;
+        int type;
+    };
 
-    tibia::TileMap tileMapGroundTiles;
-    tibia::TileMap tileMapGroundEdges;
-    tibia::TileMap tileMapGroundObjects;
+    std::vector<tibia::TileMap*> tileMapList;
 
-    tibia::TileMap tileMapAboveGroundTiles;
-    tibia::TileMap tileMapAboveGroundEdges;
-    tibia::TileMap tileMapAboveGroundObjects;
+    Map()
+    {
+        m_floorZMin = tibia::ZAxis::ground;
+        m_floorZMax = tibia::ZAxis::ground;
+    }
 
     bool load(std::string filename)
     {
         tinyxml2::XMLDocument doc;
-        doc.LoadFile(filename.c_str());
-
-        tinyxml2::XMLElement* docMap = doc.FirstChildElement();
 
-        for (tinyxml2::XMLElement* docMapLayer = docMap->FirstChildElement("layer"); docMapLayer != NULL; docMapLayer = docMapLayer->NextSiblingElement("layer"))
+        if (doc.LoadFile(filename.c_str()) != tinyxml2::XML_SUCCESS)
         {
-            std::string docMapLayerName = docMapLayer->Attribute("name");
-
-            //std::cout << docMapLayerName << std::endl;
-
-            std::string docMapLayerData = docMapLayer->FirstChildElement("data")->GetText();
+            return false;
+        }
 
-            docMapLayerData.erase(boost::remove_if(docMapLayerData, boost::is_any_of(" \r\n")), docMapLayerData.end());
+        tinyxml2::XMLElement* docMap = doc.FirstChildElement();
 
-            docMapLayerData = base64_decode(docMapLayerData);
-            docMapLayerData = boost_zlib_decompress_string_fast(docMapLayerData);
+        tibia::MapSize::width  = docMap->IntAttribute("width");
+        tibia::MapSize::height = docMap->IntAttribute("height");
 
-            //std::cout << docMapLayerData << std::endl;
+        std::string chunkFilename = filename + ".chunks";
 
-            std::istringstream docMapLayerDataStream(docMapLayerData);
-            //docMapLayerDataStream.seekg(0, std::ios::beg);
+        std::uint64_t fileHash = tibia::BinaryStream::getFileHash(filename);
 
-            std::vector<int> docMapLayerDataTiles;
-            docMapLayerDataTiles.reserve(docMapLayerData.size() / 4);
+        if (m_chunkFile.open(chunkFilename, fileHash) == false)
+        {
+            std::cout << "Creating map chunk file: " << chunkFilename << std::endl;
 
-            for (unsigned int i = 0; i < docMapLayerData.size(); i += 4)
+            if (createChunkFile(docMap, chunkFilename, fileHash) == false)
             {
-                int tileId;
-                docMapLayerDataStream.read(reinterpret_cast<char*>(&tileId), 4);
-
-                docMapLayerDataTiles.push_back(tileId);
+                return false;
             }
 
-            if (docMapLayerName == "underground tiles")
-            {
-                tileMapUnderGroundTiles.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::tiles, tibia::ZAxis::underGround);
-            }
-            else if (docMapLayerName == "underground tile edges")
-            {
-                tileMapUnderGroundEdges.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::edges, tibia::ZAxis::underGround);
-            }
-            else if (docMapLayerName == "underground tile objects")
+            if (m_chunkFile.open(chunkFilename, fileHash) == false)
             {
-                tileMapUnderGroundObjects.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::objects, tibia::ZAxis::underGround);
+                return false;
             }
+        }
 
-            else if (docMapLayerName == "ground tiles")
-            {
-                tileMapGroundTiles.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::tiles, tibia::ZAxis::ground);
-            }
-            else if (docMapLayerName == "ground tile edges")
-            {
-                tileMapGroundEdges.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::edges, tibia::ZAxis::ground);
-            }
-            else if (docMapLayerName == "ground tile objects")
-            {
-                tileMapGroundObjects.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::objects, tibia::ZAxis::ground);
-            }
+        // the floor and type of each layer come from its "z" and "type" properties or its name,
+        // floors are created for every z in between the lowest and highest one used
 
-            else if (docMapLayerName == "aboveground tiles")
-            {
-                tileMapAboveGroundTiles.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::tiles, tibia::ZAxis::aboveGround);
-            }
-            else if (docMapLayerName == "aboveground tile edges")
-            {
-                tileMapAboveGroundEdges.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::edges, tibia::ZAxis::aboveGround);
-            }
-            else if (docMapLayerName == "aboveground tile objects")
+        std::vector<Layer> layersList;
+
+        for (tinyxml2::XMLElement* docMapLayer = docMap->FirstChildElement("layer"); docMapLayer != NULL; docMapLayer = docMapLayer->NextSiblingElement("layer"))
+        {
+            layersList.push_back(getLayer(docMapLayer));
+        }
+
+        m_floorZMin = tibia::ZAxis::ground;
+        m_floorZMax = tibia::ZAxis::ground;
+
+        for (auto& layer : layersList)
+        {
+            if (layer.type == -1)
             {
-                tileMapAboveGroundObjects.load(docMapLayerDataTiles, docMapLayerName, tibia::TileMapTypes::objects, tibia::ZAxis::aboveGround);
+                continue;
             }
-        }
 
-        tileMapList.push_back(&tileMapUnderGroundTiles);
-        tileMapList.push_back(&tileMapUnderGroundEdges);
-        tileMapList.push_back(&tileMapUnderGroundObjects);
+            if (layer.z < m_floorZMin) m_floorZMin = layer.z;
+            if (layer.z > m_floorZMax) m_floorZMax = layer.z;
+        }
 
-        tileMapList.push_back(&tileMapGroundTiles);
-        tileMapList.push_back(&tileMapGroundEdges);
-        tileMapList.push_back(&tileMapGroundObjects);
+        m_floorsList.clear();
+        m_floorsList.resize(m_floorZMax - m_floorZMin + 1);
 
-        tileMapList.push_back(&tileMapAboveGroundTiles);
-        tileMapList.push_back(&tileMapAboveGroundEdges);
-        tileMapList.push_back(&tileMapAboveGroundObjects);
+        tileMapList.clear();
 
-        for (tinyxml2::XMLElement* docMapObjectGroup = docMap->FirstChildElement("objectgroup"); docMapObjectGroup != NULL; docMapObjectGroup = docMapObjectGroup->NextSiblingElement("objectgroup"))
+        for (unsigned int i = 0; i < m_floorsList.size(); i++)
         {
-            std::string docMapObjectGroupName = docMapObjectGroup->Attribute("name");
+            Floor* floor = &m_floorsList.at(i);
 
-            //std::cout << docMapObjectGroupName << std::endl;
+            floor->z = m_floorZMin + i;
 
-            std::size_t findObjectsClass = docMapObjectGroupName.find("objects");
-
-            if (findObjectsClass == std::string::npos)
+            for (int j = 0; j < tibia::TileMapTypes::numTypes; j++)
             {
-                continue;
+                floor->tileMaps[j].setType(j);
+                floor->tileMaps[j].setZ(floor->z);
+
+                tileMapList.push_back(&floor->tileMaps[j]);
             }
+        }
 
-            int docMapObjectZ = tibia::ZAxis::ground;
+        tinyxml2::XMLElement* docMapLayer = docMap->FirstChildElement("layer");
 
-            if (docMapObjectGroupName == "ground objects")
-            {
-                docMapObjectZ = tibia::ZAxis::ground;
-            }
-            else if (docMapObjectGroupName == "underground objects")
+        for (unsigned int i = 0; i < layersList.size(); i++)
+        {
+            Layer* layer = &layersList.at(i);
+
+            if (layer->type != -1)
             {
-                docMapObjectZ = tibia::ZAxis::underGround;
+                getTileMap(layer->z, layer->type)->load(&m_chunkFile, i, docMapLayer->Attribute("name"), layer->type, layer->z);
             }
-            else if (docMapObjectGroupName == "aboveground objects")
+
+            docMapLayer = docMapLayer->NextSiblingElement("layer");
+        }
+
+        for (tinyxml2::XMLElement* docMapObjectGroup = docMap->FirstChildElement("objectgroup"); docMapObjectGroup != NULL; docMapObjectGroup = docMapObjectGroup->NextSiblingElement("objectgroup"))
+        {
+            Layer objectGroup = getLayer(docMapObjectGroup);
+
+            if (objectGroup.type != tibia::TileMapTypes::objects)
             {
-                docMapObjectZ = tibia::ZAxis::aboveGround;
+                continue;
             }
 
+            int docMapObjectZ = objectGroup.z;
+
             for (tinyxml2::XMLElement* docMapObject = docMapObjectGroup->FirstChildElement("object"); docMapObject != NULL; docMapObject = docMapObject->NextSiblingElement("object"))
             {
                 int docMapObjectId = docMapObject->IntAttribute("gid");
@@ -181,10 +182,217 @@ public:
         return &m_objectsList;
     }
 
+    int getFloorZMin()
+    {
+        return m_floorZMin;
+    }
+
+    int getFloorZMax()
+    {
+        return m_floorZMax;
+    }
+
+    int getNumFloors()
+    {
+        return m_floorsList.size();
+    }
+
+    Floor* getFloor(int z)
+    {
+        if (z < m_floorZMin || z > m_floorZMax)
+        {
+            return nullptr;
+        }
+
+        return &m_floorsList[z - m_floorZMin];
+    }
+
+    tibia::TileMap* getTileMap(int z, int type)
+    {
+        Floor* floor = getFloor(z);
+
+        if (floor == nullptr)
+        {
+            return nullptr;
+        }
+
+        return &floor->tileMaps[type];
+    }
+
+    tibia::TileChunkFile* getChunkFile()
+    {
+        return &m_chunkFile;
+    }
+
+    // keeps the chunks around each position resident and evicts the rest
+    void updateChunks(const std::vector<sf::Vector3i>& positionsList)
+    {
+        for (auto tileMap : tileMapList)
+        {
+            tileMap->beginChunkResidency();
+
+            for (auto& position : positionsList)
+            {
+                tileMap->touchChunks(position.x, position.y, position.z);
+            }
+
+            tileMap->evictChunks();
+        }
+    }
+
+    int getNumChunksLoaded()
+    {
+        int numChunksLoaded = 0;
+
+        for (auto tileMap : tileMapList)
+        {
+            numChunksLoaded += tileMap->getNumChunksLoaded();
+        }
+
+        return numChunksLoaded;
+    }
+
 private:
 
+    // layer and object group names without properties, e.g. "underground tile edges" or "aboveground objects"
+    static Layer getLayer(tinyxml2::XMLElement* docMapLayer)
+    {
+        static const std::unordered_map<std::string, int> floorNamesList =
+        {
+            {"underground", tibia::ZAxis::underGround},
+            {"ground",      tibia::ZAxis::ground},
+            {"aboveground", tibia::ZAxis::aboveGround},
+        };
+
+        static const std::unordered_map<std::string, int> typeNamesList =
+        {
+            {"tiles",        tibia::TileMapTypes::tiles},
+            {"tile edges",   tibia::TileMapTypes::edges},
+            {"edges",        tibia::TileMapTypes::edges},
+            {"tile walls",   tibia::TileMapTypes::walls},
+            {"walls",        tibia::TileMapTypes::walls},
+            {"tile objects", tibia::TileMapTypes::objects},
+            {"objects",      tibia::TileMapTypes::objects},
+        };
+
+        Layer layer;
+        layer.z    = tibia::ZAxis::ground;
+        layer.type = -1;
+
+        std::string docMapLayerName = docMapLayer->Attribute("name");
+
+        std::string floorName = docMapLayerName;
+        std::string typeName;
+
+        std::size_t findSpace = docMapLayerName.find(' ');
+
+        if (findSpace != std::string::npos)
+        {
+            floorName = docMapLayerName.substr(0, findSpace);
+            typeName  = docMapLayerName.substr(findSpace + 1);
+        }
+
+        auto floorNamesList_it = floorNamesList.find(floorName);
+
+        if (floorNamesList_it != floorNamesList.end())
+        {
+            layer.z = floorNamesList_it->second;
+        }
+
+        auto typeNamesList_it = typeNamesList.find(typeName);
+
+        if (typeNamesList_it != typeNamesList.end())
+        {
+            layer.type = typeNamesList_it->second;
+        }
+
+        tinyxml2::XMLElement* docMapLayerProperties = docMapLayer->FirstChildElement("properties");
+
+        if (docMapLayerProperties == NULL)
+        {
+            return layer;
+        }
+
+        for (tinyxml2::XMLElement* docMapLayerProperty = docMapLayerProperties->FirstChildElement("property"); docMapLayerProperty != NULL; docMapLayerProperty = docMapLayerProperty->NextSiblingElement("property"))
+        {
+            std::string propertyName = docMapLayerProperty->Attribute("name");
+
+            if (propertyName == "z")
+            {
+                layer.z = docMapLayerProperty->IntAttribute("value");
+            }
+            else if (propertyName == "type")
+            {
+                typeNamesList_it = typeNamesList.find(docMapLayerProperty->Attribute("value"));
+
+                if (typeNamesList_it != typeNamesList.end())
+                {
+                    layer.type = typeNamesList_it->second;
+                }
+            }
+        }
+
+        return layer;
+    }
+
+    // decodes one layer at a time so only a single layer is ever held in memory
+    bool createChunkFile(tinyxml2::XMLElement* docMap, std::string chunkFilename, std::uint64_t fileHash)
+    {
+        int numLayers = 0;
+
+        for (tinyxml2::XMLElement* docMapLayer = docMap->FirstChildElement("layer"); docMapLayer != NULL; docMapLayer = docMapLayer->NextSiblingElement("layer"))
+        {
+            numLayers++;
+        }
+
+        tibia::TileChunkFile chunkFile;
+
+        if (chunkFile.beginWrite(chunkFilename, fileHash, tibia::MapSize::width, tibia::MapSize::height, numLayers) == false)
+        {
+            return false;
+        }
+
+        int layerIndex = 0;
+
+        for (tinyxml2::XMLElement* docMapLayer = docMap->FirstChildElement("layer"); docMapLayer != NULL; docMapLayer = docMapLayer->NextSiblingElement("layer"))
+        {
+            std::string docMapLayerData = docMapLayer->FirstChildElement("data")->GetText();
+
+            docMapLayerData.erase(boost::remove_if(docMapLayerData, boost::is_any_of(" \r\n")), docMapLayerData.end());
+
+            docMapLayerData = base64_decode(docMapLayerData);
+            docMapLayerData = boost_zlib_decompress_string_fast(docMapLayerData);
+
+            std::istringstream docMapLayerDataStream(docMapLayerData);
+
+            std::vector<int> docMapLayerDataTiles;
+            docMapLayerDataTiles.reserve(docMapLayerData.size() / 4);
+
+            for (unsigned int i = 0; i < docMapLayerData.size(); i += 4)
+            {
+                int tileId;
+                docMapLayerDataStream.read(reinterpret_cast<char*>(&tileId), 4);
+
+                docMapLayerDataTiles.push_back(tileId);
+            }
+
+            chunkFile.writeLayer(layerIndex, docMapLayerDataTiles);
+
+            layerIndex++;
+        }
+
+        return chunkFile.endWrite();
+    }
+
     ObjectList m_objectsList;
 
+    tibia::TileChunkFile m_chunkFile;
+
+    std::vector<Floor> m_floorsList;
+
+    int m_floorZMin;
+    int m_floorZMax;
+
 };
 
 }
@@ -0,0 +1,243 @@
+#ifndef TIBIA_MEMORYTRACKER_HPP
+#define TIBIA_MEMORYTRACKER_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <ostream>
+
+#include <SFML/Graphics.hpp>
+
+#include "tibia/Tibia.hpp"
+
+namespace tibia
+{
+
+namespace MemoryTags
+{
+    enum
+    {
+        untagged,
+        map,
+        tiles,
+        creatures,
+        effects,
+        render,
+        audio,
+
+        numTags
+    };
+
+    const char* names[numTags] =
+    {
+        "untagged",
+        "map",
+        "tiles",
+        "creatures",
+        "effects",
+        "render",
+        "audio"
+    };
+}
+
+// heap allocations made by the whole program, counted by the replacement operator new in main.cpp.
+// the count is always kept, sizes are only tracked when built with TIBIA_MEMORY_TRACKING, then every
+// allocation is charged to the tag of the innermost ScopedTag on its thread and credited back on delete
+namespace MemoryTracker
+{
+    struct Tag
+    {
+        std::atomic<std::int64_t> numBytesLive;
+        std::atomic<std::int64_t> numBytesPeak;
+
+        std::atomic<std::uint64_t> numAllocations;
+    };
+
+    inline bool isEnabled()
+    {
+#ifdef TIBIA_MEMORY_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // trivially constructed so they are usable by allocations made before main
+    inline std::atomic<std::uint64_t>& getCounter()
+    {
+        static std::atomic<std::uint64_t> numAllocations;
+
+        return numAllocations;
+    }
+
+    inline tibia::MemoryTracker::Tag& getTag(int tag)
+    {
+        static tibia::MemoryTracker::Tag tags[tibia::MemoryTags::numTags];
+
+        return tags[tag];
+    }
+
+    inline tibia::MemoryTracker::Tag& getTotal()
+    {
+        static tibia::MemoryTracker::Tag total;
+
+        return total;
+    }
+
+    inline int& getCurrentTag()
+    {
+        thread_local int currentTag = tibia::MemoryTags::untagged;
+
+        return currentTag;
+    }
+
+    inline void add()
+    {
+        getCounter().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the peak is a high water mark, racing threads can only make it a little low
+    inline void addBytes(tibia::MemoryTracker::Tag& tag, std::int64_t numBytes)
+    {
+        std::int64_t numBytesLive = tag.numBytesLive.fetch_add(numBytes, std::memory_order_relaxed) + numBytes;
+
+        if (numBytesLive > tag.numBytesPeak.load(std::memory_order_relaxed))
+        {
+            tag.numBytesPeak.store(numBytesLive, std::memory_order_relaxed);
+        }
+    }
+
+    inline void addAllocation(std::size_t size, int tag)
+    {
+        addBytes(getTag(tag), size);
+        addBytes(getTotal(), size);
+
+        getTag(tag).numAllocations.fetch_add(1, std::memory_order_relaxed);
+        getTotal().numAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void removeAllocation(std::size_t size, int tag)
+    {
+        getTag(tag).numBytesLive.fetch_sub(size, std::memory_order_relaxed);
+        getTotal().numBytesLive.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t getNumAllocations()
+    {
+        return getCounter().load(std::memory_order_relaxed);
+    }
+
+    // allocations made inside the scope are charged to the tag, scopes nest
+    class ScopedTag
+    {
+
+    public:
+
+        ScopedTag(int tag)
+        {
+#ifdef TIBIA_MEMORY_TRACKING
+            m_previousTag = getCurrentTag();
+
+            getCurrentTag() = tag;
+#else
+            (void)tag;
+#endif
+        }
+
+        ~ScopedTag()
+        {
+#ifdef TIBIA_MEMORY_TRACKING
+            getCurrentTag() = m_previousTag;
+#endif
+        }
+
+    private:
+
+        int m_previousTag;
+
+    };
+
+    inline void formatTag(char* buffer, std::size_t bufferSize, const char* name, tibia::MemoryTracker::Tag& tag)
+    {
+        std::snprintf
+        (
+            buffer,
+            bufferSize,
+            "%-10s live: %9.1f KB  peak: %9.1f KB  allocs: %llu",
+            name,
+            tag.numBytesLive.load(std::memory_order_relaxed) / 1024.0,
+            tag.numBytesPeak.load(std::memory_order_relaxed) / 1024.0,
+            static_cast<unsigned long long>(tag.numAllocations.load(std::memory_order_relaxed))
+        );
+    }
+
+    inline void writeReport(std::ostream& stream)
+    {
+        if (isEnabled() == false)
+        {
+            return;
+        }
+
+        char buffer[128];
+
+        for (int i = 0; i < tibia::MemoryTags::numTags; i++)
+        {
+            formatTag(buffer, sizeof(buffer), tibia::MemoryTags::names[i], getTag(i));
+
+            stream << "memory " << buffer << std::endl;
+        }
+
+        formatTag(buffer, sizeof(buffer), "total", getTotal());
+
+        stream << "memory " << buffer << std::endl;
+    }
+
+    // formatted into a fixed buffer so drawing the overlay does not add to what it reports
+    inline void drawOverlay(sf::RenderTarget* target, sf::Font* font, sf::Vector2f position, std::uint64_t numAllocationsPerFrame)
+    {
+        if (isEnabled() == false)
+        {
+            return;
+        }
+
+        const int lineHeight = 12;
+
+        sf::RectangleShape background(sf::Vector2f(400, (tibia::MemoryTags::numTags + 2) * lineHeight + 8));
+        background.setFillColor(sf::Color(0, 0, 0, 192));
+        background.setPosition(position);
+
+        target->draw(background);
+
+        sf::Text text;
+        text.setFont(*font);
+        text.setCharacterSize(lineHeight - 2);
+        text.setColor(tibia::Colors::white);
+
+        char buffer[128];
+
+        for (int i = 0; i < tibia::MemoryTags::numTags + 2; i++)
+        {
+            if (i < tibia::MemoryTags::numTags)
+            {
+                formatTag(buffer, sizeof(buffer), tibia::MemoryTags::names[i], getTag(i));
+            }
+            else if (i == tibia::MemoryTags::numTags)
+            {
+                formatTag(buffer, sizeof(buffer), "total", getTotal());
+            }
+            else
+            {
+                std::snprintf(buffer, sizeof(buffer), "allocs per frame: %llu", static_cast<unsigned long long>(numAllocationsPerFrame));
+            }
+
+            text.setString(buffer);
+            text.setPosition(position.x + 4, position.y + 4 + (i * lineHeight));
+
+            target->draw(text);
+        }
+    }
+}
+
+}
+
+#endif // TIBIA_MEMORYTRACKER_HPP
@@ -0,0 +1,227 @@
+#ifndef TIBIA_OBJECTINDEX_HPP
+#define TIBIA_OBJECTINDEX_HPP
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+#include "tibia/Tibia.hpp"
+#include "tibia/Object.hpp"
+
+namespace tibia
+{
+
+// objects that never move stored per floor in compressed sparse rows, the objects of a floor are sorted
+// by tile number so the objects on a tile, and on a horizontal run of tiles, are next to each other
+class ObjectIndex
+{
+
+public:
+
+    struct Range
+    {
+        tibia::Object* const* first;
+        tibia::Object* const* last;
+
+        tibia::Object* const* begin() const
+        {
+            return first;
+        }
+
+        tibia::Object* const* end() const
+        {
+            return last;
+        }
+
+        int size() const
+        {
+            return last - first;
+        }
+    };
+
+    struct Floor
+    {
+        // objectOffsets[tileNumber] to objectOffsets[tileNumber + 1] are the objects on the tile
+        std::vector<int> objectOffsets;
+
+        std::vector<tibia::Object*> objectsList;
+    };
+
+    ObjectIndex()
+    {
+        m_width  = 0;
+        m_height = 0;
+
+        m_zMin = 0;
+    }
+
+    void build(const std::vector<std::shared_ptr<tibia::Object>>& objectsList, int width, int height, int zMin, int zMax)
+    {
+        m_width  = width;
+        m_height = height;
+
+        m_zMin = zMin;
+
+        m_floorsList.clear();
+        m_floorsList.resize(std::max(zMax - zMin + 1, 0));
+
+        int numTiles = m_width * m_height;
+
+        for (auto& floor : m_floorsList)
+        {
+            floor.objectOffsets.assign(numTiles + 1, 0);
+        }
+
+        // count, prefix sum, then place each object at the next free slot of its tile
+        for (auto& object : objectsList)
+        {
+            int tileNumber = getTileNumber(object->getX(), object->getY());
+
+            Floor* floor = getFloor(object->getZ());
+
+            if (floor == nullptr || tileNumber < 0)
+            {
+                continue;
+            }
+
+            floor->objectOffsets[tileNumber + 1]++;
+        }
+
+        for (auto& floor : m_floorsList)
+        {
+            for (int i = 0; i < numTiles; i++)
+            {
+                floor.objectOffsets[i + 1] += floor.objectOffsets[i];
+            }
+
+            floor.objectsList.assign(floor.objectOffsets[numTiles], nullptr);
+        }
+
+        std::vector<std::vector<int>> nextList(m_floorsList.size());
+
+        for (unsigned int i = 0; i < m_floorsList.size(); i++)
+        {
+            nextList[i].assign(m_floorsList[i].objectOffsets.begin(), m_floorsList[i].objectOffsets.end() - 1);
+        }
+
+        for (auto& object : objectsList)
+        {
+            int tileNumber = getTileNumber(object->getX(), object->getY());
+
+            Floor* floor = getFloor(object->getZ());
+
+            if (floor == nullptr || tileNumber < 0)
+            {
+                continue;
+            }
+
+            int& next = nextList[object->getZ() - m_zMin][tileNumber];
+
+            floor->objectsList[next] = object.get();
+
+            next++;
+        }
+    }
+
+    // the objects on one tile in the order they were loaded
+    Range getObjects(int x, int y, int z)
+    {
+        Range range;
+        range.first = nullptr;
+        range.last  = nullptr;
+
+        Floor* floor = getFloor(z);
+
+        int tileNumber = getTileNumber(x, y);
+
+        if (floor == nullptr || tileNumber < 0 || floor->objectsList.size() == 0)
+        {
+            return range;
+        }
+
+        range.first = floor->objectsList.data() + floor->objectOffsets[tileNumber];
+        range.last  = floor->objectsList.data() + floor->objectOffsets[tileNumber + 1];
+
+        return range;
+    }
+
+    // appends the objects inside the rectangle of tiles, one contiguous run per row
+    void query(sf::IntRect tileRect, int z, std::vector<tibia::Object*>& resultList)
+    {
+        Floor* floor = getFloor(z);
+
+        if (floor == nullptr || floor->objectsList.size() == 0)
+        {
+            return;
+        }
+
+        int x1 = std::max(tileRect.left, 0);
+        int y1 = std::max(tileRect.top,  0);
+
+        int x2 = std::min(tileRect.left + tileRect.width,  m_width);
+        int y2 = std::min(tileRect.top  + tileRect.height, m_height);
+
+        if (x2 <= x1 || y2 <= y1)
+        {
+            return;
+        }
+
+        for (int y = y1; y < y2; y++)
+        {
+            int first = floor->objectOffsets[(y * m_width) + x1];
+            int last  = floor->objectOffsets[(y * m_width) + x2];
+
+            resultList.insert(resultList.end(), floor->objectsList.begin() + first, floor->objectsList.begin() + last);
+        }
+    }
+
+    int getNumObjects(int z)
+    {
+        Floor* floor = getFloor(z);
+
+        if (floor == nullptr)
+        {
+            return 0;
+        }
+
+        return floor->objectsList.size();
+    }
+
+private:
+
+    Floor* getFloor(int z)
+    {
+        int index = z - m_zMin;
+
+        if (index < 0 || index >= static_cast<int>(m_floorsList.size()))
+        {
+            return nullptr;
+        }
+
+        return &m_floorsList[index];
+    }
+
+    int getTileNumber(int x, int y)
+    {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+        {
+            return -1;
+        }
+
+        return x + (y * m_width);
+    }
+
+    int m_width;
+    int m_height;
+
+    int m_zMin;
+
+    std::vector<Floor> m_floorsList;
+
+};
+
+}
+
+#endif // TIBIA_OBJECTINDEX_HPP
@@ -0,0 +1,427 @@
+#ifndef TIBIA_PROFILER_HPP
+#define TIBIA_PROFILER_HPP
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+
+#include <SFML/System.hpp>
+#include <SFML/Graphics.hpp>
+
+#include "tibia/Tibia.hpp"
+
+namespace tibia
+{
+
+namespace ProfilerZones
+{
+    enum
+    {
+        frame,
+        updateTimers,
+        doCreatureLogic,
+        doAnimatedWaterAndObjects,
+        updateAnimatedDecals,
+        updatePlayer,
+        updateCreatures,
+        updateObjects,
+        updateProjectiles,
+        updateAnimations,
+        updateSounds,
+        drawGameWindow,
+        drawTileMapTiles,
+        drawTileMapEdges,
+        drawTileMapWalls,
+        drawTileMapObjects,
+        drawChunks,
+        drawThings,
+        drawLights,
+        drawLabels,
+        updateMiniMapWindow,
+        drawMiniMapWindow,
+
+        numZones
+    };
+
+    const char* names[numZones] =
+    {
+        "frame",
+        "updateTimers",
+        "doCreatureLogic",
+        "doAnimatedWaterAndObjects",
+        "updateAnimatedDecals",
+        "updatePlayer",
+        "updateCreatures",
+        "updateObjects",
+        "updateProjectiles",
+        "updateAnimations",
+        "updateSounds",
+        "drawGameWindow",
+        "drawTileMap tiles",
+        "drawTileMap edges",
+        "drawTileMap walls",
+        "drawTileMap objects",
+        "drawChunks",
+        "drawThings",
+        "drawLights",
+        "drawLabels",
+        "updateMiniMapWindow",
+        "drawMiniMapWindow"
+    };
+}
+
+class Profiler
+{
+
+public:
+
+    static const int NUM_SAMPLES = 120;
+
+    static const int NUM_HISTOGRAM_BUCKETS = 8;
+
+    static const unsigned int TRACE_EVENTS_MAX = 1000000;
+
+    class ScopedTimer
+    {
+
+    public:
+
+        ScopedTimer(tibia::Profiler* profiler, int zone)
+        {
+            m_profiler = profiler;
+
+            m_zone = zone;
+
+            m_timeBegin = m_profiler->getTime();
+        }
+
+        ~ScopedTimer()
+        {
+            m_profiler->addSample(m_zone, m_timeBegin, m_profiler->getTime() - m_timeBegin);
+        }
+
+    private:
+
+        tibia::Profiler* m_profiler;
+
+        int m_zone;
+
+        sf::Int64 m_timeBegin;
+
+    };
+
+    struct Zone
+    {
+        sf::Int64 samples[NUM_SAMPLES];
+
+        int sampleIndex;
+        int numSamples;
+
+        int histogram[NUM_HISTOGRAM_BUCKETS];
+    };
+
+    struct TraceEvent
+    {
+        int zone;
+
+        sf::Int64 timeBegin;
+        sf::Int64 duration;
+    };
+
+    Profiler()
+    {
+        m_zonesList.resize(tibia::ProfilerZones::numZones);
+
+        reset();
+
+        m_isOverlayVisible = false;
+
+        m_isTracing = false;
+    }
+
+    void reset()
+    {
+        for (auto& zone : m_zonesList)
+        {
+            for (int i = 0; i < NUM_SAMPLES; i++)
+            {
+                zone.samples[i] = 0;
+            }
+
+            for (int i = 0; i < NUM_HISTOGRAM_BUCKETS; i++)
+            {
+                zone.histogram[i] = 0;
+            }
+
+            zone.sampleIndex = 0;
+            zone.numSamples  = 0;
+        }
+    }
+
+    sf::Int64 getTime()
+    {
+        return m_clock.getElapsedTime().asMicroseconds();
+    }
+
+    // buckets: <0.25ms, <0.5ms, <1ms, <2ms, <4ms, <8ms, <16ms, >=16ms
+    static int getHistogramBucket(sf::Int64 duration)
+    {
+        sf::Int64 bucketMax = 250;
+
+        for (int i = 0; i < NUM_HISTOGRAM_BUCKETS - 1; i++)
+        {
+            if (duration < bucketMax)
+            {
+                return i;
+            }
+
+            bucketMax *= 2;
+        }
+
+        return NUM_HISTOGRAM_BUCKETS - 1;
+    }
+
+    void addSample(int zoneIndex, sf::Int64 timeBegin, sf::Int64 duration)
+    {
+        Zone* zone = &m_zonesList.at(zoneIndex);
+
+        if (zone->numSamples == NUM_SAMPLES)
+        {
+            zone->histogram[getHistogramBucket(zone->samples[zone->sampleIndex])]--;
+        }
+        else
+        {
+            zone->numSamples++;
+        }
+
+        zone->samples[zone->sampleIndex] = duration;
+
+        zone->histogram[getHistogramBucket(duration)]++;
+
+        zone->sampleIndex = (zone->sampleIndex + 1) % NUM_SAMPLES;
+
+        if (m_isTracing == true && m_traceEventsList.size() < TRACE_EVENTS_MAX)
+        {
+            TraceEvent traceEvent;
+            traceEvent.zone      = zoneIndex;
+            traceEvent.timeBegin = timeBegin;
+            traceEvent.duration  = duration;
+
+            m_traceEventsList.push_back(traceEvent);
+        }
+    }
+
+    float getAverageMilliseconds(int zoneIndex)
+    {
+        Zone* zone = &m_zonesList.at(zoneIndex);
+
+        if (zone->numSamples == 0)
+        {
+            return 0;
+        }
+
+        sf::Int64 total = 0;
+
+        for (int i = 0; i < zone->numSamples; i++)
+        {
+            total += zone->samples[i];
+        }
+
+        return (total / static_cast<float>(zone->numSamples)) / 1000.0f;
+    }
+
+    float getMaxMilliseconds(int zoneIndex)
+    {
+        Zone* zone = &m_zonesList.at(zoneIndex);
+
+        sf::Int64 maximum = 0;
+
+        for (int i = 0; i < zone->numSamples; i++)
+        {
+            if (zone->samples[i] > maximum)
+            {
+                maximum = zone->samples[i];
+            }
+        }
+
+        return maximum / 1000.0f;
+    }
+
+    Zone* getZone(int zoneIndex)
+    {
+        return &m_zonesList.at(zoneIndex);
+    }
+
+    void startTrace()
+    {
+        m_traceEventsList.clear();
+
+        m_isTracing = true;
+    }
+
+    void stopTrace()
+    {
+        m_isTracing = false;
+    }
+
+    bool isTracing()
+    {
+        return m_isTracing;
+    }
+
+    bool exportChromeTrace(std::string filename)
+    {
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        file << "{\"traceEvents\":[\n";
+
+        for (unsigned int i = 0; i < m_traceEventsList.size(); i++)
+        {
+            TraceEvent* traceEvent = &m_traceEventsList.at(i);
+
+            file
+                << "{\"name\":\"" << tibia::ProfilerZones::names[traceEvent->zone] << "\","
+                << "\"cat\":\"tibia\","
+                << "\"ph\":\"X\","
+                << "\"ts\":"  << traceEvent->timeBegin << ","
+                << "\"dur\":" << traceEvent->duration  << ","
+                << "\"pid\":1,\"tid\":1}";
+
+            if (i != m_traceEventsList.size() - 1)
+            {
+                file << ",";
+            }
+
+            file << "\n";
+        }
+
+        file << "],\"displayTimeUnit\":\"ms\"}\n";
+
+        return true;
+    }
+
+    bool isOverlayVisible()
+    {
+        return m_isOverlayVisible;
+    }
+
+    void setIsOverlayVisible(bool b)
+    {
+        m_isOverlayVisible = b;
+    }
+
+    void toggleOverlay()
+    {
+        m_isOverlayVisible = !m_isOverlayVisible;
+    }
+
+    void drawOverlay(sf::RenderTarget* target, sf::Font* font, sf::Vector2f position)
+    {
+        if (m_isOverlayVisible == false)
+        {
+            return;
+        }
+
+        const int lineHeight = 12;
+
+        const int histogramX     = 200;
+        const int histogramWidth = 4;
+
+        sf::RectangleShape background
+        (
+            sf::Vector2f
+            (
+                histogramX + (NUM_HISTOGRAM_BUCKETS * histogramWidth * 2) + 8,
+                (tibia::ProfilerZones::numZones + 1) * lineHeight + 8
+            )
+        );
+        background.setFillColor(sf::Color(0, 0, 0, 192));
+        background.setPosition(position);
+
+        target->draw(background);
+
+        sf::Text text;
+        text.setFont(*font);
+        text.setCharacterSize(lineHeight - 2);
+        text.setColor(tibia::Colors::white);
+
+        std::vector<sf::Vertex> histogramVertices;
+
+        for (int i = 0; i < tibia::ProfilerZones::numZones; i++)
+        {
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(2)
+               << tibia::ProfilerZones::names[i]
+               << ": "
+               << getAverageMilliseconds(i)
+               << " / "
+               << getMaxMilliseconds(i)
+               << " ms";
+
+            text.setString(ss.str());
+            text.setPosition(position.x + 4, position.y + 4 + (i * lineHeight));
+
+            target->draw(text);
+
+            Zone* zone = &m_zonesList.at(i);
+
+            if (zone->numSamples == 0)
+            {
+                continue;
+            }
+
+            for (int j = 0; j < NUM_HISTOGRAM_BUCKETS; j++)
+            {
+                float barHeight = (zone->histogram[j] * (lineHeight - 2)) / static_cast<float>(zone->numSamples);
+
+                float barX = position.x + histogramX + (j * histogramWidth * 2);
+                float barY = position.y + 4 + ((i + 1) * lineHeight) - 1;
+
+                sf::Color barColor = (j < 5) ? tibia::Colors::green : tibia::Colors::red;
+
+                histogramVertices.push_back(sf::Vertex(sf::Vector2f(barX,                  barY - barHeight), barColor));
+                histogramVertices.push_back(sf::Vertex(sf::Vector2f(barX + histogramWidth, barY - barHeight), barColor));
+                histogramVertices.push_back(sf::Vertex(sf::Vector2f(barX + histogramWidth, barY),             barColor));
+                histogramVertices.push_back(sf::Vertex(sf::Vector2f(barX,                  barY),             barColor));
+            }
+        }
+
+        if (m_isTracing == true)
+        {
+            text.setString("Tracing...");
+            text.setColor(tibia::Colors::red);
+            text.setPosition(position.x + 4, position.y + 4 + (tibia::ProfilerZones::numZones * lineHeight));
+
+            target->draw(text);
+        }
+
+        if (histogramVertices.size() != 0)
+        {
+            target->draw(&histogramVertices[0], histogramVertices.size(), sf::Quads);
+        }
+    }
+
+private:
+
+    sf::Clock m_clock;
+
+    std::vector<Zone> m_zonesList;
+
+    std::vector<TraceEvent> m_traceEventsList;
+
+    bool m_isOverlayVisible;
+
+    bool m_isTracing;
+
+};
+
+}
+
+#endif // TIBIA_PROFILER_HPP
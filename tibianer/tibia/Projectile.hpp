@@ -1,6 +1,8 @@
 #ifndef TIBIA_PROJECTILE_HPP
 #define TIBIA_PROJECTILE_HPP
 
+#include <vector>
+
 #include <SFML/Graphics.hpp>
 
 #include "tibia/Tibia.hpp"
@@ -16,6 +18,13 @@ class Projectile : public tibia::Thing
 
 public:
 
+    struct TileCrossing
+    {
+        sf::Vector2i tilePosition;
+
+        float time;
+    };
+
     Projectile::Projectile(int type, int direction, sf::Vector2f origin, sf::Vector2f destination, bool isPrecise = false, bool isChild = false)
     {
         m_type = type;
@@ -32,12 +41,13 @@ public:
 
         m_speed = tibia::ProjectileSpeeds::default;
 
+        m_spawnTime = 0;
+
         m_distanceTravelled = 0;
 
         m_tileDistanceTravelled = 0;
 
-        m_spriteTileX = origin.x;
-        m_spriteTileY = origin.y;
+        m_numTileCrossingsResolved = 0;
 
         m_vectorOrigin      = origin;
         m_vectorDestination = destination;
@@ -54,6 +64,8 @@ public:
         m_sprite.setId(m_id);
 
         setPosition(origin.x, origin.y);
+
+        calculateTileCrossings();
     }
 
     Projectile::~Projectile()
@@ -123,38 +135,76 @@ public:
         }
     }
 
-    void doMovement()
+    static int snapToTile(int value)
     {
-        sf::Time timeElapsed = m_clock.getElapsedTime();
-
-        if (timeElapsed.asSeconds() >= 0.01)
+        if (value > 0)
         {
-            float moveX = m_vectorMovement.x; //tibia::getFloatNormal(m_vectorMovement.x);
-            float moveY = m_vectorMovement.y; //tibia::getFloatNormal(m_vectorMovement.y);
+            value -= value % tibia::TILE_SIZE;
+        }
 
-            m_sprite.move(moveX * m_speed, moveY * m_speed);
+        return value;
+    }
 
-            m_distanceTravelled += m_speed;
+    void calculateTileCrossings()
+    {
+        m_tileCrossings.clear();
+        m_tileCrossings.reserve(m_range);
 
-            if (m_distanceTravelled > 0 && m_distanceTravelled % tibia::TILE_SIZE == 0)
-            {
-                m_spriteTileX = m_spriteTileX + (moveX * tibia::TILE_SIZE);
-                m_spriteTileY = m_spriteTileY + (moveY * tibia::TILE_SIZE);
+        for (int i = 1; i < m_range + 1; i++)
+        {
+            float distance = static_cast<float>(i * tibia::TILE_SIZE);
+
+            int x = static_cast<int>(m_vectorOrigin.x + (m_vectorMovement.x * distance));
+            int y = static_cast<int>(m_vectorOrigin.y + (m_vectorMovement.y * distance));
 
-                m_tileDistanceTravelled += 1;
+            if (m_vectorMovement.x < 0 && m_vectorMovement.y > 0)
+            {
+                x += tibia::TILE_SIZE;
+            }
+            else if (m_vectorMovement.x > 0 && m_vectorMovement.y < 0)
+            {
+                y += tibia::TILE_SIZE;
             }
+            else if (m_vectorMovement.x < 0 && m_vectorMovement.y < 0)
+            {
+                x += tibia::TILE_SIZE;
+                y += tibia::TILE_SIZE;
+            }
+
+            TileCrossing tileCrossing;
+            tileCrossing.tilePosition = sf::Vector2i(snapToTile(x), snapToTile(y));
+            tileCrossing.time         = distance / m_speed;
 
-            m_clock.restart();
+            m_tileCrossings.push_back(tileCrossing);
         }
     }
 
-    void update()
+    void doMovement(float time)
     {
-        //updateTileCoords();
+        float distance = (time - m_spawnTime) * m_speed;
 
-        //setPosition(getTileX(), getTileY());
+        if (distance < 0)
+        {
+            distance = 0;
+        }
 
-        doMovement();
+        float distanceMax = static_cast<float>(m_range * tibia::TILE_SIZE);
+
+        if (distance > distanceMax)
+        {
+            distance = distanceMax;
+        }
+
+        m_sprite.setPosition(m_vectorMovement.x * distance, m_vectorMovement.y * distance);
+
+        m_distanceTravelled = static_cast<int>(distance);
+
+        m_tileDistanceTravelled = m_distanceTravelled / tibia::TILE_SIZE;
+    }
+
+    void update(float time)
+    {
+        doMovement(time);
 
         setTileCoords(getSpriteTilePosition().x, getSpriteTilePosition().y);
 
@@ -163,6 +213,45 @@ public:
         updateBox();
     }
 
+    TileCrossing* getNextTileCrossing(float time)
+    {
+        if (m_numTileCrossingsResolved >= m_tileCrossings.size())
+        {
+            return nullptr;
+        }
+
+        TileCrossing* tileCrossing = &m_tileCrossings.at(m_numTileCrossingsResolved);
+
+        if (m_spawnTime + tileCrossing->time > time)
+        {
+            return nullptr;
+        }
+
+        m_numTileCrossingsResolved++;
+
+        return tileCrossing;
+    }
+
+    bool isLastTileCrossing()
+    {
+        return m_numTileCrossingsResolved >= m_tileCrossings.size();
+    }
+
+    unsigned int getNumTileCrossingsResolved()
+    {
+        return m_numTileCrossingsResolved;
+    }
+
+    void setNumTileCrossingsResolved(unsigned int numTileCrossingsResolved)
+    {
+        m_numTileCrossingsResolved = numTileCrossingsResolved;
+    }
+
+    int getDirection()
+    {
+        return m_direction;
+    }
+
     void setId(int id)
     {
         m_id = id;
@@ -216,6 +305,8 @@ public:
     void setRange(int range)
     {
         m_range = range;
+
+        calculateTileCrossings();
     }
 
     int getRange()
@@ -233,9 +324,11 @@ public:
         return m_damage;
     }
 
-    float setSpeed(float speed)
+    void setSpeed(float speed)
     {
         m_speed = speed;
+
+        calculateTileCrossings();
     }
 
     float getSpeed()
@@ -243,11 +336,6 @@ public:
         return m_speed;
     }
 
-    int setDistanceTravelled(int distanceTravelled)
-    {
-        m_distanceTravelled = distanceTravelled;
-    }
-
     int getDistanceTravelled()
     {
         return m_distanceTravelled;
@@ -258,6 +346,21 @@ public:
         return m_tileDistanceTravelled;
     }
 
+    void setSpawnTime(float time)
+    {
+        m_spawnTime = time;
+    }
+
+    float getSpawnTime()
+    {
+        return m_spawnTime;
+    }
+
+    std::vector<TileCrossing>* getTileCrossings()
+    {
+        return &m_tileCrossings;
+    }
+
     sf::Vector2f getVectorOrigin()
     {
         return m_vectorOrigin;
@@ -285,41 +388,14 @@ public:
 
     sf::Vector2f getSpriteTilePosition()
     {
-        sf::Vector2f position;
-
-        //position.x = m_spriteTileX;
-        //position.y = m_spriteTileY;
-
-        float integralX;
-        float fractionalX = std::modf(m_spriteTileX, &integralX);
-
-        float integralY;
-        float fractionalY = std::modf(m_spriteTileY, &integralY);
-
-        int x = integralX;
-        int y = integralY;
-
-        if (m_vectorMovement.x < 0 && m_vectorMovement.y > 0)
+        if (m_numTileCrossingsResolved == 0)
         {
-            x += tibia::TILE_SIZE;
+            return m_vectorOrigin;
         }
-        else if (m_vectorMovement.x > 0 && m_vectorMovement.y < 0)
-        {
-            y += tibia::TILE_SIZE;
-        }
-        else if (m_vectorMovement.x < 0 && m_vectorMovement.y < 0)
-        {
-            x += tibia::TILE_SIZE;
-            y += tibia::TILE_SIZE;
-        }
-
-        while (x > 0 && x % tibia::TILE_SIZE != 0) x--;
-        while (y > 0 && y % tibia::TILE_SIZE != 0) y--;
 
-        position.x = x;
-        position.y = y;
+        sf::Vector2i tilePosition = m_tileCrossings.at(m_numTileCrossingsResolved - 1).tilePosition;
 
-        return position;
+        return sf::Vector2f(tilePosition.x, tilePosition.y);
     }
 
     tibia::Creature* getCreatureOwner()
@@ -359,9 +435,6 @@ private:
     int m_type;
     int m_spriteType;
 
-    float m_spriteTileX;
-    float m_spriteTileY;
-
     int* m_animationOnHit;
     int* m_animationOnBlock;
 
@@ -374,10 +447,16 @@ private:
 
     float m_speed;
 
+    float m_spawnTime;
+
     int m_distanceTravelled;
 
     int m_tileDistanceTravelled;
 
+    std::vector<TileCrossing> m_tileCrossings;
+
+    unsigned int m_numTileCrossingsResolved;
+
     bool m_isPrecise;
 
     bool m_isChild;
@@ -388,8 +467,6 @@ private:
 
     tibia::Sprite m_sprite;
 
-    sf::Clock m_clock;
-
     tibia::Creature* m_creatureOwner;
 
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const
@@ -0,0 +1,155 @@
+#ifndef TIBIA_RANDOM_HPP
+#define TIBIA_RANDOM_HPP
+
+#include <cstdint>
+
+namespace tibia
+{
+
+// xoshiro256** seeded through splitmix64
+class Random
+{
+
+public:
+
+    Random(std::uint64_t seed = 1)
+    {
+        setSeed(seed);
+    }
+
+    void setSeed(std::uint64_t seed)
+    {
+        m_seed = seed;
+
+        std::uint64_t x = seed;
+
+        for (int i = 0; i < 4; i++)
+        {
+            x += 0x9E3779B97F4A7C15ULL;
+
+            std::uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+            m_state[i] = z ^ (z >> 31);
+        }
+    }
+
+    std::uint64_t getSeed()
+    {
+        return m_seed;
+    }
+
+    void getState(std::uint64_t state[4])
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            state[i] = m_state[i];
+        }
+    }
+
+    // restores a state saved with getState, the seed is kept for reference only
+    void setState(std::uint64_t seed, const std::uint64_t state[4])
+    {
+        m_seed = seed;
+
+        for (int i = 0; i < 4; i++)
+        {
+            m_state[i] = state[i];
+        }
+    }
+
+    std::uint64_t next()
+    {
+        std::uint64_t result = rotateLeft(m_state[1] * 5, 7) * 9;
+
+        std::uint64_t t = m_state[1] << 17;
+
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+
+        m_state[2] ^= t;
+
+        m_state[3] = rotateLeft(m_state[3], 45);
+
+        return result;
+    }
+
+    int getNumber(int low, int high)
+    {
+        std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(high) - low) + 1;
+
+        return static_cast<int>(low + static_cast<std::int64_t>(((next() >> 32) * range) >> 32));
+    }
+
+    float getFloat()
+    {
+        return (next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    // advances the state by 2^128 calls to next()
+    void jump()
+    {
+        static const std::uint64_t jumpTable[] =
+        {
+            0x180EC6D33CFD0ABAULL,
+            0xD5A61266F0C9392CULL,
+            0xA9582618E03FC9AAULL,
+            0x39ABDC4529B1661CULL
+        };
+
+        std::uint64_t state[4] = {0, 0, 0, 0};
+
+        for (int i = 0; i < 4; i++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (jumpTable[i] & (1ULL << b))
+                {
+                    state[0] ^= m_state[0];
+                    state[1] ^= m_state[1];
+                    state[2] ^= m_state[2];
+                    state[3] ^= m_state[3];
+                }
+
+                next();
+            }
+        }
+
+        m_state[0] = state[0];
+        m_state[1] = state[1];
+        m_state[2] = state[2];
+        m_state[3] = state[3];
+    }
+
+    // non-overlapping stream for a worker thread, derived from the current state
+    Random getStream(int index)
+    {
+        Random random = *this;
+
+        for (int i = 0; i < index + 1; i++)
+        {
+            random.jump();
+        }
+
+        return random;
+    }
+
+private:
+
+    static std::uint64_t rotateLeft(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t m_seed;
+
+    std::uint64_t m_state[4];
+
+};
+
+}
+
+#endif // TIBIA_RANDOM_HPP
@@ -0,0 +1,511 @@
+#ifndef TIBIA_SERVER_HPP
+#define TIBIA_SERVER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <algorithm>
+
+#include "tibia/Tibia.hpp"
+#include "tibia/BinaryStream.hpp"
+#include "tibia/Random.hpp"
+#include "tibia/Command.hpp"
+#include "tibia/StateStream.hpp"
+#include "tibia/Transport.hpp"
+#include "tibia/InterestManager.hpp"
+#include "tibia/Creature.hpp"
+#include "tibia/Game.hpp"
+
+namespace tibia
+{
+
+namespace ServerMessageTypes
+{
+    enum
+    {
+        welcome, // spawn id of the client's creature and the current tick
+        state,   // tick followed by the creatures inside the client's area of interest
+    };
+}
+
+namespace ClientMessageTypes
+{
+    enum
+    {
+        commands, // every command the client wants to run this tick
+    };
+}
+
+// owns the simulation and the creatures of connected clients, which can only act through commands.
+// commands received during a tick are queued together and run as one batch on the next game tick,
+// then every client is sent the creatures around its own, kept by the game's interest manager
+class Server
+{
+
+public:
+
+    struct Client
+    {
+        std::shared_ptr<tibia::Transport> transport;
+
+        tibia::Game::CreaturePtr creature;
+
+        int observerId;
+    };
+
+    Server(tibia::Game* game)
+    {
+        m_game = game;
+
+        m_numCommands        = 0;
+        m_numCommandsDropped = 0;
+
+        m_numBytesSent = 0;
+    }
+
+    // spawns the client's creature and tells the client which one it is, returns its spawn id
+    int addClient(std::shared_ptr<tibia::Transport> transport, int tileX, int tileY, int z, std::string name)
+    {
+        tibia::Game::CreaturePtr creature = std::make_shared<tibia::Creature>(tileX * tibia::TILE_SIZE, tileY * tibia::TILE_SIZE, z);
+        creature->setName(name);
+        creature->setIsRemotePlayer(true);
+        creature->setHasOutfit(true);
+        creature->setOutfitRandom();
+        creature->setTeam(tibia::Teams::good);
+        creature->setHpMax(1000);
+        creature->setHp(1000);
+        creature->setMovementSpeed(tibia::MovementSpeeds::player);
+
+        m_game->spawnCreature(creature);
+
+        Client client;
+        client.transport = transport;
+        client.creature  = creature;
+
+        client.observerId = m_game->getInterestManager()->addObserver(getInterestRect(creature.get()));
+
+        m_clientsList.push_back(client);
+
+        beginMessage(tibia::ServerMessageTypes::welcome);
+
+        tibia::BinaryStream::writeVarUint(m_messageStream, creature->getSpawnId());
+        tibia::BinaryStream::writeVarUint(m_messageStream, m_game->getTick());
+
+        sendMessage(client);
+
+        return creature->getSpawnId();
+    }
+
+    void doTick()
+    {
+        for (auto& client : m_clientsList)
+        {
+            receiveCommands(client);
+        }
+
+        removeDisconnectedClients();
+
+        m_game->doTick();
+
+        for (auto& client : m_clientsList)
+        {
+            sendState(client);
+        }
+    }
+
+    int getNumClients()
+    {
+        return m_clientsList.size();
+    }
+
+    unsigned int getNumCommands()
+    {
+        return m_numCommands;
+    }
+
+    unsigned int getNumCommandsDropped()
+    {
+        return m_numCommandsDropped;
+    }
+
+    std::uint64_t getNumBytesSent()
+    {
+        return m_numBytesSent;
+    }
+
+private:
+
+    void receiveCommands(Client& client)
+    {
+        int numCommands = 0;
+
+        std::string message;
+
+        while (client.transport->receive(message) == true)
+        {
+            std::istringstream stream(message);
+
+            if (tibia::BinaryStream::readVarUint(stream) != tibia::ClientMessageTypes::commands)
+            {
+                continue;
+            }
+
+            unsigned int numMessageCommands = static_cast<unsigned int>(tibia::BinaryStream::readVarUint(stream));
+
+            for (unsigned int i = 0; i < numMessageCommands; i++)
+            {
+                tibia::Command command;
+                command.type           = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+                command.direction      = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+                command.projectileType = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+                command.x              = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+                command.y              = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+                command.creatureId     = client.creature->getSpawnId();
+
+                if (stream.fail() == true)
+                {
+                    break;
+                }
+
+                if (numCommands >= tibia::SERVER_COMMANDS_PER_TICK_MAX || isCommandAllowed(client, command) == false)
+                {
+                    m_numCommandsDropped++;
+                    continue;
+                }
+
+                m_game->queueCommand(command);
+
+                numCommands++;
+
+                m_numCommands++;
+            }
+        }
+    }
+
+    // clients can walk, turn, shoot and use the tiles next to them, nothing else
+    bool isCommandAllowed(Client& client, const tibia::Command& command)
+    {
+        if (command.direction < tibia::Directions::begin || command.direction > tibia::Directions::end)
+        {
+            return false;
+        }
+
+        switch (command.type)
+        {
+            case tibia::CommandTypes::move:
+            case tibia::CommandTypes::turn:
+                return true;
+
+            case tibia::CommandTypes::spawnProjectile:
+                return command.projectileType >= tibia::ProjectileTypes::spellBlue && command.projectileType <= tibia::ProjectileTypes::arrowPoison;
+
+            case tibia::CommandTypes::use:
+            {
+                int distanceX = std::abs((command.x / tibia::TILE_SIZE) - client.creature->getX());
+                int distanceY = std::abs((command.y / tibia::TILE_SIZE) - client.creature->getY());
+
+                return distanceX <= 1 && distanceY <= 1;
+            }
+        }
+
+        return false;
+    }
+
+    sf::IntRect getInterestRect(tibia::Creature* creature)
+    {
+        int distance = tibia::SERVER_INTEREST_DISTANCE;
+
+        return sf::IntRect(creature->getX() - distance, creature->getY() - distance, (distance * 2) + 1, (distance * 2) + 1);
+    }
+
+    void sendState(Client& client)
+    {
+        tibia::Creature* creature = client.creature.get();
+
+        sf::IntRect interestRect = getInterestRect(creature);
+
+        tibia::InterestManager* interestManager = m_game->getInterestManager();
+
+        interestManager->setObserverRect(client.observerId, interestRect);
+
+        m_interestList.clear();
+
+        for (auto interestCreature : interestManager->getCreatures(client.observerId))
+        {
+            if
+            (
+                interestCreature->getZ() == creature->getZ() &&
+                interestCreature->hasDecayed() == false &&
+                interestRect.contains(interestCreature->getX(), interestCreature->getY()) == true
+            )
+            {
+                m_interestList.push_back(interestCreature);
+            }
+        }
+
+        beginMessage(tibia::ServerMessageTypes::state);
+
+        tibia::BinaryStream::writeVarUint(m_messageStream, m_game->getTick());
+
+        tibia::BinaryStream::writeVarUint(m_messageStream, m_interestList.size());
+
+        for (auto interestCreature : m_interestList)
+        {
+            tibia::BinaryStream::writeVarUint(m_messageStream, interestCreature->getSpawnId());
+
+            tibia::StateStream::writeCreature(m_messageStream, m_game->getStateCreature(interestCreature));
+        }
+
+        sendMessage(client);
+    }
+
+    void removeDisconnectedClients()
+    {
+        for (auto& client : m_clientsList)
+        {
+            if (client.transport->isConnected() == true)
+            {
+                continue;
+            }
+
+            m_game->removeCreature(client.creature.get());
+
+            m_game->getInterestManager()->removeObserver(client.observerId);
+        }
+
+        m_clientsList.erase
+        (
+            std::remove_if
+            (
+                m_clientsList.begin(),
+                m_clientsList.end(),
+                [](const Client& client)
+                {
+                    return client.transport->isConnected() == false;
+                }
+            ),
+            m_clientsList.end()
+        );
+    }
+
+    void beginMessage(int type)
+    {
+        m_messageStream.str("");
+        m_messageStream.clear();
+
+        tibia::BinaryStream::writeVarUint(m_messageStream, type);
+    }
+
+    void sendMessage(Client& client)
+    {
+        m_message = m_messageStream.str();
+
+        if (client.transport->send(m_message) == true)
+        {
+            m_numBytesSent += m_message.size();
+        }
+    }
+
+    tibia::Game* m_game;
+
+    std::vector<Client> m_clientsList;
+
+    std::vector<tibia::Creature*> m_interestList;
+
+    std::ostringstream m_messageStream;
+
+    std::string m_message;
+
+    unsigned int m_numCommands;
+    unsigned int m_numCommandsDropped;
+
+    std::uint64_t m_numBytesSent;
+
+};
+
+// a client that wanders, turns, shoots and pulls levers at random, used to load the server
+class ScriptedClient
+{
+
+public:
+
+    ScriptedClient(std::shared_ptr<tibia::Transport> transport, std::uint64_t seed)
+    {
+        m_transport = transport;
+
+        m_random.setSeed(seed);
+
+        m_spawnId = 0;
+
+        m_hasCreature = false;
+
+        m_numCreaturesVisible = 0;
+
+        m_numStatesReceived = 0;
+    }
+
+    // reads what the server sent since the last tick, then sends this tick's commands as one message
+    void doTick()
+    {
+        receiveMessages();
+
+        if (m_spawnId == 0 || m_hasCreature == false)
+        {
+            return;
+        }
+
+        m_commandsList.clear();
+
+        int random = m_random.getNumber(0, 99);
+
+        int direction = m_creature.direction;
+
+        if (random < 4)
+        {
+            m_commandsList.push_back(tibia::makeCommand(tibia::CommandTypes::move, m_random.getNumber(tibia::Directions::begin, tibia::Directions::end)));
+        }
+        else if (random < 6)
+        {
+            m_commandsList.push_back(tibia::makeCommand(tibia::CommandTypes::turn, m_random.getNumber(tibia::Directions::begin, tibia::Directions::end)));
+        }
+        else if (random < 7)
+        {
+            m_commandsList.push_back(tibia::makeCommand(tibia::CommandTypes::spawnProjectile, direction, tibia::ProjectileTypes::arrow));
+        }
+        else if (random < 8)
+        {
+            sf::Vector2f vector = tibia::getVectorByDirection(direction);
+
+            int x = (m_creature.x + static_cast<int>(vector.x)) * tibia::TILE_SIZE;
+            int y = (m_creature.y + static_cast<int>(vector.y)) * tibia::TILE_SIZE;
+
+            m_commandsList.push_back(tibia::makeCommand(tibia::CommandTypes::use, 0, 0, x, y));
+        }
+
+        if (m_commandsList.size() == 0)
+        {
+            return;
+        }
+
+        std::ostringstream stream;
+
+        tibia::BinaryStream::writeVarUint(stream, tibia::ClientMessageTypes::commands);
+        tibia::BinaryStream::writeVarUint(stream, m_commandsList.size());
+
+        for (auto& command : m_commandsList)
+        {
+            tibia::BinaryStream::writeVarUint(stream, command.type);
+            tibia::BinaryStream::writeVarUint(stream, command.direction);
+            tibia::BinaryStream::writeVarUint(stream, command.projectileType);
+            tibia::BinaryStream::writeVarInt (stream, command.x);
+            tibia::BinaryStream::writeVarInt (stream, command.y);
+        }
+
+        m_transport->send(stream.str());
+    }
+
+    bool isConnected()
+    {
+        return m_transport->isConnected();
+    }
+
+    int getSpawnId()
+    {
+        return m_spawnId;
+    }
+
+    int getNumCreaturesVisible()
+    {
+        return m_numCreaturesVisible;
+    }
+
+    unsigned int getNumStatesReceived()
+    {
+        return m_numStatesReceived;
+    }
+
+private:
+
+    void receiveMessages()
+    {
+        std::string message;
+
+        while (m_transport->receive(message) == true)
+        {
+            std::istringstream stream(message);
+
+            int type = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            if (type == tibia::ServerMessageTypes::welcome)
+            {
+                m_spawnId = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+                continue;
+            }
+
+            if (type != tibia::ServerMessageTypes::state)
+            {
+                continue;
+            }
+
+            tibia::BinaryStream::readVarUint(stream);
+
+            unsigned int numCreatures = static_cast<unsigned int>(tibia::BinaryStream::readVarUint(stream));
+
+            m_hasCreature = false;
+
+            m_numCreaturesVisible = 0;
+
+            tibia::StateCreature creature;
+
+            for (unsigned int i = 0; i < numCreatures; i++)
+            {
+                creature.spawnId = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+                tibia::StateStream::readCreature(stream, creature);
+
+                if (stream.fail() == true)
+                {
+                    break;
+                }
+
+                if (creature.spawnId == m_spawnId)
+                {
+                    m_creature = creature;
+
+                    m_hasCreature = (creature.flags & tibia::StateCreatureFlags::isDead) == 0;
+
+                    continue;
+                }
+
+                m_numCreaturesVisible++;
+            }
+
+            m_numStatesReceived++;
+        }
+    }
+
+    std::shared_ptr<tibia::Transport> m_transport;
+
+    tibia::Random m_random;
+
+    int m_spawnId;
+
+    tibia::StateCreature m_creature;
+
+    bool m_hasCreature;
+
+    int m_numCreaturesVisible;
+
+    unsigned int m_numStatesReceived;
+
+    std::vector<tibia::Command> m_commandsList;
+
+};
+
+}
+
+#endif // TIBIA_SERVER_HPP
@@ -0,0 +1,374 @@
+#ifndef TIBIA_SOUNDBANK_HPP
+#define TIBIA_SOUNDBANK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <exception>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <SFML/Audio.hpp>
+
+#include "tibia/BinaryStream.hpp"
+
+namespace tibia
+{
+
+// every sound decoded once into a single file of 16-bit samples that is memory mapped, each buffer is
+// created from its slice of the mapping. sf::SoundBuffer copies the samples, so the mapping saves decoding
+// at startup rather than memory. lazy sounds are left in the mapping until they are first asked for
+// layout: header, source table, sound table, padding to an even offset, then the samples of each sound in native byte order
+class SoundBank
+{
+
+public:
+
+    static const std::uint32_t FILE_MAGIC   = 0x41424954; // "TIBA"
+    static const std::uint32_t FILE_VERSION = 2;
+
+    struct Source
+    {
+        std::string name;
+
+        std::string filename;
+
+        bool isLazy;
+    };
+
+    struct Sound
+    {
+        std::string name;
+
+        unsigned int sampleRate;
+        unsigned int channelCount;
+
+        std::uint64_t sampleCount;
+
+        // from the start of the samples
+        std::uint64_t dataOffset;
+
+        bool isLazy;
+
+        std::shared_ptr<sf::SoundBuffer> buffer;
+    };
+
+    static tibia::SoundBank::Source makeSource(std::string name, std::string filename, bool isLazy = false)
+    {
+        tibia::SoundBank::Source source;
+        source.name     = name;
+        source.filename = filename;
+        source.isLazy   = isLazy;
+
+        return source;
+    }
+
+    static std::uint64_t getFileSize(std::string filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+
+        if (file.is_open() == false)
+        {
+            return 0;
+        }
+
+        return static_cast<std::uint64_t>(file.tellg());
+    }
+
+    // the size and hash of every source, a bank is stale once any source differs from when it was made
+    static void writeSourceTable(std::ostream& stream, const std::vector<Source>& sourcesList)
+    {
+        tibia::BinaryStream::writeUint32(stream, sourcesList.size());
+
+        for (auto& source : sourcesList)
+        {
+            tibia::BinaryStream::writeString(stream, source.filename);
+            tibia::BinaryStream::writeUint64(stream, getFileSize(source.filename));
+            tibia::BinaryStream::writeUint64(stream, tibia::BinaryStream::getFileHash(source.filename));
+        }
+    }
+
+    static bool readSourceTable(std::istream& stream, const std::vector<Source>& sourcesList)
+    {
+        if (tibia::BinaryStream::readUint32(stream) != sourcesList.size())
+        {
+            return false;
+        }
+
+        for (auto& source : sourcesList)
+        {
+            if (tibia::BinaryStream::readString(stream) != source.filename)
+            {
+                return false;
+            }
+
+            if (tibia::BinaryStream::readUint64(stream) != getFileSize(source.filename))
+            {
+                return false;
+            }
+
+            if (tibia::BinaryStream::readUint64(stream) != tibia::BinaryStream::getFileHash(source.filename))
+            {
+                return false;
+            }
+        }
+
+        return stream.fail() == false;
+    }
+
+    // sources that cannot be decoded are left out of the bank
+    static bool create(std::string filename, const std::vector<Source>& sourcesList)
+    {
+        std::vector<Sound> soundsList;
+
+        std::vector<std::shared_ptr<sf::SoundBuffer>> buffersList;
+
+        std::uint64_t dataOffset = 0;
+
+        for (auto& source : sourcesList)
+        {
+            std::shared_ptr<sf::SoundBuffer> buffer = std::make_shared<sf::SoundBuffer>();
+
+            if (buffer->loadFromFile(source.filename) == false)
+            {
+                continue;
+            }
+
+            Sound sound;
+            sound.name         = source.name;
+            sound.sampleRate   = buffer->getSampleRate();
+            sound.channelCount = buffer->getChannelCount();
+            sound.sampleCount  = buffer->getSampleCount();
+            sound.dataOffset   = dataOffset;
+            sound.isLazy       = source.isLazy;
+
+            soundsList.push_back(sound);
+
+            buffersList.push_back(buffer);
+
+            dataOffset += sound.sampleCount * sizeof(sf::Int16);
+        }
+
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        tibia::BinaryStream::writeUint32(file, FILE_MAGIC);
+        tibia::BinaryStream::writeUint32(file, FILE_VERSION);
+
+        writeSourceTable(file, sourcesList);
+
+        tibia::BinaryStream::writeUint32(file, soundsList.size());
+
+        for (auto& sound : soundsList)
+        {
+            tibia::BinaryStream::writeString(file, sound.name);
+            tibia::BinaryStream::writeUint32(file, sound.sampleRate);
+            tibia::BinaryStream::writeUint32(file, sound.channelCount);
+            tibia::BinaryStream::writeUint64(file, sound.sampleCount);
+            tibia::BinaryStream::writeUint64(file, sound.dataOffset);
+            tibia::BinaryStream::writeUint8 (file, sound.isLazy == true ? 1 : 0);
+        }
+
+        if (static_cast<std::uint64_t>(file.tellp()) % 2 != 0)
+        {
+            tibia::BinaryStream::writeUint8(file, 0);
+        }
+
+        for (auto& buffer : buffersList)
+        {
+            file.write(reinterpret_cast<const char*>(buffer->getSamples()), buffer->getSampleCount() * sizeof(sf::Int16));
+        }
+
+        return file.good();
+    }
+
+    SoundBank()
+    {
+        m_dataStart = 0;
+
+        m_numSoundsLoaded = 0;
+    }
+
+    // maps the bank and loads every sound that is not lazy, false if the bank was made from other sources
+    bool open(std::string filename, const std::vector<Source>& sourcesList)
+    {
+        close();
+
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (file.is_open() == false)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(file) != FILE_MAGIC)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(file) != FILE_VERSION)
+        {
+            return false;
+        }
+
+        if (readSourceTable(file, sourcesList) == false)
+        {
+            return false;
+        }
+
+        unsigned int numSounds = tibia::BinaryStream::readUint32(file);
+
+        for (unsigned int i = 0; i < numSounds; i++)
+        {
+            Sound sound;
+            sound.name         = tibia::BinaryStream::readString(file);
+            sound.sampleRate   = tibia::BinaryStream::readUint32(file);
+            sound.channelCount = tibia::BinaryStream::readUint32(file);
+            sound.sampleCount  = tibia::BinaryStream::readUint64(file);
+            sound.dataOffset   = tibia::BinaryStream::readUint64(file);
+            sound.isLazy       = tibia::BinaryStream::readUint8(file) != 0;
+
+            m_soundsList.push_back(sound);
+        }
+
+        if (file.fail() == true)
+        {
+            close();
+            return false;
+        }
+
+        m_dataStart = static_cast<std::uint64_t>(file.tellg());
+        m_dataStart += m_dataStart % 2;
+
+        file.close();
+
+        // boost reports a failed mapping by throwing
+        try
+        {
+            m_file.open(filename);
+        }
+        catch (const std::exception&)
+        {
+            close();
+            return false;
+        }
+
+        for (auto& sound : m_soundsList)
+        {
+            if (m_dataStart + sound.dataOffset + (sound.sampleCount * sizeof(sf::Int16)) > m_file.size())
+            {
+                close();
+                return false;
+            }
+        }
+
+        for (auto& sound : m_soundsList)
+        {
+            if (sound.isLazy == false)
+            {
+                loadSound(sound);
+            }
+        }
+
+        return true;
+    }
+
+    void close()
+    {
+        if (m_file.is_open() == true)
+        {
+            m_file.close();
+        }
+
+        m_soundsList.clear();
+
+        m_dataStart = 0;
+
+        m_numSoundsLoaded = 0;
+    }
+
+    // nullptr if the bank has no such sound, a lazy sound is loaded here the first time
+    sf::SoundBuffer* getBuffer(std::string name)
+    {
+        for (auto& sound : m_soundsList)
+        {
+            if (sound.name != name)
+            {
+                continue;
+            }
+
+            if (sound.buffer == nullptr && loadSound(sound) == false)
+            {
+                return nullptr;
+            }
+
+            return sound.buffer.get();
+        }
+
+        return nullptr;
+    }
+
+    int getNumSounds()
+    {
+        return m_soundsList.size();
+    }
+
+    int getNumSoundsLoaded()
+    {
+        return m_numSoundsLoaded;
+    }
+
+    std::uint64_t getNumBytesMapped()
+    {
+        if (m_file.is_open() == false)
+        {
+            return 0;
+        }
+
+        return m_file.size();
+    }
+
+private:
+
+    bool loadSound(Sound& sound)
+    {
+        if (m_file.is_open() == false || sound.sampleCount == 0)
+        {
+            return false;
+        }
+
+        const sf::Int16* samples = reinterpret_cast<const sf::Int16*>(m_file.data() + m_dataStart + sound.dataOffset);
+
+        std::shared_ptr<sf::SoundBuffer> buffer = std::make_shared<sf::SoundBuffer>();
+
+        if (buffer->loadFromSamples(samples, sound.sampleCount, sound.channelCount, sound.sampleRate) == false)
+        {
+            return false;
+        }
+
+        sound.buffer = buffer;
+
+        m_numSoundsLoaded++;
+
+        return true;
+    }
+
+    boost::iostreams::mapped_file_source m_file;
+
+    std::uint64_t m_dataStart;
+
+    std::vector<Sound> m_soundsList;
+
+    int m_numSoundsLoaded;
+
+};
+
+}
+
+#endif // TIBIA_SOUNDBANK_HPP
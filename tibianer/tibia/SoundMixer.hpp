@@ -0,0 +1,235 @@
+#ifndef TIBIA_SOUNDMIXER_HPP
+#define TIBIA_SOUNDMIXER_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include <SFML/Audio.hpp>
+
+#include "tibia/Tibia.hpp"
+
+namespace tibia
+{
+
+// plays sounds through a fixed pool of voices. sounds are queued during the tick and started together,
+// identical sounds from the same tick are played once at the loudest of their volumes. when every voice
+// is busy the quietest one is stolen, unless the new sound is quieter still, then it is dropped
+class SoundMixer
+{
+
+public:
+
+    struct Request
+    {
+        const sf::SoundBuffer* buffer;
+
+        float volume;
+
+        unsigned int tick;
+    };
+
+    struct Voice
+    {
+        sf::Sound sound;
+
+        float volume;
+    };
+
+    SoundMixer()
+    {
+        m_voicesList.resize(tibia::SOUND_VOICES_MAX);
+
+        for (auto& voice : m_voicesList)
+        {
+            voice.volume = 0;
+        }
+
+        m_numSoundsPlayed    = 0;
+        m_numSoundsCoalesced = 0;
+        m_numSoundsDropped   = 0;
+        m_numVoicesStolen    = 0;
+    }
+
+    // the volume decides the priority, quieter sounds are the first to go
+    void addSound(const sf::SoundBuffer& buffer, float volume, unsigned int tick)
+    {
+        if (volume <= 0 || buffer.getSampleCount() == 0)
+        {
+            return;
+        }
+
+        for (auto& request : m_requestsList)
+        {
+            if (request.buffer == &buffer && request.tick == tick)
+            {
+                request.volume = std::max(request.volume, volume);
+
+                m_numSoundsCoalesced++;
+                return;
+            }
+        }
+
+        Request request;
+        request.buffer = &buffer;
+        request.volume = volume;
+        request.tick   = tick;
+
+        // no more can be started at once than there are voices, so the queue never grows past that
+        if (static_cast<int>(m_requestsList.size()) >= tibia::SOUND_VOICES_MAX)
+        {
+            Request* quietestRequest = &m_requestsList.front();
+
+            for (auto& queuedRequest : m_requestsList)
+            {
+                if (queuedRequest.volume < quietestRequest->volume)
+                {
+                    quietestRequest = &queuedRequest;
+                }
+            }
+
+            if (quietestRequest->volume >= volume)
+            {
+                m_numSoundsDropped++;
+                return;
+            }
+
+            *quietestRequest = request;
+
+            m_numSoundsDropped++;
+            return;
+        }
+
+        m_requestsList.push_back(request);
+    }
+
+    // starts the queued sounds, loudest first
+    void update()
+    {
+        if (m_requestsList.size() == 0)
+        {
+            return;
+        }
+
+        std::sort
+        (
+            m_requestsList.begin(),
+            m_requestsList.end(),
+            [](const Request& a, const Request& b)
+            {
+                return a.volume > b.volume;
+            }
+        );
+
+        for (auto& request : m_requestsList)
+        {
+            Voice* voice = getVoice(request.volume);
+
+            if (voice == nullptr)
+            {
+                m_numSoundsDropped++;
+                continue;
+            }
+
+            voice->sound.setBuffer(*request.buffer);
+            voice->sound.setVolume(request.volume);
+            voice->sound.play();
+
+            voice->volume = request.volume;
+
+            m_numSoundsPlayed++;
+        }
+
+        m_requestsList.clear();
+    }
+
+    void stopAll()
+    {
+        for (auto& voice : m_voicesList)
+        {
+            voice.sound.stop();
+        }
+
+        m_requestsList.clear();
+    }
+
+    int getNumVoicesPlaying()
+    {
+        int numVoicesPlaying = 0;
+
+        for (auto& voice : m_voicesList)
+        {
+            if (voice.sound.getStatus() == sf::SoundSource::Status::Playing)
+            {
+                numVoicesPlaying++;
+            }
+        }
+
+        return numVoicesPlaying;
+    }
+
+    unsigned int getNumSoundsPlayed()
+    {
+        return m_numSoundsPlayed;
+    }
+
+    unsigned int getNumSoundsCoalesced()
+    {
+        return m_numSoundsCoalesced;
+    }
+
+    unsigned int getNumSoundsDropped()
+    {
+        return m_numSoundsDropped;
+    }
+
+    unsigned int getNumVoicesStolen()
+    {
+        return m_numVoicesStolen;
+    }
+
+private:
+
+    // a free voice, or the quietest playing one if it is quieter than the new sound
+    Voice* getVoice(float volume)
+    {
+        Voice* quietestVoice = nullptr;
+
+        for (auto& voice : m_voicesList)
+        {
+            if (voice.sound.getStatus() != sf::SoundSource::Status::Playing)
+            {
+                return &voice;
+            }
+
+            if (quietestVoice == nullptr || voice.volume < quietestVoice->volume)
+            {
+                quietestVoice = &voice;
+            }
+        }
+
+        if (quietestVoice == nullptr || quietestVoice->volume >= volume)
+        {
+            return nullptr;
+        }
+
+        quietestVoice->sound.stop();
+
+        m_numVoicesStolen++;
+
+        return quietestVoice;
+    }
+
+    std::vector<Voice> m_voicesList;
+
+    std::vector<Request> m_requestsList;
+
+    unsigned int m_numSoundsPlayed;
+    unsigned int m_numSoundsCoalesced;
+    unsigned int m_numSoundsDropped;
+    unsigned int m_numVoicesStolen;
+
+};
+
+}
+
+#endif // TIBIA_SOUNDMIXER_HPP
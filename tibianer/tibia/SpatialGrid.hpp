@@ -0,0 +1,296 @@
+#ifndef TIBIA_SPATIALGRID_HPP
+#define TIBIA_SPATIALGRID_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+#include "tibia/Tibia.hpp"
+
+namespace tibia
+{
+
+// buckets things by their tile into square cells so a rectangle of tiles only visits the cells it overlaps,
+// each thing remembers its cell so moving within a cell costs nothing and moving between cells is a swap
+template <typename T>
+class SpatialGrid
+{
+
+public:
+
+    static const int CELL_SIZE = 8;
+
+    // told whenever a thing is added, removed or moves to another cell
+    class Listener
+    {
+
+    public:
+
+        virtual ~Listener()
+        {
+        }
+
+        virtual void onThingAdded(T* thing, int cellIndex) = 0;
+
+        virtual void onThingRemoved(T* thing, int cellIndex) = 0;
+
+        virtual void onThingMoved(T* thing, int fromCellIndex, int toCellIndex) = 0;
+
+    };
+
+    SpatialGrid()
+    {
+        m_numCellsX = 0;
+        m_numCellsY = 0;
+
+        m_listener = nullptr;
+    }
+
+    void setListener(Listener* listener)
+    {
+        m_listener = listener;
+    }
+
+    // tile dimensions of the map, drops everything that was inserted before
+    void create(int width, int height)
+    {
+        m_numCellsX = std::max((width  + CELL_SIZE - 1) / CELL_SIZE, 1);
+        m_numCellsY = std::max((height + CELL_SIZE - 1) / CELL_SIZE, 1);
+
+        m_cellsList.clear();
+        m_cellsList.resize(m_numCellsX * m_numCellsY);
+    }
+
+    void clear()
+    {
+        for (unsigned int i = 0; i < m_cellsList.size(); i++)
+        {
+            std::vector<T*>& cell = m_cellsList[i];
+
+            for (auto thing : cell)
+            {
+                thing->setSpatialCell(-1);
+
+                if (m_listener != nullptr)
+                {
+                    m_listener->onThingRemoved(thing, i);
+                }
+            }
+
+            cell.clear();
+        }
+    }
+
+    void insert(T* thing)
+    {
+        int cellIndex = insertIntoCell(thing);
+
+        if (cellIndex >= 0 && m_listener != nullptr)
+        {
+            m_listener->onThingAdded(thing, cellIndex);
+        }
+    }
+
+    void remove(T* thing)
+    {
+        int cellIndex = removeFromCell(thing);
+
+        if (cellIndex >= 0 && m_listener != nullptr)
+        {
+            m_listener->onThingRemoved(thing, cellIndex);
+        }
+    }
+
+    // call after the thing may have moved
+    void update(T* thing)
+    {
+        if (getCellIndex(thing->getX(), thing->getY()) == thing->getSpatialCell())
+        {
+            return;
+        }
+
+        int fromCellIndex = removeFromCell(thing);
+        int toCellIndex   = insertIntoCell(thing);
+
+        if (m_listener == nullptr)
+        {
+            return;
+        }
+
+        if (fromCellIndex >= 0 && toCellIndex >= 0)
+        {
+            m_listener->onThingMoved(thing, fromCellIndex, toCellIndex);
+        }
+        else if (toCellIndex >= 0)
+        {
+            m_listener->onThingAdded(thing, toCellIndex);
+        }
+    }
+
+    // appends the things whose tile is inside the rectangle, given in tiles
+    void query(sf::IntRect tileRect, std::vector<T*>& resultList)
+    {
+        if (m_cellsList.size() == 0)
+        {
+            return;
+        }
+
+        int x1 = std::max(tileRect.left, 0);
+        int y1 = std::max(tileRect.top,  0);
+
+        int x2 = tileRect.left + tileRect.width  - 1;
+        int y2 = tileRect.top  + tileRect.height - 1;
+
+        if (x2 < x1 || y2 < y1)
+        {
+            return;
+        }
+
+        int cellX1 = std::min(x1 / CELL_SIZE, m_numCellsX - 1);
+        int cellY1 = std::min(y1 / CELL_SIZE, m_numCellsY - 1);
+
+        int cellX2 = std::min(x2 / CELL_SIZE, m_numCellsX - 1);
+        int cellY2 = std::min(y2 / CELL_SIZE, m_numCellsY - 1);
+
+        for (int cellY = cellY1; cellY <= cellY2; cellY++)
+        {
+            for (int cellX = cellX1; cellX <= cellX2; cellX++)
+            {
+                for (auto thing : m_cellsList[cellX + (cellY * m_numCellsX)])
+                {
+                    int x = thing->getX();
+                    int y = thing->getY();
+
+                    if (x >= x1 && x <= x2 && y >= y1 && y <= y2)
+                    {
+                        resultList.push_back(thing);
+                    }
+                }
+            }
+        }
+    }
+
+    // the cells overlapped by the rectangle of tiles, empty when it is outside the map
+    sf::IntRect getCellRect(sf::IntRect tileRect)
+    {
+        int x1 = std::max(tileRect.left, 0);
+        int y1 = std::max(tileRect.top,  0);
+
+        int x2 = tileRect.left + tileRect.width  - 1;
+        int y2 = tileRect.top  + tileRect.height - 1;
+
+        if (m_cellsList.size() == 0 || x2 < x1 || y2 < y1)
+        {
+            return sf::IntRect(0, 0, 0, 0);
+        }
+
+        int cellX1 = std::min(x1 / CELL_SIZE, m_numCellsX - 1);
+        int cellY1 = std::min(y1 / CELL_SIZE, m_numCellsY - 1);
+
+        int cellX2 = std::min(x2 / CELL_SIZE, m_numCellsX - 1);
+        int cellY2 = std::min(y2 / CELL_SIZE, m_numCellsY - 1);
+
+        return sf::IntRect(cellX1, cellY1, cellX2 - cellX1 + 1, cellY2 - cellY1 + 1);
+    }
+
+    int getCellIndexByCellCoords(int cellX, int cellY)
+    {
+        return cellX + (cellY * m_numCellsX);
+    }
+
+    const std::vector<T*>& getCellByIndex(int cellIndex)
+    {
+        return m_cellsList[cellIndex];
+    }
+
+    int getNumCells()
+    {
+        return m_cellsList.size();
+    }
+
+    // the things in the cell holding the tile, the caller still has to compare coords
+    const std::vector<T*>* getCell(int x, int y)
+    {
+        int cellIndex = getCellIndex(x, y);
+
+        if (cellIndex < 0)
+        {
+            return nullptr;
+        }
+
+        return &m_cellsList[cellIndex];
+    }
+
+private:
+
+    int insertIntoCell(T* thing)
+    {
+        int cellIndex = getCellIndex(thing->getX(), thing->getY());
+
+        if (cellIndex < 0)
+        {
+            return -1;
+        }
+
+        m_cellsList[cellIndex].push_back(thing);
+
+        thing->setSpatialCell(cellIndex);
+
+        return cellIndex;
+    }
+
+    // returns the cell the thing was in
+    int removeFromCell(T* thing)
+    {
+        int cellIndex = thing->getSpatialCell();
+
+        if (cellIndex < 0 || cellIndex >= static_cast<int>(m_cellsList.size()))
+        {
+            return -1;
+        }
+
+        std::vector<T*>& cell = m_cellsList[cellIndex];
+
+        for (unsigned int i = 0; i < cell.size(); i++)
+        {
+            if (cell[i] == thing)
+            {
+                cell[i] = cell.back();
+                cell.pop_back();
+
+                break;
+            }
+        }
+
+        thing->setSpatialCell(-1);
+
+        return cellIndex;
+    }
+
+    // things outside the map are kept in the nearest edge cell
+    int getCellIndex(int x, int y)
+    {
+        if (m_cellsList.size() == 0)
+        {
+            return -1;
+        }
+
+        int cellX = std::min(std::max(x / CELL_SIZE, 0), m_numCellsX - 1);
+        int cellY = std::min(std::max(y / CELL_SIZE, 0), m_numCellsY - 1);
+
+        return cellX + (cellY * m_numCellsX);
+    }
+
+    int m_numCellsX;
+    int m_numCellsY;
+
+    std::vector<std::vector<T*>> m_cellsList;
+
+    Listener* m_listener;
+
+};
+
+}
+
+#endif // TIBIA_SPATIALGRID_HPP
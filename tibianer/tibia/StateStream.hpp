@@ -0,0 +1,795 @@
+#ifndef TIBIA_STATESTREAM_HPP
+#define TIBIA_STATESTREAM_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+#include "tibia/BinaryStream.hpp"
+
+namespace tibia
+{
+
+namespace StateFrameTypes
+{
+    enum
+    {
+        keyframe,
+        delta,
+    };
+}
+
+namespace StateEventTypes
+{
+    enum
+    {
+        projectile,
+        animation,
+        animatedDecal,
+    };
+}
+
+// which fields of a creature in a delta differ from the keyframe
+namespace StateCreatureFields
+{
+    enum
+    {
+        position  = 1 << 0,
+        direction = 1 << 1,
+        hp        = 1 << 2,
+        flags     = 1 << 3,
+        outfit    = 1 << 4,
+        added     = 1 << 5,
+    };
+}
+
+namespace StateCreatureFlags
+{
+    enum
+    {
+        isPlayer   = 1 << 0,
+        isDead     = 1 << 1,
+        hasDecayed = 1 << 2,
+        hasOutfit  = 1 << 3,
+        isSitting  = 1 << 4,
+    };
+}
+
+struct StateCreature
+{
+    int spawnId;
+
+    int x;
+    int y;
+    int z;
+
+    int direction;
+
+    int hp;
+    int hpMax;
+
+    int type;
+    int team;
+
+    int flags;
+
+    int outfit[4];
+
+    std::string name;
+};
+
+struct StateEvent
+{
+    int type;
+
+    // projectiles
+    int projectileType;
+    int direction;
+    sf::Vector2f origin;
+    sf::Vector2f destination;
+    bool isPrecise;
+    bool isChild;
+
+    // animations and animated decals
+    int tileX;
+    int tileY;
+    int id;
+    int numFrames;
+    float frameTime;
+
+    int z;
+};
+
+struct StateFrame
+{
+    int type;
+
+    unsigned int tick;
+
+    // every creature as of the tick, deltas are already applied to the keyframe
+    std::vector<tibia::StateCreature> creaturesList;
+
+    std::vector<tibia::StateEvent> eventsList;
+};
+
+namespace StateStream
+{
+    const std::uint32_t FILE_MAGIC   = 0x57424954; // "TIBW"
+    const std::uint32_t FILE_VERSION = 1;
+
+    // a keyframe is sent at least this often so a spectator never applies deltas to a stale base for long
+    const unsigned int KEYFRAME_INTERVAL = 60; // in ticks
+
+    inline void writeCreature(std::ostream& stream, const tibia::StateCreature& creature)
+    {
+        tibia::BinaryStream::writeVarInt(stream, creature.x);
+        tibia::BinaryStream::writeVarInt(stream, creature.y);
+        tibia::BinaryStream::writeVarInt(stream, creature.z);
+
+        tibia::BinaryStream::writeVarUint(stream, creature.direction);
+
+        tibia::BinaryStream::writeVarInt(stream, creature.hp);
+        tibia::BinaryStream::writeVarInt(stream, creature.hpMax);
+
+        tibia::BinaryStream::writeVarUint(stream, creature.type);
+        tibia::BinaryStream::writeVarUint(stream, creature.team);
+
+        tibia::BinaryStream::writeUint8(stream, creature.flags);
+
+        for (int i = 0; i < 4; i++)
+        {
+            tibia::BinaryStream::writeVarUint(stream, creature.outfit[i]);
+        }
+
+        tibia::BinaryStream::writeString(stream, creature.name);
+    }
+
+    inline void readCreature(std::istream& stream, tibia::StateCreature& creature)
+    {
+        creature.x = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        creature.y = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        creature.z = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        creature.direction = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        creature.hp    = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        creature.hpMax = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        creature.type = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        creature.team = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        creature.flags = tibia::BinaryStream::readUint8(stream);
+
+        for (int i = 0; i < 4; i++)
+        {
+            creature.outfit[i] = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        }
+
+        creature.name = tibia::BinaryStream::readString(stream);
+    }
+
+    inline void writeEvent(std::ostream& stream, const tibia::StateEvent& event)
+    {
+        tibia::BinaryStream::writeUint8(stream, event.type);
+
+        tibia::BinaryStream::writeVarInt(stream, event.z);
+
+        if (event.type == tibia::StateEventTypes::projectile)
+        {
+            tibia::BinaryStream::writeVarUint(stream, event.projectileType);
+            tibia::BinaryStream::writeVarUint(stream, event.direction);
+
+            tibia::BinaryStream::writeFloat(stream, event.origin.x);
+            tibia::BinaryStream::writeFloat(stream, event.origin.y);
+
+            tibia::BinaryStream::writeFloat(stream, event.destination.x);
+            tibia::BinaryStream::writeFloat(stream, event.destination.y);
+
+            tibia::BinaryStream::writeUint8(stream, (event.isPrecise == true ? 1 : 0) | (event.isChild == true ? 2 : 0));
+
+            return;
+        }
+
+        tibia::BinaryStream::writeVarInt(stream, event.tileX);
+        tibia::BinaryStream::writeVarInt(stream, event.tileY);
+
+        tibia::BinaryStream::writeVarUint(stream, event.id);
+        tibia::BinaryStream::writeVarUint(stream, event.numFrames);
+
+        tibia::BinaryStream::writeFloat(stream, event.frameTime);
+    }
+
+    inline void readEvent(std::istream& stream, tibia::StateEvent& event)
+    {
+        event.type = tibia::BinaryStream::readUint8(stream);
+
+        event.z = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        if (event.type == tibia::StateEventTypes::projectile)
+        {
+            event.projectileType = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+            event.direction      = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            event.origin.x = tibia::BinaryStream::readFloat(stream);
+            event.origin.y = tibia::BinaryStream::readFloat(stream);
+
+            event.destination.x = tibia::BinaryStream::readFloat(stream);
+            event.destination.y = tibia::BinaryStream::readFloat(stream);
+
+            int flags = tibia::BinaryStream::readUint8(stream);
+
+            event.isPrecise = (flags & 1) != 0;
+            event.isChild   = (flags & 2) != 0;
+
+            return;
+        }
+
+        event.tileX = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+        event.tileY = static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+
+        event.id        = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+        event.numFrames = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        event.frameTime = tibia::BinaryStream::readFloat(stream);
+    }
+}
+
+// writes one frame per tick, keyframes hold every creature and deltas only the creatures that differ from
+// the last keyframe with positions and hp as varint differences, each frame is prefixed with its size
+// so a reader following the file while it grows only ever sees whole frames
+class StatePublisher
+{
+
+public:
+
+    StatePublisher()
+    {
+        m_numFrames = 0;
+
+        m_keyframeTick = 0;
+
+        m_isKeyframeRequested = true;
+
+        m_numBytesWritten = 0;
+    }
+
+    bool open(std::string filename)
+    {
+        m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (m_file.is_open() == false)
+        {
+            return false;
+        }
+
+        tibia::BinaryStream::writeUint32(m_file, tibia::StateStream::FILE_MAGIC);
+        tibia::BinaryStream::writeUint32(m_file, tibia::StateStream::FILE_VERSION);
+
+        m_file.flush();
+
+        m_numBytesWritten = 8;
+
+        m_isKeyframeRequested = true;
+
+        return true;
+    }
+
+    bool isOpen()
+    {
+        return m_file.is_open();
+    }
+
+    // the next frame is a keyframe, e.g. after the world was replaced by a snapshot
+    void requestKeyframe()
+    {
+        m_isKeyframeRequested = true;
+    }
+
+    void addEvent(const tibia::StateEvent& event)
+    {
+        m_eventsList.push_back(event);
+    }
+
+    void publish(unsigned int tick, const std::vector<tibia::StateCreature>& creaturesList)
+    {
+        if (m_file.is_open() == false)
+        {
+            m_eventsList.clear();
+            return;
+        }
+
+        m_frameStream.str("");
+        m_frameStream.clear();
+
+        if (m_isKeyframeRequested == true || tick - m_keyframeTick >= tibia::StateStream::KEYFRAME_INTERVAL)
+        {
+            writeKeyframe(tick, creaturesList);
+        }
+        else
+        {
+            writeDelta(tick, creaturesList);
+        }
+
+        tibia::BinaryStream::writeVarUint(m_frameStream, m_eventsList.size());
+
+        for (auto& event : m_eventsList)
+        {
+            tibia::StateStream::writeEvent(m_frameStream, event);
+        }
+
+        m_eventsList.clear();
+
+        std::string frame = m_frameStream.str();
+
+        tibia::BinaryStream::writeUint32(m_file, frame.size());
+
+        m_file.write(frame.data(), frame.size());
+        m_file.flush();
+
+        m_numFrames++;
+
+        m_numBytesWritten += 4 + frame.size();
+    }
+
+    int getNumFrames()
+    {
+        return m_numFrames;
+    }
+
+    std::uint64_t getNumBytesWritten()
+    {
+        return m_numBytesWritten;
+    }
+
+private:
+
+    void writeKeyframe(unsigned int tick, const std::vector<tibia::StateCreature>& creaturesList)
+    {
+        tibia::BinaryStream::writeUint8(m_frameStream, tibia::StateFrameTypes::keyframe);
+        tibia::BinaryStream::writeVarUint(m_frameStream, tick);
+
+        tibia::BinaryStream::writeVarUint(m_frameStream, creaturesList.size());
+
+        m_keyframeList.clear();
+
+        for (auto& creature : creaturesList)
+        {
+            tibia::BinaryStream::writeVarUint(m_frameStream, creature.spawnId);
+
+            tibia::StateStream::writeCreature(m_frameStream, creature);
+
+            m_keyframeList[creature.spawnId] = creature;
+        }
+
+        m_keyframeTick = tick;
+
+        m_isKeyframeRequested = false;
+    }
+
+    void writeDelta(unsigned int tick, const std::vector<tibia::StateCreature>& creaturesList)
+    {
+        tibia::BinaryStream::writeUint8(m_frameStream, tibia::StateFrameTypes::delta);
+        tibia::BinaryStream::writeVarUint(m_frameStream, tick);
+
+        m_changesStream.str("");
+        m_changesStream.clear();
+
+        int numChanged = 0;
+
+        int numFound = 0;
+
+        for (auto& creature : creaturesList)
+        {
+            auto keyframeList_it = m_keyframeList.find(creature.spawnId);
+
+            if (keyframeList_it == m_keyframeList.end())
+            {
+                tibia::BinaryStream::writeVarUint(m_changesStream, creature.spawnId);
+                tibia::BinaryStream::writeUint8(m_changesStream, tibia::StateCreatureFields::added);
+
+                tibia::StateStream::writeCreature(m_changesStream, creature);
+
+                numChanged++;
+
+                continue;
+            }
+
+            numFound++;
+
+            const tibia::StateCreature& keyframeCreature = keyframeList_it->second;
+
+            int fields = 0;
+
+            if (creature.x != keyframeCreature.x || creature.y != keyframeCreature.y || creature.z != keyframeCreature.z)
+            {
+                fields |= tibia::StateCreatureFields::position;
+            }
+
+            if (creature.direction != keyframeCreature.direction)
+            {
+                fields |= tibia::StateCreatureFields::direction;
+            }
+
+            if (creature.hp != keyframeCreature.hp || creature.hpMax != keyframeCreature.hpMax)
+            {
+                fields |= tibia::StateCreatureFields::hp;
+            }
+
+            if (creature.flags != keyframeCreature.flags)
+            {
+                fields |= tibia::StateCreatureFields::flags;
+            }
+
+            for (int i = 0; i < 4; i++)
+            {
+                if (creature.outfit[i] != keyframeCreature.outfit[i])
+                {
+                    fields |= tibia::StateCreatureFields::outfit;
+                }
+            }
+
+            if (fields == 0)
+            {
+                continue;
+            }
+
+            tibia::BinaryStream::writeVarUint(m_changesStream, creature.spawnId);
+            tibia::BinaryStream::writeUint8(m_changesStream, fields);
+
+            if (fields & tibia::StateCreatureFields::position)
+            {
+                tibia::BinaryStream::writeVarInt(m_changesStream, creature.x - keyframeCreature.x);
+                tibia::BinaryStream::writeVarInt(m_changesStream, creature.y - keyframeCreature.y);
+                tibia::BinaryStream::writeVarInt(m_changesStream, creature.z - keyframeCreature.z);
+            }
+
+            if (fields & tibia::StateCreatureFields::direction)
+            {
+                tibia::BinaryStream::writeVarUint(m_changesStream, creature.direction);
+            }
+
+            if (fields & tibia::StateCreatureFields::hp)
+            {
+                tibia::BinaryStream::writeVarInt(m_changesStream, creature.hp    - keyframeCreature.hp);
+                tibia::BinaryStream::writeVarInt(m_changesStream, creature.hpMax - keyframeCreature.hpMax);
+            }
+
+            if (fields & tibia::StateCreatureFields::flags)
+            {
+                tibia::BinaryStream::writeUint8(m_changesStream, creature.flags);
+            }
+
+            if (fields & tibia::StateCreatureFields::outfit)
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    tibia::BinaryStream::writeVarUint(m_changesStream, creature.outfit[i]);
+                }
+            }
+
+            numChanged++;
+        }
+
+        tibia::BinaryStream::writeVarUint(m_frameStream, numChanged);
+
+        std::string changes = m_changesStream.str();
+
+        m_frameStream.write(changes.data(), changes.size());
+
+        // creatures from the keyframe that are gone, only searched for when some are missing
+        std::vector<int> removedList;
+
+        if (numFound != static_cast<int>(m_keyframeList.size()))
+        {
+            std::unordered_map<int, bool> foundList;
+
+            for (auto& creature : creaturesList)
+            {
+                foundList[creature.spawnId] = true;
+            }
+
+            for (auto& keyframeList_it : m_keyframeList)
+            {
+                if (foundList.find(keyframeList_it.first) == foundList.end())
+                {
+                    removedList.push_back(keyframeList_it.first);
+                }
+            }
+        }
+
+        tibia::BinaryStream::writeVarUint(m_frameStream, removedList.size());
+
+        for (auto spawnId : removedList)
+        {
+            tibia::BinaryStream::writeVarUint(m_frameStream, spawnId);
+        }
+    }
+
+    std::ofstream m_file;
+
+    std::ostringstream m_frameStream;
+    std::ostringstream m_changesStream;
+
+    std::unordered_map<int, tibia::StateCreature> m_keyframeList;
+
+    unsigned int m_keyframeTick;
+
+    bool m_isKeyframeRequested;
+
+    std::vector<tibia::StateEvent> m_eventsList;
+
+    int m_numFrames;
+
+    std::uint64_t m_numBytesWritten;
+
+};
+
+// follows a state stream file, frames that are still being written are picked up on a later call
+class StateReader
+{
+
+public:
+
+    StateReader()
+    {
+        m_readPosition = 0;
+
+        m_hasKeyframe = false;
+    }
+
+    bool open(std::string filename)
+    {
+        m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (m_file.is_open() == false)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(m_file) != tibia::StateStream::FILE_MAGIC)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(m_file) != tibia::StateStream::FILE_VERSION)
+        {
+            return false;
+        }
+
+        m_readPosition = m_file.tellg();
+
+        m_hasKeyframe = false;
+
+        return true;
+    }
+
+    // deltas read before the first keyframe are skipped
+    bool readFrame(tibia::StateFrame& frame)
+    {
+        while (true)
+        {
+            if (readFramePayload() == false)
+            {
+                return false;
+            }
+
+            std::istringstream stream(m_payload, std::ios::in | std::ios::binary);
+
+            frame.type = tibia::BinaryStream::readUint8(stream);
+            frame.tick = static_cast<unsigned int>(tibia::BinaryStream::readVarUint(stream));
+
+            if (frame.type == tibia::StateFrameTypes::keyframe)
+            {
+                readKeyframe(stream);
+            }
+            else if (m_hasKeyframe == true)
+            {
+                readDelta(stream);
+            }
+            else
+            {
+                continue;
+            }
+
+            frame.creaturesList = m_creaturesList;
+
+            frame.eventsList.clear();
+
+            int numEvents = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            for (int i = 0; i < numEvents; i++)
+            {
+                tibia::StateEvent event;
+                tibia::StateStream::readEvent(stream, event);
+
+                frame.eventsList.push_back(event);
+            }
+
+            return stream.fail() == false;
+        }
+    }
+
+private:
+
+    bool readFramePayload()
+    {
+        m_file.clear();
+        m_file.seekg(0, std::ios::end);
+
+        std::streamoff fileSize = m_file.tellg();
+
+        if (fileSize - m_readPosition < 4)
+        {
+            return false;
+        }
+
+        m_file.seekg(m_readPosition);
+
+        std::uint32_t frameSize = tibia::BinaryStream::readUint32(m_file);
+
+        if (fileSize - m_readPosition - 4 < static_cast<std::streamoff>(frameSize))
+        {
+            return false;
+        }
+
+        m_payload.resize(frameSize);
+
+        if (frameSize != 0)
+        {
+            m_file.read(&m_payload[0], frameSize);
+        }
+
+        m_readPosition += 4 + frameSize;
+
+        return true;
+    }
+
+    void readKeyframe(std::istream& stream)
+    {
+        int numCreatures = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        m_keyframeList.clear();
+
+        m_keyframeList.resize(numCreatures);
+
+        for (auto& creature : m_keyframeList)
+        {
+            creature.spawnId = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            tibia::StateStream::readCreature(stream, creature);
+        }
+
+        m_keyframeIndexes.clear();
+
+        for (unsigned int i = 0; i < m_keyframeList.size(); i++)
+        {
+            m_keyframeIndexes[m_keyframeList.at(i).spawnId] = i;
+        }
+
+        m_creaturesList = m_keyframeList;
+
+        m_hasKeyframe = true;
+    }
+
+    void readDelta(std::istream& stream)
+    {
+        m_creaturesList = m_keyframeList;
+
+        std::vector<tibia::StateCreature> addedList;
+
+        int numChanged = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        for (int i = 0; i < numChanged && stream.fail() == false; i++)
+        {
+            int spawnId = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+            int fields = tibia::BinaryStream::readUint8(stream);
+
+            if (fields & tibia::StateCreatureFields::added)
+            {
+                tibia::StateCreature creature;
+                creature.spawnId = spawnId;
+
+                tibia::StateStream::readCreature(stream, creature);
+
+                addedList.push_back(creature);
+
+                continue;
+            }
+
+            auto keyframeIndexes_it = m_keyframeIndexes.find(spawnId);
+
+            if (keyframeIndexes_it == m_keyframeIndexes.end())
+            {
+                stream.setstate(std::ios::failbit);
+                return;
+            }
+
+            tibia::StateCreature& creature = m_creaturesList.at(keyframeIndexes_it->second);
+
+            if (fields & tibia::StateCreatureFields::position)
+            {
+                creature.x += static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+                creature.y += static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+                creature.z += static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+            }
+
+            if (fields & tibia::StateCreatureFields::direction)
+            {
+                creature.direction = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+            }
+
+            if (fields & tibia::StateCreatureFields::hp)
+            {
+                creature.hp    += static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+                creature.hpMax += static_cast<int>(tibia::BinaryStream::readVarInt(stream));
+            }
+
+            if (fields & tibia::StateCreatureFields::flags)
+            {
+                creature.flags = tibia::BinaryStream::readUint8(stream);
+            }
+
+            if (fields & tibia::StateCreatureFields::outfit)
+            {
+                for (int j = 0; j < 4; j++)
+                {
+                    creature.outfit[j] = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+                }
+            }
+        }
+
+        int numRemoved = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+
+        if (numRemoved != 0)
+        {
+            std::unordered_map<int, bool> removedList;
+
+            for (int i = 0; i < numRemoved; i++)
+            {
+                removedList[static_cast<int>(tibia::BinaryStream::readVarUint(stream))] = true;
+            }
+
+            m_creaturesList.erase
+            (
+                std::remove_if
+                (
+                    m_creaturesList.begin(),
+                    m_creaturesList.end(),
+                    [&removedList](const tibia::StateCreature& creature)
+                    {
+                        return removedList.find(creature.spawnId) != removedList.end();
+                    }
+                ),
+                m_creaturesList.end()
+            );
+        }
+
+        m_creaturesList.insert(m_creaturesList.end(), addedList.begin(), addedList.end());
+    }
+
+    std::ifstream m_file;
+
+    std::streamoff m_readPosition;
+
+    std::string m_payload;
+
+    bool m_hasKeyframe;
+
+    std::vector<tibia::StateCreature> m_keyframeList;
+
+    std::unordered_map<int, int> m_keyframeIndexes;
+
+    std::vector<tibia::StateCreature> m_creaturesList;
+
+};
+
+}
+
+#endif // TIBIA_STATESTREAM_HPP
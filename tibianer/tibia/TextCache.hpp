@@ -0,0 +1,252 @@
+#ifndef TIBIA_TEXTCACHE_HPP
+#define TIBIA_TEXTCACHE_HPP
+
+#include <cmath>
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+
+#include <SFML/Graphics.hpp>
+
+namespace tibia
+{
+
+// strings are rendered once with their outline into a texture and drawn as a single sprite after that,
+// keyed by font, string, size and colours, least recently used entries are evicted first
+class TextCache
+{
+
+public:
+
+    typedef std::shared_ptr<sf::RenderTexture> RenderTexturePtr;
+
+    static const unsigned int ENTRIES_MAX = 64;
+
+    struct Key
+    {
+        const sf::Font* font;
+
+        std::string text;
+
+        unsigned int characterSize;
+
+        sf::Uint32 color;
+        sf::Uint32 outlineColor;
+
+        bool operator==(const Key& key) const
+        {
+            return
+                font          == key.font          &&
+                characterSize == key.characterSize &&
+                color         == key.color         &&
+                outlineColor  == key.outlineColor  &&
+                text          == key.text;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const
+        {
+            std::size_t hash = std::hash<std::string>()(key.text);
+
+            hash ^= std::hash<const void*>()(key.font) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<unsigned int>()(key.characterSize) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<sf::Uint32>()(key.color) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<sf::Uint32>()(key.outlineColor) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+
+            return hash;
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+
+        RenderTexturePtr renderTexture;
+
+        sf::Vector2f offset;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    TextCache()
+    {
+        m_numHits   = 0;
+        m_numMisses = 0;
+    }
+
+    // an outline colour with zero alpha draws the text without an outline
+    void draw(sf::RenderTarget& target, const sf::Font& font, const std::string& text, unsigned int characterSize, sf::Color color, sf::Color outlineColor, sf::Vector2f position)
+    {
+        if (text.empty() == true)
+        {
+            return;
+        }
+
+        Entry* entry = getEntry(font, text, characterSize, color, outlineColor);
+
+        if (entry == nullptr)
+        {
+            return;
+        }
+
+        sf::Sprite sprite(entry->renderTexture->getTexture());
+        sprite.setPosition(position + entry->offset);
+
+        target.draw(sprite);
+    }
+
+    // converted into a reused string so drawing text that is already cached allocates nothing
+    void draw(sf::RenderTarget& target, const sf::Font& font, const sf::String& text, unsigned int characterSize, sf::Color color, sf::Color outlineColor, sf::Vector2f position)
+    {
+        m_string.clear();
+
+        for (std::size_t i = 0; i < text.getSize(); i++)
+        {
+            m_string.push_back(static_cast<char>(text[i]));
+        }
+
+        draw(target, font, m_string, characterSize, color, outlineColor, position);
+    }
+
+    void draw(sf::RenderTarget& target, const sf::Text& text, sf::Color outlineColor)
+    {
+        draw(target, *text.getFont(), text.getString(), text.getCharacterSize(), text.getColor(), outlineColor, text.getPosition());
+    }
+
+    void clear()
+    {
+        m_entriesList.clear();
+
+        m_entriesMap.clear();
+    }
+
+    int getNumEntries()
+    {
+        return m_entriesList.size();
+    }
+
+    unsigned int getNumHits()
+    {
+        return m_numHits;
+    }
+
+    unsigned int getNumMisses()
+    {
+        return m_numMisses;
+    }
+
+private:
+
+    static sf::Uint32 getColorInteger(sf::Color color)
+    {
+        return (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
+    }
+
+    Entry* getEntry(const sf::Font& font, const std::string& text, unsigned int characterSize, sf::Color color, sf::Color outlineColor)
+    {
+        // assigning into the member key reuses its string capacity, a new key is only copied on a miss
+        Key& key = m_key;
+        key.font          = &font;
+        key.text          = text;
+        key.characterSize = characterSize;
+        key.color         = getColorInteger(color);
+        key.outlineColor  = getColorInteger(outlineColor);
+
+        auto entriesMap_it = m_entriesMap.find(key);
+
+        if (entriesMap_it != m_entriesMap.end())
+        {
+            m_entriesList.splice(m_entriesList.begin(), m_entriesList, entriesMap_it->second);
+
+            m_numHits++;
+
+            return &m_entriesList.front();
+        }
+
+        m_numMisses++;
+
+        sf::Text textRender(text, font, characterSize);
+        textRender.setColor(color);
+
+        sf::FloatRect textBounds = textRender.getLocalBounds();
+
+        unsigned int width  = static_cast<unsigned int>(std::ceil(textBounds.width))  + 2;
+        unsigned int height = static_cast<unsigned int>(std::ceil(textBounds.height)) + 2;
+
+        RenderTexturePtr renderTexture = std::make_shared<sf::RenderTexture>();
+
+        if (renderTexture->create(width, height) == false)
+        {
+            return nullptr;
+        }
+
+        renderTexture->clear(sf::Color::Transparent);
+
+        sf::Vector2f textPosition(1 - textBounds.left, 1 - textBounds.top);
+
+        if (outlineColor.a != 0)
+        {
+            sf::Text textOutline = textRender;
+            textOutline.setColor(outlineColor);
+
+            for (int i = -1; i < 2; i++)
+            {
+                for (int j = -1; j < 2; j++)
+                {
+                    if (i == 0 && j == 0)
+                    {
+                        continue;
+                    }
+
+                    textOutline.setPosition(textPosition.x + i, textPosition.y + j);
+
+                    renderTexture->draw(textOutline);
+                }
+            }
+        }
+
+        textRender.setPosition(textPosition);
+
+        renderTexture->draw(textRender);
+
+        renderTexture->display();
+
+        Entry entry;
+        entry.key           = key;
+        entry.renderTexture = renderTexture;
+        entry.offset        = sf::Vector2f(textBounds.left - 1, textBounds.top - 1);
+
+        m_entriesList.push_front(entry);
+
+        m_entriesMap[key] = m_entriesList.begin();
+
+        while (m_entriesList.size() > ENTRIES_MAX)
+        {
+            m_entriesMap.erase(m_entriesList.back().key);
+
+            m_entriesList.pop_back();
+        }
+
+        return &m_entriesList.front();
+    }
+
+    EntryList m_entriesList;
+
+    std::unordered_map<Key, EntryList::iterator, KeyHash> m_entriesMap;
+
+    Key m_key;
+
+    std::string m_string;
+
+    unsigned int m_numHits;
+    unsigned int m_numMisses;
+
+};
+
+}
+
+#endif // TIBIA_TEXTCACHE_HPP
@@ -0,0 +1,207 @@
+#ifndef TIBIA_TEXTUREATLAS_HPP
+#define TIBIA_TEXTUREATLAS_HPP
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+namespace tibia
+{
+
+// packs images into as few textures as possible using shelves sorted by height,
+// the region with the lowest id is always packed first at the top left of the first page
+// the page textures exist from construction so references to them stay valid across build()
+class TextureAtlas
+{
+
+public:
+
+    typedef std::shared_ptr<sf::Texture> TexturePtr;
+
+    static const unsigned int PAGE_SIZE_MAX = 4096;
+
+    static const int PAGES_MAX = 4;
+
+    struct Region
+    {
+        Region()
+        {
+            image = nullptr;
+
+            page = -1;
+        }
+
+        const sf::Image* image;
+
+        int page;
+
+        sf::IntRect rect;
+    };
+
+    TextureAtlas()
+    {
+        m_numPages = 0;
+
+        for (int i = 0; i < PAGES_MAX; i++)
+        {
+            m_pagesList.push_back(std::make_shared<sf::Texture>());
+        }
+    }
+
+    void add(int regionId, const sf::Image* image)
+    {
+        if (regionId >= static_cast<int>(m_regionsList.size()))
+        {
+            m_regionsList.resize(regionId + 1);
+        }
+
+        Region* region = &m_regionsList.at(regionId);
+        region->image = image;
+        region->page  = -1;
+    }
+
+    bool build()
+    {
+        unsigned int pageSize = std::min(sf::Texture::getMaximumSize(), PAGE_SIZE_MAX);
+
+        std::vector<Region*> regionsSorted;
+
+        for (auto& region : m_regionsList)
+        {
+            if (region.image == nullptr)
+            {
+                continue;
+            }
+
+            if (region.image->getSize().x > pageSize || region.image->getSize().y > pageSize)
+            {
+                return false;
+            }
+
+            regionsSorted.push_back(&region);
+        }
+
+        if (regionsSorted.size() == 0)
+        {
+            return false;
+        }
+
+        std::stable_sort
+        (
+            regionsSorted.begin() + 1,
+            regionsSorted.end(),
+            [](Region* a, Region* b)
+            {
+                return a->image->getSize().y > b->image->getSize().y;
+            }
+        );
+
+        std::vector<sf::Vector2u> pageSizesList;
+
+        unsigned int shelfX      = 0;
+        unsigned int shelfY      = 0;
+        unsigned int shelfHeight = 0;
+
+        for (auto region : regionsSorted)
+        {
+            sf::Vector2u imageSize = region->image->getSize();
+
+            if (pageSizesList.size() == 0)
+            {
+                pageSizesList.push_back(sf::Vector2u(0, 0));
+            }
+
+            if (shelfX + imageSize.x > pageSize)
+            {
+                shelfX = 0;
+                shelfY += shelfHeight;
+
+                shelfHeight = 0;
+            }
+
+            if (shelfY + imageSize.y > pageSize)
+            {
+                if (pageSizesList.size() == PAGES_MAX)
+                {
+                    return false;
+                }
+
+                pageSizesList.push_back(sf::Vector2u(0, 0));
+
+                shelfX = 0;
+                shelfY = 0;
+
+                shelfHeight = 0;
+            }
+
+            region->page = pageSizesList.size() - 1;
+            region->rect = sf::IntRect(shelfX, shelfY, imageSize.x, imageSize.y);
+
+            shelfX += imageSize.x;
+
+            shelfHeight = std::max(shelfHeight, imageSize.y);
+
+            sf::Vector2u* size = &pageSizesList.back();
+            size->x = std::max(size->x, shelfX);
+            size->y = std::max(size->y, shelfY + shelfHeight);
+        }
+
+        for (unsigned int i = 0; i < pageSizesList.size(); i++)
+        {
+            if (m_pagesList.at(i)->create(pageSizesList.at(i).x, pageSizesList.at(i).y) == false)
+            {
+                return false;
+            }
+        }
+
+        m_numPages = pageSizesList.size();
+
+        for (auto region : regionsSorted)
+        {
+            m_pagesList.at(region->page)->update(*region->image, region->rect.left, region->rect.top);
+        }
+
+        return true;
+    }
+
+    sf::Texture* getTexture(int regionId)
+    {
+        return m_pagesList.at(m_regionsList.at(regionId).page).get();
+    }
+
+    const sf::IntRect& getRect(int regionId)
+    {
+        return m_regionsList.at(regionId).rect;
+    }
+
+    void setSprite(sf::Sprite& sprite, int regionId)
+    {
+        sprite.setTexture(*getTexture(regionId));
+        sprite.setTextureRect(getRect(regionId));
+    }
+
+    sf::Texture* getPage(int page)
+    {
+        return m_pagesList.at(page).get();
+    }
+
+    int getNumPages()
+    {
+        return m_numPages;
+    }
+
+private:
+
+    std::vector<Region> m_regionsList;
+
+    std::vector<TexturePtr> m_pagesList;
+
+    int m_numPages;
+
+};
+
+}
+
+#endif // TIBIA_TEXTUREATLAS_HPP
@@ -11,11 +11,16 @@
 namespace tibia
 {
 
-class Thing : public tibia::DrawableAndTransformable
+class Thing : public tibia::DrawableAndTransformable, public std::enable_shared_from_this<tibia::Thing>
 {
 
 public:
 
+    Thing()
+    {
+        m_spatialCell = -1;
+    }
+
     struct sortByTileNumber
     {
         bool operator()(Thing* a, Thing* b) const
@@ -151,6 +156,16 @@ public:
         return m_box;
     }
 
+    int getSpatialCell()
+    {
+        return m_spatialCell;
+    }
+
+    void setSpatialCell(int cellIndex)
+    {
+        m_spatialCell = cellIndex;
+    }
+
 private:
 
     int m_tileX;
@@ -164,6 +179,8 @@ private:
 
     sf::FloatRect m_box;
 
+    int m_spatialCell;
+
 };
 
 }
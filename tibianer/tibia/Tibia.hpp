@@ -5,19 +5,23 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <cstdlib>
 #include <cmath>
+#include <algorithm>
 
 #include <SFML/Graphics.hpp>
 
 #include <Thor/Vectors/VectorAlgebra2D.hpp>
 
+#include "tibia/Random.hpp"
+#include "tibia/TextureAtlas.hpp"
+#include "tibia/BitmapFont.hpp"
+
 namespace tibia
 {
     const int SPRITES_TOTAL = 3374;
 
-    const int MAP_SIZE = 128;
-
-    const int TILE_NUMBER_MAX = (MAP_SIZE * MAP_SIZE) - 1;
+    const int MAP_SIZE = 128; // default, the actual size is read from the map file
 
     const int TILE_SIZE = 32;
 
@@ -29,9 +33,11 @@ namespace tibia
 
     const int NUM_TILES_TOTAL = NUM_TILES_X * NUM_TILES_Y;
 
-    const int MAP_XY_MAX = MAP_SIZE;
+    const int TILE_CHUNK_SIZE = 32;
 
-    const int MAP_TILE_XY_MAX = MAP_SIZE * TILE_SIZE;
+    const int TILE_CHUNKS_RESIDENT_MAX = 64; // per tile map, chunks in use are never evicted
+
+    const int TILE_CHUNKS_RESIDENT_RADIUS = 1; // chunks kept around the player
 
     const int TILES_WIDTH  = NUM_TILES_X * TILE_SIZE;
     const int TILES_HEIGHT = NUM_TILES_Y * TILE_SIZE;
@@ -44,27 +50,128 @@ namespace tibia
 
     const int VOLUME_MULTIPLIER = 8;
 
+    // sounds playing at once, the quietest is stopped to make room for a louder one
+    const int SOUND_VOICES_MAX = 32;
+
     const float TEXT_TIME = 5.0;
 
+    const float FLOATING_TEXT_TIME = 1.0;
+
+    const int FLOATING_TEXT_RISE = 16;
+
+    const int FLOATING_TEXTS_MAX = 256;
+
+    const int TICKS_PER_SECOND = 60;
+
+    const float TICK_TIME = 1.0f / TICKS_PER_SECOND;
+
+    const int TICKS_PER_FRAME_MAX = 8;
+
+    // bytes of transient data a frame can allocate before the frame arena spills to the heap and grows
+    const int FRAME_ARENA_SIZE = 1024 * 1024;
+
     const float DRAW_DISTANCE_MAX = 10.0;
 
+    // extra tiles culled around the view for sprites that are drawn up and left of their tile
+    const int VIEW_TILE_MARGIN = 2;
+
+    const float ZOOM_LEVEL_MAX = 16.0;
+
+    // zoomed out this far the floors are drawn from downsampled chunk textures instead of tile by tile
+    const float LOD_ZOOM_LEVEL = 4.0;
+
+    const int LOD_CHUNK_SIZE = 32; // in tiles
+
+    const int LOD_TILE_SIZE = 4; // in pixels
+
+    const int LOD_CHUNKS_MAX = 256;
+
+    const int LOD_CHUNK_BAKES_PER_FRAME = 4;
+
+    // creatures further than this from the player skip their per tick update until the warm set is rebuilt
+    const float CREATURES_WARM_DISTANCE = DRAW_DISTANCE_MAX + 6.0;
+
+    // the warm set is rebuilt every second or sooner once the player has moved this many tiles
+    const int CREATURES_WARM_REBUILD_DISTANCE = 3;
+
     const int CREATURES_MAX_LOAD = 256;
 
+    // clients of the server are sent the creatures on their floor this many tiles around their own
+    const int SERVER_INTEREST_DISTANCE = 12;
+
+    // commands from one client beyond this in one tick are dropped
+    const int SERVER_COMMANDS_PER_TICK_MAX = 4;
+
+    // size of the synthetic benchmark fixtures at scale 1, the map and creatures grow with the scale
+    const int BENCHMARK_MAP_SIZE        = 256; // in tiles
+    const int BENCHMARK_NUM_CREATURES   = 1000;
+    const int BENCHMARK_NUM_QUERIES     = 10000;
+    const int BENCHMARK_NUM_PROJECTILES = 200;
+
+    // frames drawn after the frame benchmark to check that a steady-state frame makes no heap allocations
+    const int BENCHMARK_NUM_FRAMES = 100;
+
+    // fixed so the fixtures are the same from one run to the next
+    const int BENCHMARK_RANDOM_SEED = 1;
+
+    // each benchmark is repeated until it has run for this long
+    const float BENCHMARK_TIME_MIN = 0.5;
+
     const int LIGHT_WIDTH  = 480;
     const int LIGHT_HEIGHT = 352;
 
+    // decoded by the asset loader and packed into Textures::atlas, then released
+    namespace Images
+    {
+        sf::Image sprites;
+
+        sf::Image font;
+        sf::Image font2;
+
+        sf::Image light;
+        sf::Image light2;
+        sf::Image light3;
+        sf::Image light4;
+        sf::Image light5;
+    }
+
+    namespace TextureAtlasRegions
+    {
+        enum
+        {
+            sprites,
+
+            font,
+            font2,
+
+            light,
+            light2,
+            light3,
+            light4,
+            light5,
+        };
+    }
+
     namespace Textures
     {
-        sf::Texture sprites;
+        tibia::TextureAtlas atlas;
 
-        sf::Texture font;
-        sf::Texture font2;
+        // sprites have the lowest region id so they are always on the first page
+        sf::Texture& sprites = *atlas.getPage(0);
+    }
 
-        sf::Texture light;
-        sf::Texture light2;
-        sf::Texture light3;
-        sf::Texture light4;
-        sf::Texture light5;
+    namespace BitmapFontData
+    {
+        const sf::Vector2i characterSize(8, 16);
+
+        const int firstCharacter = 32;
+    }
+
+    // glyph tables into the font regions of Textures::atlas, loaded once the atlas is built
+    namespace BitmapFonts
+    {
+        tibia::BitmapFont font;
+        tibia::BitmapFont font2;
     }
 
     namespace Fonts
@@ -185,6 +292,14 @@ namespace tibia
 
     std::unordered_map<int, int> spriteFlags; // <int id, int flags>
 
+    sf::IntRect spriteRects[SPRITES_TOTAL + 1]; // texture rect in Textures::sprites by sprite id
+
+    namespace MapSize
+    {
+        int width  = MAP_SIZE; // in tiles
+        int height = MAP_SIZE;
+    }
+
     namespace SpriteData
     {
         const int guiTextIcons[] = {529, 530, 531, 532, 533, 534};
@@ -674,7 +789,9 @@ namespace tibia
             skeleton,
             spider,
             witch,
-            zombie
+            zombie,
+
+            numTypes
         };
     }
 
@@ -784,6 +901,29 @@ namespace tibia
         const float decal   = 60.0;
     }
 
+    namespace TimerTypes
+    {
+        enum
+        {
+            corpseDecay,
+            animationFrame,
+            movementReady,
+            gameTextExpiry,
+        };
+    }
+
+    // the list a thing referenced from a snapshot belongs to
+    namespace SnapshotLists
+    {
+        enum
+        {
+            none,
+            creatures,
+            animations,
+            animatedDecals,
+        };
+    }
+
     namespace Projectiles
     {
         int spellBlue  = 1829;
@@ -811,7 +951,9 @@ namespace tibia
             bolt,
             arrow,
             arrowFire,
-            arrowPoison
+            arrowPoison,
+
+            numTypes
         };
     }
 
@@ -822,7 +964,7 @@ namespace tibia
 
     namespace ProjectileSpeeds
     {
-        const float default = 8.0;
+        const float default = 480.0; // pixels per second
     }
 
     namespace ProjectileDamages
@@ -903,7 +1045,9 @@ namespace tibia
             tiles,
             edges,
             walls,
-            objects
+            objects,
+
+            numTypes
         };
     }
 
@@ -925,16 +1069,35 @@ namespace tibia
         };
     }
 
+    namespace CreatureDirtyFlags
+    {
+        enum
+        {
+            position  = 1 << 0,
+            direction = 1 << 1,
+            outfit    = 1 << 2,
+            death     = 1 << 3,
+
+            all = position | direction | outfit | death
+        };
+    }
+
+    // owned by the game's sound bank, nullptr when the bank has no such sound
     namespace Sounds
     {
-        sf::SoundBuffer death;
+        std::string bank = "sounds/sounds.bank";
+
+        sf::SoundBuffer* death = nullptr;
 
-        sf::SoundBuffer arrowBlock;
+        sf::SoundBuffer* arrowBlock = nullptr;
     }
 
     float calculateDistance(float x1, float y1, float x2, float y2)
     {
-        return sqrt(pow(x1 - x2, 2) + pow(y1 - y2, 2));
+        float dx = x1 - x2;
+        float dy = y1 - y2;
+
+        return std::sqrt((dx * dx) + (dy * dy));
     }
 
     int calculateDistanceByTile(int x1, int y1, int x2, int y2)
@@ -956,19 +1119,51 @@ namespace tibia
         return volume;
     }
 
+    tibia::Random randomDefault;
+
+    thread_local tibia::Random* randomCurrent = &randomDefault;
+
+    void setRandom(tibia::Random* random)
+    {
+        randomCurrent = (random != nullptr) ? random : &randomDefault;
+    }
+
+    tibia::Random* getRandom()
+    {
+        return randomCurrent;
+    }
+
     int getRandomNumber(int low, int high)
     {
-        return std::rand() % ((high - low) + 1) + low;
+        return randomCurrent->getNumber(low, high);
     }
 
     sf::IntRect getSpriteRectById(int id)
     {
-        id = id - 1;
+        if (id < 0 || id > tibia::SPRITES_TOTAL)
+        {
+            return tibia::spriteRects[0];
+        }
+
+        return tibia::spriteRects[id];
+    }
+
+    // sprite ids start at 1, id 0 is the top left sprite like tibia::Sprite uses by default
+    void loadSpriteRects()
+    {
+        sf::IntRect spritesRect = tibia::Textures::atlas.getRect(tibia::TextureAtlasRegions::sprites);
+
+        int numColumns = spritesRect.width / tibia::TILE_SIZE;
 
-        int u = (id % (tibia::Textures::sprites.getSize().x / tibia::TILE_SIZE)) * tibia::TILE_SIZE;
-        int v = (id / (tibia::Textures::sprites.getSize().y / tibia::TILE_SIZE)) * tibia::TILE_SIZE;
+        tibia::spriteRects[0] = sf::IntRect(spritesRect.left, spritesRect.top, tibia::TILE_SIZE, tibia::TILE_SIZE);
 
-        return sf::IntRect(u, v, tibia::TILE_SIZE, tibia::TILE_SIZE);
+        for (int i = 1; i < tibia::SPRITES_TOTAL + 1; i++)
+        {
+            int u = spritesRect.left + (((i - 1) % numColumns) * tibia::TILE_SIZE);
+            int v = spritesRect.top  + (((i - 1) / numColumns) * tibia::TILE_SIZE);
+
+            tibia::spriteRects[i] = sf::IntRect(u, v, tibia::TILE_SIZE, tibia::TILE_SIZE);
+        }
     }
 
     int getTileNumberByTileCoords(int x, int y)
@@ -979,18 +1174,46 @@ namespace tibia
         tileX = tileX - (tileX % tibia::TILE_SIZE);
         tileY = tileY - (tileY % tibia::TILE_SIZE);
 
-        return (tileX + tileY * tibia::MAP_SIZE) / tibia::TILE_SIZE;
+        return (tileX + tileY * tibia::MapSize::width) / tibia::TILE_SIZE;
     }
 
     sf::Vector2u getTileCoordsByTileNumber(int tileNumber)
     {
         return sf::Vector2u
         (
-            (tileNumber % tibia::MAP_SIZE) * tibia::TILE_SIZE,
-            (tileNumber / tibia::MAP_SIZE) * tibia::TILE_SIZE
+            (tileNumber % tibia::MapSize::width) * tibia::TILE_SIZE,
+            (tileNumber / tibia::MapSize::width) * tibia::TILE_SIZE
         );
     }
 
+    // at least one tick so a timer never fires on the tick it was scheduled
+    unsigned int getTicksByTime(float time)
+    {
+        int ticks = static_cast<int>(std::ceil(time * tibia::TICKS_PER_SECOND - 0.001f));
+
+        if (ticks < 1)
+        {
+            ticks = 1;
+        }
+
+        return ticks;
+    }
+
+    int getTileNumberMax()
+    {
+        return (tibia::MapSize::width * tibia::MapSize::height) - 1;
+    }
+
+    int getMapTileWidth()
+    {
+        return tibia::MapSize::width * tibia::TILE_SIZE;
+    }
+
+    int getMapTileHeight()
+    {
+        return tibia::MapSize::height * tibia::TILE_SIZE;
+    }
+
     int roundUp(int number, int multiple) 
     { 
         if (multiple == 0)
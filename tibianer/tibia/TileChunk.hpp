@@ -0,0 +1,434 @@
+#ifndef TIBIA_TILECHUNK_HPP
+#define TIBIA_TILECHUNK_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+
+#include "tibia/Tibia.hpp"
+#include "tibia/Tile.hpp"
+#include "tibia/BinaryStream.hpp"
+
+namespace tibia
+{
+
+struct TileChunk
+{
+    int x;
+    int y;
+
+    std::vector<tibia::Tile> tiles;
+
+    std::vector<int> waterTileIndexes;
+
+    unsigned int lastUsed;
+
+    bool isModified;
+};
+
+// map layers cut into TILE_CHUNK_SIZE x TILE_CHUNK_SIZE chunks, each chunk zlib compressed
+// layout: header, layer table, chunk data, then one chunk table per layer.
+// the header holds a hash of the map file the chunks were cut from, a file made from other contents is stale
+class TileChunkFile
+{
+
+public:
+
+    static const std::uint32_t FILE_MAGIC   = 0x43424954; // "TIBC"
+    static const std::uint32_t FILE_VERSION = 2;
+
+    static const int HEADER_SIZE = 32;
+
+    static const int LAYER_ENTRY_SIZE = 12;
+    static const int CHUNK_ENTRY_SIZE = 12;
+
+    struct Layer
+    {
+        bool isEmpty;
+
+        std::uint64_t chunkTableOffset;
+    };
+
+    TileChunkFile()
+    {
+        m_width  = 0;
+        m_height = 0;
+
+        m_numChunksX = 0;
+        m_numChunksY = 0;
+    }
+
+    bool open(std::string filename, std::uint64_t sourceHash)
+    {
+        m_file.close();
+        m_file.clear();
+
+        m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (m_file.is_open() == false)
+        {
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(m_file) != FILE_MAGIC)
+        {
+            m_file.close();
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint32(m_file) != FILE_VERSION)
+        {
+            m_file.close();
+            return false;
+        }
+
+        if (tibia::BinaryStream::readUint64(m_file) != sourceHash)
+        {
+            m_file.close();
+            return false;
+        }
+
+        m_width  = tibia::BinaryStream::readUint32(m_file);
+        m_height = tibia::BinaryStream::readUint32(m_file);
+
+        if (static_cast<int>(tibia::BinaryStream::readUint32(m_file)) != tibia::TILE_CHUNK_SIZE)
+        {
+            m_file.close();
+            return false;
+        }
+
+        int numLayers = tibia::BinaryStream::readUint32(m_file);
+
+        calculateNumChunks();
+
+        m_layersList.clear();
+
+        for (int i = 0; i < numLayers; i++)
+        {
+            Layer layer;
+            layer.isEmpty          = (tibia::BinaryStream::readUint32(m_file) != 0);
+            layer.chunkTableOffset = tibia::BinaryStream::readUint64(m_file);
+
+            m_layersList.push_back(layer);
+        }
+
+        return m_file.good();
+    }
+
+    // written to a temporary file that only replaces the chunk file once endWrite succeeds,
+    // so a write cut short never leaves a chunk file behind that open() would accept
+    bool beginWrite(std::string filename, std::uint64_t sourceHash, int width, int height, int numLayers)
+    {
+        m_writeFilename = filename;
+
+        m_writeFile.open(getWriteTempFilename().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if (m_writeFile.is_open() == false)
+        {
+            return false;
+        }
+
+        m_width  = width;
+        m_height = height;
+
+        calculateNumChunks();
+
+        tibia::BinaryStream::writeUint32(m_writeFile, FILE_MAGIC);
+        tibia::BinaryStream::writeUint32(m_writeFile, FILE_VERSION);
+        tibia::BinaryStream::writeUint64(m_writeFile, sourceHash);
+        tibia::BinaryStream::writeUint32(m_writeFile, m_width);
+        tibia::BinaryStream::writeUint32(m_writeFile, m_height);
+        tibia::BinaryStream::writeUint32(m_writeFile, tibia::TILE_CHUNK_SIZE);
+        tibia::BinaryStream::writeUint32(m_writeFile, numLayers);
+
+        m_layersList.clear();
+        m_layersList.resize(numLayers);
+
+        // patched by endWrite()
+        for (int i = 0; i < numLayers; i++)
+        {
+            tibia::BinaryStream::writeUint32(m_writeFile, 0);
+            tibia::BinaryStream::writeUint64(m_writeFile, 0);
+        }
+
+        return true;
+    }
+
+    // tiles holds one full layer in row-major order, width * height ids
+    void writeLayer(int layerIndex, const std::vector<int>& tiles)
+    {
+        std::vector<std::uint64_t> chunkOffsets(m_numChunksX * m_numChunksY, 0);
+        std::vector<std::uint32_t> chunkSizes  (m_numChunksX * m_numChunksY, 0);
+
+        bool layerIsEmpty = true;
+
+        std::string chunkData;
+        chunkData.reserve(tibia::TILE_CHUNK_SIZE * tibia::TILE_CHUNK_SIZE * 4);
+
+        for (int chunkY = 0; chunkY < m_numChunksY; chunkY++)
+        {
+            for (int chunkX = 0; chunkX < m_numChunksX; chunkX++)
+            {
+                chunkData.clear();
+
+                bool chunkIsEmpty = true;
+
+                for (int j = 0; j < tibia::TILE_CHUNK_SIZE; j++)
+                {
+                    for (int i = 0; i < tibia::TILE_CHUNK_SIZE; i++)
+                    {
+                        int x = (chunkX * tibia::TILE_CHUNK_SIZE) + i;
+                        int y = (chunkY * tibia::TILE_CHUNK_SIZE) + j;
+
+                        int tileId = tibia::TILE_NULL;
+
+                        if (x < m_width && y < m_height)
+                        {
+                            std::size_t tileIndex = static_cast<std::size_t>(x) + (static_cast<std::size_t>(y) * m_width);
+
+                            if (tileIndex < tiles.size())
+                            {
+                                tileId = tiles.at(tileIndex);
+                            }
+                        }
+
+                        if (tileId != tibia::TILE_NULL)
+                        {
+                            chunkIsEmpty = false;
+                        }
+
+                        for (int b = 0; b < 4; b++)
+                        {
+                            chunkData.push_back(static_cast<char>((static_cast<std::uint32_t>(tileId) >> (b * 8)) & 0xFF));
+                        }
+                    }
+                }
+
+                if (chunkIsEmpty == true)
+                {
+                    continue;
+                }
+
+                layerIsEmpty = false;
+
+                std::string chunkDataCompressed = compress(chunkData);
+
+                int chunkIndex = chunkX + (chunkY * m_numChunksX);
+
+                chunkOffsets.at(chunkIndex) = static_cast<std::uint64_t>(m_writeFile.tellp());
+                chunkSizes.at(chunkIndex)   = static_cast<std::uint32_t>(chunkDataCompressed.size());
+
+                m_writeFile.write(chunkDataCompressed.data(), chunkDataCompressed.size());
+            }
+        }
+
+        m_layersList.at(layerIndex).isEmpty          = layerIsEmpty;
+        m_layersList.at(layerIndex).chunkTableOffset = static_cast<std::uint64_t>(m_writeFile.tellp());
+
+        for (unsigned int i = 0; i < chunkOffsets.size(); i++)
+        {
+            tibia::BinaryStream::writeUint64(m_writeFile, chunkOffsets.at(i));
+            tibia::BinaryStream::writeUint32(m_writeFile, chunkSizes.at(i));
+        }
+    }
+
+    bool endWrite()
+    {
+        m_writeFile.seekp(HEADER_SIZE);
+
+        for (auto& layer : m_layersList)
+        {
+            tibia::BinaryStream::writeUint32(m_writeFile, layer.isEmpty ? 1 : 0);
+            tibia::BinaryStream::writeUint64(m_writeFile, layer.chunkTableOffset);
+        }
+
+        m_writeFile.flush();
+
+        bool isGood = m_writeFile.good();
+
+        m_writeFile.close();
+
+        if (isGood == false || m_writeFile.fail() == true)
+        {
+            std::remove(getWriteTempFilename().c_str());
+
+            return false;
+        }
+
+        // rename does not replace an existing file everywhere
+        std::remove(m_writeFilename.c_str());
+
+        return std::rename(getWriteTempFilename().c_str(), m_writeFilename.c_str()) == 0;
+    }
+
+    // returns false for chunks that were never stored because every tile is null
+    bool readChunk(int layerIndex, int chunkX, int chunkY, std::vector<int>& tileIds)
+    {
+        if (layerIndex < 0 || layerIndex >= static_cast<int>(m_layersList.size()))
+        {
+            return false;
+        }
+
+        if (chunkX < 0 || chunkY < 0 || chunkX >= m_numChunksX || chunkY >= m_numChunksY)
+        {
+            return false;
+        }
+
+        Layer* layer = &m_layersList.at(layerIndex);
+
+        if (layer->isEmpty == true)
+        {
+            return false;
+        }
+
+        std::uint64_t chunkIndex = static_cast<std::uint64_t>(chunkX) + (static_cast<std::uint64_t>(chunkY) * m_numChunksX);
+
+        m_file.clear();
+        m_file.seekg(layer->chunkTableOffset + (chunkIndex * CHUNK_ENTRY_SIZE));
+
+        std::uint64_t chunkOffset = tibia::BinaryStream::readUint64(m_file);
+        std::uint32_t chunkSize   = tibia::BinaryStream::readUint32(m_file);
+
+        if (chunkSize == 0)
+        {
+            return false;
+        }
+
+        std::string chunkDataCompressed(chunkSize, '\0');
+
+        m_file.seekg(chunkOffset);
+        m_file.read(&chunkDataCompressed[0], chunkSize);
+
+        if (m_file.fail() == true)
+        {
+            return false;
+        }
+
+        std::string chunkData = decompress(chunkDataCompressed);
+
+        int numTiles = tibia::TILE_CHUNK_SIZE * tibia::TILE_CHUNK_SIZE;
+
+        if (static_cast<int>(chunkData.size()) != numTiles * 4)
+        {
+            return false;
+        }
+
+        tileIds.resize(numTiles);
+
+        for (int i = 0; i < numTiles; i++)
+        {
+            std::uint32_t tileId = 0;
+
+            for (int b = 0; b < 4; b++)
+            {
+                tileId |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(chunkData[(i * 4) + b])) << (b * 8);
+            }
+
+            tileIds.at(i) = static_cast<int>(tileId);
+        }
+
+        return true;
+    }
+
+    bool isLayerEmpty(int layerIndex)
+    {
+        if (layerIndex < 0 || layerIndex >= static_cast<int>(m_layersList.size()))
+        {
+            return true;
+        }
+
+        return m_layersList.at(layerIndex).isEmpty;
+    }
+
+    int getNumLayers()
+    {
+        return m_layersList.size();
+    }
+
+    int getWidth()
+    {
+        return m_width;
+    }
+
+    int getHeight()
+    {
+        return m_height;
+    }
+
+    int getNumChunksX()
+    {
+        return m_numChunksX;
+    }
+
+    int getNumChunksY()
+    {
+        return m_numChunksY;
+    }
+
+private:
+
+    std::string getWriteTempFilename()
+    {
+        return m_writeFilename + ".tmp";
+    }
+
+    void calculateNumChunks()
+    {
+        m_numChunksX = (m_width  + tibia::TILE_CHUNK_SIZE - 1) / tibia::TILE_CHUNK_SIZE;
+        m_numChunksY = (m_height + tibia::TILE_CHUNK_SIZE - 1) / tibia::TILE_CHUNK_SIZE;
+    }
+
+    static std::string compress(const std::string& data)
+    {
+        std::istringstream source(data);
+        std::ostringstream destination;
+
+        boost::iostreams::filtering_streambuf<boost::iostreams::input> stream;
+        stream.push(boost::iostreams::zlib_compressor());
+        stream.push(source);
+
+        boost::iostreams::copy(stream, destination);
+
+        return destination.str();
+    }
+
+    static std::string decompress(const std::string& data)
+    {
+        std::istringstream source(data);
+        std::ostringstream destination;
+
+        boost::iostreams::filtering_streambuf<boost::iostreams::input> stream;
+        stream.push(boost::iostreams::zlib_decompressor());
+        stream.push(source);
+
+        boost::iostreams::copy(stream, destination);
+
+        return destination.str();
+    }
+
+    int m_width;
+    int m_height;
+
+    int m_numChunksX;
+    int m_numChunksY;
+
+    std::vector<Layer> m_layersList;
+
+    std::ifstream m_file;
+
+    std::ofstream m_writeFile;
+
+    std::string m_writeFilename;
+
+};
+
+}
+
+#endif // TIBIA_TILECHUNK_HPP
@@ -3,38 +3,66 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <iterator>
 #include <memory>
+#include <unordered_map>
+#include <istream>
+#include <ostream>
 
 #include <SFML/Graphics.hpp>
 
 #include "tibia/Tibia.hpp"
 #include "tibia/Tile.hpp"
+#include "tibia/TileChunk.hpp"
+#include "tibia/BinaryStream.hpp"
 #include "tibia/Sprite.hpp"
+#include "tibia/FrameArena.hpp"
+#include "tibia/MemoryTracker.hpp"
 
 namespace tibia
 {
 
+// tiles live in chunks that are read from the chunk file on first access
+// and evicted least recently used first once more than TILE_CHUNKS_RESIDENT_MAX are loaded
 class TileMap
 {
 
 public:
 
-    typedef std::shared_ptr<tibia::Tile> TilePtr;
-    typedef std::vector<TilePtr> TileList;
+    typedef std::shared_ptr<tibia::TileChunk> TileChunkPtr;
+    typedef std::unordered_map<int, TileChunkPtr> TileChunkList;
 
-    struct sortTilesByTileNumber
+    struct SnapshotChunk
     {
-        bool operator()(TilePtr a, TilePtr b) const
-        {
-            return (a->getNumber() < b->getNumber());
-        }
+        int x;
+        int y;
+
+        std::vector<int> tileIds;
+        std::vector<int> tileFlags;
     };
 
-    void load(std::vector<int> tiles, std::string name, int type, int z)
+    typedef std::vector<SnapshotChunk> SnapshotChunkList;
+
+    TileMap()
+    {
+        m_chunkFile = nullptr;
+
+        m_layerIndex = -1;
+
+        m_isEmpty = true;
+
+        m_generation = 0;
+
+        m_lastChunk      = nullptr;
+        m_lastChunkIndex = -1;
+    }
+
+    void load(tibia::TileChunkFile* chunkFile, int layerIndex, std::string name, int type, int z)
     {
-        //m_tiles = tiles;
-        m_tiles.swap(tiles);
+        m_chunkFile = chunkFile;
+
+        m_layerIndex = layerIndex;
 
         m_name = name;
 
@@ -42,142 +70,323 @@ public:
 
         m_z = z;
 
-        for (unsigned int i = 0; i < tibia::MAP_SIZE; ++i)
+        m_isEmpty = m_chunkFile->isLayerEmpty(m_layerIndex);
+
+        m_chunksList.clear();
+
+        m_lastChunk      = nullptr;
+        m_lastChunkIndex = -1;
+    }
+
+    tibia::Tile* getTile(int tileNumber)
+    {
+        if (tileNumber < 0 || tileNumber > tibia::getTileNumberMax())
+        {
+            return nullptr;
+        }
+
+        int x = tileNumber % tibia::MapSize::width;
+        int y = tileNumber / tibia::MapSize::width;
+
+        tibia::TileChunk* chunk = getChunk(x / tibia::TILE_CHUNK_SIZE, y / tibia::TILE_CHUNK_SIZE);
+
+        if (chunk == nullptr)
+        {
+            return nullptr;
+        }
+
+        return &chunk->tiles[(x % tibia::TILE_CHUNK_SIZE) + ((y % tibia::TILE_CHUNK_SIZE) * tibia::TILE_CHUNK_SIZE)];
+    }
+
+    int getTileId(int tileNumber)
+    {
+        tibia::Tile* tile = getTile(tileNumber);
+
+        if (tile == nullptr)
+        {
+            return tibia::TILE_NULL;
+        }
+
+        return tile->getId();
+    }
+
+    void updateTileId(int tileNumber, int tileId)
+    {
+        tibia::Tile* tile = getTile(tileNumber);
+
+        if (tile == nullptr)
+        {
+            return;
+        }
+
+        tile->setId(tileId);
+
+        // modified chunks stay resident so the change is not lost on eviction
+        m_lastChunk->isModified = true;
+    }
+
+    void updateTileFlags(int tileNumber, int tileId)
+    {
+        tibia::Tile* tile = getTile(tileNumber);
+
+        if (tile == nullptr)
+        {
+            return;
+        }
+
+        tile->setFlags(tibia::spriteFlags[tileId]);
+
+        m_lastChunk->isModified = true;
+    }
+
+    // only modified chunks are written, everything else is read back from the chunk file
+    void writeSnapshot(std::ostream& stream)
+    {
+        int numChunks = 0;
+
+        for (auto& chunksList_it : m_chunksList)
+        {
+            if (chunksList_it.second->isModified == true)
+            {
+                numChunks++;
+            }
+        }
+
+        tibia::BinaryStream::writeVarUint(stream, numChunks);
+
+        for (auto& chunksList_it : m_chunksList)
         {
-            for (unsigned int j = 0; j < tibia::MAP_SIZE; ++j)
+            tibia::TileChunk* chunk = chunksList_it.second.get();
+
+            if (chunk->isModified == false)
             {
-                int tileNumber = i + j * tibia::MAP_SIZE;
+                continue;
+            }
 
-                int tileId = m_tiles.at(tileNumber);
+            tibia::BinaryStream::writeVarUint(stream, chunk->x);
+            tibia::BinaryStream::writeVarUint(stream, chunk->y);
 
-                sf::Vector2u tilePosition
-                (
-                    i * tibia::TILE_SIZE,
-                    j * tibia::TILE_SIZE
-                );
+            for (auto& tile : chunk->tiles)
+            {
+                tibia::BinaryStream::writeVarUint(stream, tile.getId());
+                tibia::BinaryStream::writeVarUint(stream, static_cast<unsigned int>(tile.getFlags()));
+            }
+        }
+    }
 
-                int tileFlags = tibia::spriteFlags[tileId];
+    // read completely before any chunk is changed, so a snapshot that fails to read changes nothing
+    bool readSnapshot(std::istream& stream, SnapshotChunkList& snapshotChunksList)
+    {
+        snapshotChunksList.clear();
 
-                if (tileFlags & tibia::TileFlags::water && m_type == tibia::TileMapTypes::tiles && m_z == tibia::ZAxis::ground)
-                {
-                    m_waterTileNumbers.push_back(tileNumber);
-                }
+        int numChunks = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
 
-                int tileOffset = 0;
+        for (int i = 0; i < numChunks && stream.fail() == false; i++)
+        {
+            SnapshotChunk snapshotChunk;
+            snapshotChunk.x = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+            snapshotChunk.y = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
 
-                if (tileFlags & tibia::TileFlags::offset)
-                {
-                    tileOffset = tibia::TILE_DRAW_OFFSET;
-                }
+            if (m_chunkFile == nullptr || snapshotChunk.x >= m_chunkFile->getNumChunksX() || snapshotChunk.y >= m_chunkFile->getNumChunksY())
+            {
+                return false;
+            }
 
-                if (tileId == tibia::TILE_NULL && m_type == tibia::TileMapTypes::tiles)
-                {
-                    tileFlags |= tibia::TileFlags::null;
-                }
+            snapshotChunk.tileIds.resize(tibia::TILE_CHUNK_SIZE * tibia::TILE_CHUNK_SIZE);
+            snapshotChunk.tileFlags.resize(tibia::TILE_CHUNK_SIZE * tibia::TILE_CHUNK_SIZE);
 
-                TilePtr tile = std::make_shared<tibia::Tile>();
-                tile->setNumber(tileNumber);
-                tile->setId(tileId);
-                tile->setOffset(tileOffset);
-                tile->setPosition(tilePosition);
-                tile->setFlags(tileFlags);
-                m_tilesList.push_back(tile);
+            for (unsigned int j = 0; j < snapshotChunk.tileIds.size(); j++)
+            {
+                snapshotChunk.tileIds[j]   = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
+                snapshotChunk.tileFlags[j] = static_cast<int>(tibia::BinaryStream::readVarUint(stream));
             }
+
+            snapshotChunksList.push_back(snapshotChunk);
         }
 
-        std::sort(m_tilesList.begin(), m_tilesList.end(), sortTilesByTileNumber());
+        return stream.fail() == false;
     }
 
-    void updateTileId(int tileNumber, int tileId)
+    // chunks changed since the snapshot was saved are read back from the chunk file first,
+    // since a snapshot only holds the chunks that were modified when it was saved
+    void applySnapshot(const SnapshotChunkList& snapshotChunksList)
     {
-        m_tiles.at(tileNumber) = tileId;
+        resetModifiedChunks();
+
+        for (auto& snapshotChunk : snapshotChunksList)
+        {
+            tibia::TileChunk* chunk = getChunk(snapshotChunk.x, snapshotChunk.y);
+
+            if (chunk == nullptr)
+            {
+                continue;
+            }
+
+            for (unsigned int i = 0; i < chunk->tiles.size(); i++)
+            {
+                chunk->tiles[i].setId(snapshotChunk.tileIds[i]);
+                chunk->tiles[i].setFlags(snapshotChunk.tileFlags[i]);
+            }
 
-        m_tilesList.at(tileNumber)->setId(tileId);
+            chunk->isModified = true;
+        }
     }
 
-    void updateTileFlags(int tileNumber, int tileId)
+    // modified chunks are dropped and read back from the chunk file the next time they are used
+    void resetModifiedChunks()
     {
-        int tileFlags = tibia::spriteFlags[tileId];
+        for (auto chunksList_it = m_chunksList.begin(); chunksList_it != m_chunksList.end(); )
+        {
+            if (chunksList_it->second->isModified == true)
+            {
+                chunksList_it = m_chunksList.erase(chunksList_it);
+            }
+            else
+            {
+                chunksList_it++;
+            }
+        }
+
+        m_lastChunk      = nullptr;
+        m_lastChunkIndex = -1;
+    }
 
-        m_tilesList.at(tileNumber)->setFlags(tileFlags);
+    bool isEmpty()
+    {
+        return m_isEmpty;
     }
 
-    std::vector<int>* getTiles()
+    TileChunkList* getChunksList()
     {
-        return &m_tiles;
+        return &m_chunksList;
     }
 
-    TileList* getTilesList()
+    int getNumChunksLoaded()
     {
-        return &m_tilesList;
+        return m_chunksList.size();
     }
 
-    std::vector<int>* getWaterTileNumbers()
+    // starts a new residency pass, chunks not touched since the previous pass may be evicted
+    void beginChunkResidency()
     {
-        return &m_waterTileNumbers;
+        m_generation++;
     }
 
-    void loadWaterTileNumbers()
+    void touchChunks(int tileX, int tileY, int radius)
     {
-        m_waterTileNumbers.clear();
+        if (m_isEmpty == true)
+        {
+            return;
+        }
 
-        for (auto tile : m_tilesList)
+        int chunkX = tileX / tibia::TILE_CHUNK_SIZE;
+        int chunkY = tileY / tibia::TILE_CHUNK_SIZE;
+
+        for (int i = chunkX - radius; i <= chunkX + radius; i++)
         {
-            if (tile->getFlags() & tibia::TileFlags::water)
+            for (int j = chunkY - radius; j <= chunkY + radius; j++)
             {
-                m_waterTileNumbers.push_back(tile->getNumber());
+                getChunk(i, j);
             }
         }
     }
 
-    void doAnimatedWater()
+    void evictChunks()
     {
-        //std::cout << "m_waterTileNumbers size: " << m_waterTileNumbers.size() << std::endl;
-
-        for (auto waterTileNumber : m_waterTileNumbers)
+        while (m_chunksList.size() > static_cast<unsigned int>(tibia::TILE_CHUNKS_RESIDENT_MAX))
         {
-            int tileId = m_tiles.at(waterTileNumber);
+            auto evictChunk_it = m_chunksList.end();
 
-            if (tileId >= tibia::SpriteData::waterBegin && tileId <= tibia::SpriteData::waterEnd)
+            for (auto chunksList_it = m_chunksList.begin(); chunksList_it != m_chunksList.end(); chunksList_it++)
             {
-                if (tileId == tibia::SpriteData::water[3])
-                {
-                    tileId = tibia::SpriteData::water[0];
-                }
-                else if (tileId == tibia::SpriteData::water[7])
+                tibia::TileChunk* chunk = chunksList_it->second.get();
+
+                if (chunk->isModified == true || chunk->lastUsed >= m_generation)
                 {
-                    tileId = tibia::SpriteData::water[4];
+                    continue;
                 }
-                else
+
+                if (evictChunk_it == m_chunksList.end() || chunk->lastUsed < evictChunk_it->second->lastUsed)
                 {
-                    tileId++;
+                    evictChunk_it = chunksList_it;
                 }
+            }
 
-                updateTileId(waterTileNumber, tileId);
+            if (evictChunk_it == m_chunksList.end())
+            {
+                break;
             }
+
+            if (evictChunk_it->second.get() == m_lastChunk)
+            {
+                m_lastChunk      = nullptr;
+                m_lastChunkIndex = -1;
+            }
+
+            m_chunksList.erase(evictChunk_it);
         }
     }
 
-    void addMiniMapTiles(std::vector<sf::Vertex> &verticesList)
+    // only chunks that are loaded are animated, a reloaded chunk starts over from the map file
+    void doAnimatedWater()
     {
-        for (unsigned int i = 0; i < tibia::MAP_SIZE; ++i)
+        for (auto& chunksList_pair : m_chunksList)
         {
-            for (unsigned int j = 0; j < tibia::MAP_SIZE; ++j)
+            tibia::TileChunk* chunk = chunksList_pair.second.get();
+
+            for (auto waterTileIndex : chunk->waterTileIndexes)
             {
-                int tileNumber = i + j * tibia::MAP_SIZE;
+                tibia::Tile* tile = &chunk->tiles[waterTileIndex];
+
+                int tileId = tile->getId();
 
-                if (tileNumber < 0 || tileNumber > tibia::TILE_NUMBER_MAX)
+                if (tileId >= tibia::SpriteData::waterBegin && tileId <= tibia::SpriteData::waterEnd)
                 {
-                    continue;
+                    if (tileId == tibia::SpriteData::water[3])
+                    {
+                        tileId = tibia::SpriteData::water[0];
+                    }
+                    else if (tileId == tibia::SpriteData::water[7])
+                    {
+                        tileId = tibia::SpriteData::water[4];
+                    }
+                    else
+                    {
+                        tileId++;
+                    }
+
+                    tile->setId(tileId);
                 }
+            }
+        }
+    }
+
+    void addMiniMapTiles(tibia::FrameVector<sf::Vertex> &verticesList, sf::IntRect tileRect)
+    {
+        if (m_isEmpty == true)
+        {
+            return;
+        }
+
+        int x1 = std::max(tileRect.left, 0);
+        int y1 = std::max(tileRect.top,  0);
+
+        int x2 = std::min(tileRect.left + tileRect.width,  tibia::MapSize::width);
+        int y2 = std::min(tileRect.top  + tileRect.height, tibia::MapSize::height);
 
-                if (m_tilesList.size() == 0 || m_tilesList.size() < tileNumber)
+        for (int i = x1; i < x2; ++i)
+        {
+            for (int j = y1; j < y2; ++j)
+            {
+                int tileNumber = i + j * tibia::MapSize::width;
+
+                tibia::Tile* tile = getTile(tileNumber);
+
+                if (tile == nullptr)
                 {
                     continue;
                 }
 
-                tibia::Tile* tile = m_tilesList.at(tileNumber).get();
-
                 int tileId = tile->getId();
 
                 if (tileId == tibia::TILE_NULL || tileId == 1)
@@ -232,26 +441,13 @@ public:
         }
     }
 
-    sf::Vector2u getTileCoordsByTileNumber(int tileNumber)
-    {
-        int tileId = m_tiles.at(tileNumber) - 1;
-
-        //tileId = tileId - 1;
-
-        return sf::Vector2u
-        (
-            tileId % (tibia::Textures::sprites.getSize().x / tibia::TILE_SIZE),
-            tileId / (tibia::Textures::sprites.getSize().x / tibia::TILE_SIZE)
-        );
-    }
-
     template <class T>
     int getTileNumberByTileCoords(T tileCoords)
     {
         int x = tileCoords.x / tibia::TILE_SIZE;
         int y = tileCoords.y / tibia::TILE_SIZE;
 
-        return x + (y * tibia::MAP_SIZE);
+        return x + (y * tibia::MapSize::width);
     }
 
     std::string getName()
@@ -286,17 +482,128 @@ public:
 
 private:
 
+    tibia::TileChunk* getChunk(int chunkX, int chunkY)
+    {
+        if (m_chunkFile == nullptr)
+        {
+            return nullptr;
+        }
+
+        if (chunkX < 0 || chunkY < 0 || chunkX >= m_chunkFile->getNumChunksX() || chunkY >= m_chunkFile->getNumChunksY())
+        {
+            return nullptr;
+        }
+
+        int chunkIndex = chunkX + (chunkY * m_chunkFile->getNumChunksX());
+
+        if (chunkIndex == m_lastChunkIndex)
+        {
+            m_lastChunk->lastUsed = m_generation;
+
+            return m_lastChunk;
+        }
+
+        auto chunksList_it = m_chunksList.find(chunkIndex);
+
+        if (chunksList_it != m_chunksList.end())
+        {
+            m_lastChunk      = chunksList_it->second.get();
+            m_lastChunkIndex = chunkIndex;
+
+            m_lastChunk->lastUsed = m_generation;
+
+            return m_lastChunk;
+        }
+
+        TileChunkPtr chunk = loadChunk(chunkX, chunkY);
+
+        m_chunksList[chunkIndex] = chunk;
+
+        m_lastChunk      = chunk.get();
+        m_lastChunkIndex = chunkIndex;
+
+        return m_lastChunk;
+    }
+
+    TileChunkPtr loadChunk(int chunkX, int chunkY)
+    {
+        tibia::MemoryTracker::ScopedTag memoryTag(tibia::MemoryTags::tiles);
+
+        TileChunkPtr chunk = std::make_shared<tibia::TileChunk>();
+        chunk->x          = chunkX;
+        chunk->y          = chunkY;
+        chunk->lastUsed   = m_generation;
+        chunk->isModified = false;
+
+        if (m_isEmpty == true || m_chunkFile->readChunk(m_layerIndex, chunkX, chunkY, m_tileIds) == false)
+        {
+            m_tileIds.assign(tibia::TILE_CHUNK_SIZE * tibia::TILE_CHUNK_SIZE, tibia::TILE_NULL);
+        }
+
+        chunk->tiles.resize(m_tileIds.size());
+
+        for (int j = 0; j < tibia::TILE_CHUNK_SIZE; j++)
+        {
+            for (int i = 0; i < tibia::TILE_CHUNK_SIZE; i++)
+            {
+                int tileIndex = i + (j * tibia::TILE_CHUNK_SIZE);
+
+                int x = (chunkX * tibia::TILE_CHUNK_SIZE) + i;
+                int y = (chunkY * tibia::TILE_CHUNK_SIZE) + j;
+
+                int tileId = m_tileIds[tileIndex];
+
+                int tileFlags = tibia::spriteFlags[tileId];
+
+                if (tileFlags & tibia::TileFlags::water && m_type == tibia::TileMapTypes::tiles && m_z == tibia::ZAxis::ground)
+                {
+                    chunk->waterTileIndexes.push_back(tileIndex);
+                }
+
+                int tileOffset = 0;
+
+                if (tileFlags & tibia::TileFlags::offset)
+                {
+                    tileOffset = tibia::TILE_DRAW_OFFSET;
+                }
+
+                if (tileId == tibia::TILE_NULL && m_type == tibia::TileMapTypes::tiles)
+                {
+                    tileFlags |= tibia::TileFlags::null;
+                }
+
+                tibia::Tile* tile = &chunk->tiles[tileIndex];
+                tile->setNumber(x + (y * tibia::MapSize::width));
+                tile->setId(tileId);
+                tile->setOffset(tileOffset);
+                tile->setPosition(sf::Vector2u(x * tibia::TILE_SIZE, y * tibia::TILE_SIZE));
+                tile->setFlags(tileFlags);
+            }
+        }
+
+        return chunk;
+    }
+
     std::string m_name;
 
     int m_type;
 
     int m_z;
 
-    std::vector<int> m_tiles;
+    tibia::TileChunkFile* m_chunkFile;
+
+    int m_layerIndex;
+
+    bool m_isEmpty;
+
+    TileChunkList m_chunksList;
+
+    unsigned int m_generation;
 
-    TileList m_tilesList;
+    tibia::TileChunk* m_lastChunk;
+    int m_lastChunkIndex;
 
-    std::vector<int> m_waterTileNumbers;
+    std::vector<int> m_tileIds;
 
 };
 
@@ -0,0 +1,188 @@
+#ifndef TIBIA_TIMERWHEEL_HPP
+#define TIBIA_TIMERWHEEL_HPP
+
+#include <vector>
+#include <algorithm>
+
+namespace tibia
+{
+
+// hierarchical timer wheel driven by the simulation tick, each level has 64 slots covering 64 times the
+// span of the level below it, timers far in the future wait in a higher level and cascade down as the
+// tick reaches their slot so only the timers that are due are ever touched
+template <typename T>
+class TimerWheel
+{
+
+public:
+
+    static const int NUM_LEVELS = 4;
+
+    static const int SLOT_BITS = 6;
+
+    static const int NUM_SLOTS = 1 << SLOT_BITS;
+
+    static const unsigned int SLOT_MASK = NUM_SLOTS - 1;
+
+    struct Timer
+    {
+        unsigned int tick;
+
+        T value;
+    };
+
+    typedef std::vector<Timer> TimerList;
+
+    TimerWheel()
+    {
+        m_tick = 0;
+
+        m_numTimers = 0;
+    }
+
+    // timers scheduled in the past are due on the next advance
+    void schedule(unsigned int tick, const T& value)
+    {
+        if (tick < m_tick)
+        {
+            tick = m_tick;
+        }
+
+        Timer timer;
+        timer.tick  = tick;
+        timer.value = value;
+
+        insert(timer);
+
+        m_numTimers++;
+    }
+
+    // appends every timer due up to and including the tick in the order they are due
+    void advance(unsigned int tick, TimerList& dueList)
+    {
+        while (m_tick <= tick)
+        {
+            cascade();
+
+            TimerList& slot = m_slotsList[0][m_tick & SLOT_MASK];
+
+            for (auto& timer : slot)
+            {
+                dueList.push_back(timer);
+
+                m_numTimers--;
+            }
+
+            slot.clear();
+
+            m_tick++;
+        }
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < NUM_LEVELS; i++)
+        {
+            for (int j = 0; j < NUM_SLOTS; j++)
+            {
+                m_slotsList[i][j].clear();
+            }
+        }
+
+        m_numTimers = 0;
+    }
+
+    // the wheel only moves forward, resetting it drops every timer
+    void reset(unsigned int tick)
+    {
+        clear();
+
+        m_tick = tick;
+    }
+
+    // appends every pending timer in the order they will be due
+    void getTimers(TimerList& timersList)
+    {
+        typename TimerList::size_type first = timersList.size();
+
+        for (int i = 0; i < NUM_LEVELS; i++)
+        {
+            for (int j = 0; j < NUM_SLOTS; j++)
+            {
+                timersList.insert(timersList.end(), m_slotsList[i][j].begin(), m_slotsList[i][j].end());
+            }
+        }
+
+        // timers due on the same tick share a slot so sorting by tick keeps the order they were scheduled in
+        std::stable_sort
+        (
+            timersList.begin() + first,
+            timersList.end(),
+            [](const Timer& a, const Timer& b)
+            {
+                return a.tick < b.tick;
+            }
+        );
+    }
+
+    unsigned int getTick()
+    {
+        return m_tick;
+    }
+
+    int getNumTimers()
+    {
+        return m_numTimers;
+    }
+
+private:
+
+    void insert(const Timer& timer)
+    {
+        int level = 0;
+
+        while (level < NUM_LEVELS - 1 && (timer.tick >> ((level + 1) * SLOT_BITS)) != (m_tick >> ((level + 1) * SLOT_BITS)))
+        {
+            level++;
+        }
+
+        m_slotsList[level][(timer.tick >> (level * SLOT_BITS)) & SLOT_MASK].push_back(timer);
+    }
+
+    // moves the timers of each level whose slot the tick has just entered down towards level 0,
+    // highest level first so a timer can drop through several levels at once
+    void cascade()
+    {
+        int numLevels = 0;
+
+        while (numLevels < NUM_LEVELS - 1 && (m_tick & ((1u << ((numLevels + 1) * SLOT_BITS)) - 1)) == 0)
+        {
+            numLevels++;
+        }
+
+        for (int level = numLevels; level > 0; level--)
+        {
+            m_cascadeList.clear();
+
+            m_cascadeList.swap(m_slotsList[level][(m_tick >> (level * SLOT_BITS)) & SLOT_MASK]);
+
+            for (auto& timer : m_cascadeList)
+            {
+                insert(timer);
+            }
+        }
+    }
+
+    unsigned int m_tick;
+
+    int m_numTimers;
+
+    TimerList m_slotsList[NUM_LEVELS][NUM_SLOTS];
+
+    TimerList m_cascadeList;
+
+};
+
+}
+
+#endif // TIBIA_TIMERWHEEL_HPP
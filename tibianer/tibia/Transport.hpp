@@ -0,0 +1,318 @@
+#ifndef TIBIA_TRANSPORT_HPP
+#define TIBIA_TRANSPORT_HPP
+
+#include <string>
+#include <deque>
+#include <memory>
+
+#include <SFML/System.hpp>
+#include <SFML/Network.hpp>
+
+namespace tibia
+{
+
+// carries whole messages between a client and the server, messages arrive in the order they were sent
+class Transport
+{
+
+public:
+
+    virtual ~Transport()
+    {
+    }
+
+    virtual bool send(const std::string& message) = 0;
+
+    // false when no whole message is waiting
+    virtual bool receive(std::string& message) = 0;
+
+    virtual bool isConnected() = 0;
+
+    virtual void disconnect() = 0;
+
+};
+
+// both ends live in the same process and share a pair of queues
+class LoopbackTransport : public Transport
+{
+
+public:
+
+    static void createPair(std::shared_ptr<tibia::LoopbackTransport>& transportA, std::shared_ptr<tibia::LoopbackTransport>& transportB)
+    {
+        std::shared_ptr<Channel> channel = std::make_shared<Channel>();
+        channel->isConnected = true;
+
+        transportA = std::shared_ptr<tibia::LoopbackTransport>(new tibia::LoopbackTransport(channel, 0));
+        transportB = std::shared_ptr<tibia::LoopbackTransport>(new tibia::LoopbackTransport(channel, 1));
+    }
+
+    bool send(const std::string& message)
+    {
+        if (m_channel->isConnected == false)
+        {
+            return false;
+        }
+
+        m_channel->messagesList[1 - m_side].push_back(message);
+
+        return true;
+    }
+
+    bool receive(std::string& message)
+    {
+        std::deque<std::string>& messagesList = m_channel->messagesList[m_side];
+
+        if (messagesList.size() == 0)
+        {
+            return false;
+        }
+
+        message.swap(messagesList.front());
+
+        messagesList.pop_front();
+
+        return true;
+    }
+
+    bool isConnected()
+    {
+        return m_channel->isConnected;
+    }
+
+    void disconnect()
+    {
+        m_channel->isConnected = false;
+    }
+
+private:
+
+    struct Channel
+    {
+        // messagesList[side] holds the messages waiting to be received by that side
+        std::deque<std::string> messagesList[2];
+
+        bool isConnected;
+    };
+
+    LoopbackTransport(std::shared_ptr<Channel> channel, int side)
+    {
+        m_channel = channel;
+
+        m_side = side;
+    }
+
+    std::shared_ptr<Channel> m_channel;
+
+    int m_side;
+
+};
+
+// one message per sf::Packet over a non-blocking socket, sf::Packet keeps partially received packets
+// until the rest arrives. a packet the socket could not take whole stays queued and is sent again on
+// the next send or receive, later packets wait behind it so messages stay in order
+class TcpTransport : public Transport
+{
+
+public:
+
+    static const unsigned int SEND_PACKETS_MAX = 1024;
+
+    TcpTransport()
+    {
+        m_socket = std::make_shared<sf::TcpSocket>();
+
+        m_isConnected = false;
+    }
+
+    ~TcpTransport()
+    {
+        disconnect();
+    }
+
+    bool connect(const sf::IpAddress& address, unsigned short port)
+    {
+        if (m_socket->connect(address, port, sf::seconds(5)) != sf::Socket::Done)
+        {
+            return false;
+        }
+
+        setConnected();
+
+        return true;
+    }
+
+    // used by TcpTransportListener once the socket has been accepted
+    void setConnected()
+    {
+        m_socket->setBlocking(false);
+
+        m_isConnected = true;
+    }
+
+    bool send(const std::string& message)
+    {
+        if (m_isConnected == false)
+        {
+            return false;
+        }
+
+        // a peer that stopped reading is dropped instead of queueing without end
+        if (m_sendPacketsList.size() >= SEND_PACKETS_MAX)
+        {
+            disconnect();
+
+            return false;
+        }
+
+        m_sendPacketsList.push_back(sf::Packet());
+        m_sendPacketsList.back().append(message.data(), message.size());
+
+        return sendPackets();
+    }
+
+    bool receive(std::string& message)
+    {
+        if (m_isConnected == false)
+        {
+            return false;
+        }
+
+        if (sendPackets() == false)
+        {
+            return false;
+        }
+
+        sf::Socket::Status status = m_socket->receive(m_packet);
+
+        if (status == sf::Socket::NotReady)
+        {
+            return false;
+        }
+
+        if (status != sf::Socket::Done)
+        {
+            disconnect();
+
+            return false;
+        }
+
+        message.assign(static_cast<const char*>(m_packet.getData()), m_packet.getDataSize());
+
+        return true;
+    }
+
+    bool isConnected()
+    {
+        return m_isConnected;
+    }
+
+    void disconnect()
+    {
+        if (m_isConnected == true)
+        {
+            m_socket->disconnect();
+        }
+
+        m_isConnected = false;
+
+        m_sendPacketsList.clear();
+    }
+
+    sf::TcpSocket* getSocket()
+    {
+        return m_socket.get();
+    }
+
+private:
+
+    // the packet keeps how much of it was sent, so a partial send continues where it stopped.
+    // only a closed or broken socket drops the connection, any other status means try again later
+    bool sendPackets()
+    {
+        while (m_sendPacketsList.size() != 0)
+        {
+            sf::Socket::Status status = m_socket->send(m_sendPacketsList.front());
+
+            if (status == sf::Socket::Done)
+            {
+                m_sendPacketsList.pop_front();
+
+                continue;
+            }
+
+            if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+            {
+                disconnect();
+
+                return false;
+            }
+
+            break;
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<sf::TcpSocket> m_socket;
+
+    sf::Packet m_packet;
+
+    std::deque<sf::Packet> m_sendPacketsList;
+
+    bool m_isConnected;
+
+};
+
+class TcpTransportListener
+{
+
+public:
+
+    // port 0 picks any free port, see getLocalPort
+    bool listen(unsigned short port)
+    {
+        if (m_listener.listen(port) != sf::Socket::Done)
+        {
+            return false;
+        }
+
+        m_listener.setBlocking(false);
+
+        return true;
+    }
+
+    // nullptr when nobody is waiting to connect
+    std::shared_ptr<tibia::TcpTransport> accept()
+    {
+        std::shared_ptr<tibia::TcpTransport> transport = std::make_shared<tibia::TcpTransport>();
+
+        if (m_listener.accept(*transport->getSocket()) != sf::Socket::Done)
+        {
+            return nullptr;
+        }
+
+        transport->setConnected();
+
+        return transport;
+    }
+
+    unsigned short getLocalPort()
+    {
+        return m_listener.getLocalPort();
+    }
+
+    void close()
+    {
+        m_listener.close();
+    }
+
+private:
+
+    sf::TcpListener m_listener;
+
+};
+
+}
+
+#endif // TIBIA_TRANSPORT_HPP